@@ -12,6 +12,29 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
     setWindowTitle("CommandApp");
 
+    // Карта регистров: registermap.json рядом с exe, иначе встроенная
+    QString mapError;
+    regMap = RegisterMap::loadDefault(&mapError);
+    if (!mapError.isEmpty())
+        ui->statusbar->showMessage("Ошибка профиля регистров: " + mapError);
+
+    fieldViews = {{RegisterMap::SpeedMmMin, ui->speedMmMinOut, -1},
+                  {RegisterMap::MoveByX, ui->moveByMmOut, 2},
+                  {RegisterMap::MoveToX, ui->moveToMmOut, 2},
+                  {RegisterMap::EncoderPulses, ui->encoderPulsesOut, -1},
+                  {RegisterMap::MotorRevs, ui->motorScrewRatioOut, -1},
+                  {RegisterMap::ScrewMmRev, ui->screwPitchOut, -1},
+                  {RegisterMap::SensorRange, ui->sensorRangeKnOut, 2},
+                  {RegisterMap::Sensitivity, ui->sensorSensitivityOut, -1},
+                  {RegisterMap::MaxError, ui->controlErrorMmOut, 4},
+                  {RegisterMap::TestSpeed, ui->testSpeedOut, -1},
+                  {RegisterMap::ManualSpeed, ui->manualSpeedOut, -1},
+                  {RegisterMap::Position, ui->currentPositionOut, 2},
+                  {RegisterMap::Load, ui->currentLoadOut, 2},
+                  {RegisterMap::TestTime, ui->testTimeOut, 1},
+                  {RegisterMap::Elongation, ui->testLengthOut, 2},
+                  {RegisterMap::MaxLoad, ui->maxLoadOut, 2}};
+
     // ===============================================
     // НАСТРОЙКА ВАЛИДАТОРОВ (ФИЛЬТРЫ ВВОДА)
     // ===============================================
@@ -155,93 +178,25 @@ void MainWindow::onReadReady()
         QString id = reply->property("ID").toString();
         QString type = reply->property("Type").toString();
 
-        if (type == "Holding") {
-            // КОМАНДЫ
-            if (id == "CMD" && unit.valueCount() >= 1) {
-                setCommandUIFromWord(unit.value(0));
-            }
-            // АВТО ОПРОС ПАРАМЕТРОВ (Registers 2-16)
-            else if (id == "AllParams") {
-                QVector<quint16> v = unit.values();
-                if (v.size() > 0)
-                    ui->speedMmMinOut->setText(QString::number((short) v[0]));
-                if (v.size() > 2)
-                    ui->moveByMmOut->setText(QString::number(registersToFloat(v.mid(1, 2)), 'f', 2));
-                if (v.size() > 4)
-                    ui->moveToMmOut->setText(QString::number(registersToFloat(v.mid(3, 2)), 'f', 2));
-                if (v.size() > 5)
-                    ui->encoderPulsesOut->setText(QString::number((short) v[5]));
-                if (v.size() > 6)
-                    ui->motorScrewRatioOut->setText(QString::number((short) v[6]));
-                if (v.size() > 7)
-                    ui->screwPitchOut->setText(QString::number((short) v[7]));
-                if (v.size() > 9)
-                    ui->sensorRangeKnOut->setText(
-                        QString::number(registersToFloat(v.mid(8, 2)), 'f', 2));
-                if (v.size() > 10)
-                    ui->sensorSensitivityOut->setText(QString::number((short) v[10]));
-                if (v.size() > 12)
-                    ui->controlErrorMmOut->setText(
-                        QString::number(registersToFloat(v.mid(11, 2)), 'f', 4));
-                if (v.size() > 13)
-                    ui->testSpeedOut->setText(QString::number((short) v[13]));
-                if (v.size() > 14)
-                    ui->manualSpeedOut->setText(QString::number((short) v[14]));
+        // КОМАНДЫ
+        if (type == "Holding" && id == "CMD" && unit.valueCount() >= 1) {
+            setCommandUIFromWord(unit.value(0));
+        }
+        // АВТО ОПРОС ПАРАМЕТРОВ И ИНДИКАТОРОВ (блок с адреса Start)
+        else if (id == "AllParams" || id == "AllIndicators") {
+            const QVector<quint16> v = unit.values();
+            const bool holding = type == "Holding";
+            for (const FieldView &view : fieldViews) {
+                if ((RegisterMap::tableOf(view.field) == RegisterMap::Holding) == holding)
+                    showField(view, v, reply->property("Start").toInt());
             }
-            // ОДИНОЧНЫЕ ОТВЕТЫ
-            else if (id == "speedMmMin")
-                ui->speedMmMinOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "moveByMm")
-                ui->moveByMmOut->setText(QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "moveToMm")
-                ui->moveToMmOut->setText(QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "encoderPulses")
-                ui->encoderPulsesOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "motorScrewRatio")
-                ui->motorScrewRatioOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "screwPitch")
-                ui->screwPitchOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "sensorRangeKn")
-                ui->sensorRangeKnOut->setText(
-                    QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "sensorSensitivity")
-                ui->sensorSensitivityOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "controlErrorMm")
-                ui->controlErrorMmOut->setText(
-                    QString::number(registersToFloat(unit.values()), 'f', 4));
-            else if (id == "testSpeed")
-                ui->testSpeedOut->setText(QString::number((short) unit.value(0)));
-            else if (id == "manualSpeed")
-                ui->manualSpeedOut->setText(QString::number((short) unit.value(0)));
-
-        } else if (type == "Input") {
-            // АВТО ОПРОС ИНДИКАТОРОВ (Registers 0-9)
-            if (id == "AllIndicators") {
-                QVector<quint16> v = unit.values();
-                if (v.size() >= 10) {
-                    ui->currentPositionOut->setText(
-                        QString::number(registersToFloat(v.mid(0, 2)), 'f', 2));
-                    ui->currentLoadOut->setText(
-                        QString::number(registersToFloat(v.mid(2, 2)), 'f', 2));
-                    ui->testTimeOut->setText(QString::number(registersToFloat(v.mid(4, 2)), 'f', 1));
-                    ui->testLengthOut->setText(
-                        QString::number(registersToFloat(v.mid(6, 2)), 'f', 2));
-                    ui->maxLoadOut->setText(QString::number(registersToFloat(v.mid(8, 2)), 'f', 2));
-                }
+        }
+        // ОДИНОЧНЫЕ ОТВЕТЫ (ID - имя поля карты)
+        else {
+            for (const FieldView &view : fieldViews) {
+                if (id == QLatin1String(RegisterMap::fieldName(view.field)))
+                    showField(view, unit.values(), regMap.address(view.field));
             }
-            // ОДИНОЧНЫЕ
-            else if (id == "currentPosition")
-                ui->currentPositionOut->setText(
-                    QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "currentLoad")
-                ui->currentLoadOut->setText(
-                    QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "testTime")
-                ui->testTimeOut->setText(QString::number(registersToFloat(unit.values()), 'f', 1));
-            else if (id == "testLength")
-                ui->testLengthOut->setText(QString::number(registersToFloat(unit.values()), 'f', 2));
-            else if (id == "maxLoad")
-                ui->maxLoadOut->setText(QString::number(registersToFloat(unit.values()), 'f', 2));
         }
     }
     reply->deleteLater();
@@ -259,7 +214,7 @@ void MainWindow::on_autoReadCommandsCheckBox_toggled(bool checked)
 }
 void MainWindow::processAutoReadCommands()
 {
-    readHoldingRegister(0, 1, "CMD");
+    readHoldingRegister(regMap.address(RegisterMap::Control), 1, "CMD");
 }
 
 void MainWindow::on_autoReadParamsCheckBox_toggled(bool checked)
@@ -271,14 +226,17 @@ void MainWindow::on_autoReadParamsCheckBox_toggled(bool checked)
 }
 void MainWindow::processAutoReadParams()
 {
-    // Читаем с адреса 2 по 16 (всего 15 регистров)
-    if (modbusDevice->state() == QModbusDevice::ConnectedState) {
+    // Весь блок параметров одним запросом (участок из карты)
+    const RegisterMap::Span block = regMap.paramSpan();
+    if (modbusDevice->state() == QModbusDevice::ConnectedState && block.isValid()) {
         if (auto *reply = modbusDevice->sendReadRequest(
-                QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 2, 15), ui->slaveIdIn->value())) {
+                QModbusDataUnit(QModbusDataUnit::HoldingRegisters, block.start, block.count),
+                ui->slaveIdIn->value())) {
             if (!reply->isFinished()) {
                 connect(reply, &QModbusReply::finished, this, &MainWindow::onReadReady);
                 reply->setProperty("ID", "AllParams");
                 reply->setProperty("Type", "Holding");
+                reply->setProperty("Start", block.start);
             } else
                 delete reply;
         }
@@ -294,15 +252,21 @@ void MainWindow::on_autoReadIndicatorsCheckBox_toggled(bool checked)
 }
 void MainWindow::processAutoReadIndicators()
 {
-    // Читаем с адреса 0 по 9 (всего 10 регистров = 5 float)
-    if (modbusDevice->state() == QModbusDevice::ConnectedState) {
-        if (auto *reply
-            = modbusDevice->sendReadRequest(QModbusDataUnit(QModbusDataUnit::InputRegisters, 0, 10),
-                                            ui->slaveIdIn->value())) {
+    // Все индикаторы одним запросом (участок из карты)
+    const RegisterMap::Span block = regMap.span({RegisterMap::Position,
+                                                 RegisterMap::Load,
+                                                 RegisterMap::TestTime,
+                                                 RegisterMap::Elongation,
+                                                 RegisterMap::MaxLoad});
+    if (modbusDevice->state() == QModbusDevice::ConnectedState && block.isValid()) {
+        if (auto *reply = modbusDevice->sendReadRequest(
+                QModbusDataUnit(QModbusDataUnit::InputRegisters, block.start, block.count),
+                ui->slaveIdIn->value())) {
             if (!reply->isFinished()) {
                 connect(reply, &QModbusReply::finished, this, &MainWindow::onReadReady);
                 reply->setProperty("ID", "AllIndicators");
                 reply->setProperty("Type", "Input");
+                reply->setProperty("Start", block.start);
             } else
                 delete reply;
         }
@@ -314,65 +278,53 @@ void MainWindow::processAutoReadIndicators()
 // ==========================================
 quint16 MainWindow::getCommandWordFromUI()
 {
+    // Номер бита каждой команды - из карты; команда без бита не передается
     quint16 word = 0;
-    if (ui->startTestingIn->isChecked())
-        word |= (1 << 0);
-    if (ui->stopIn->isChecked())
-        word |= (1 << 1);
-    if (ui->moveTraverseUpIn->isChecked())
-        word |= (1 << 2);
-    if (ui->moveTraverseDownIn->isChecked())
-        word |= (1 << 3);
-    if (ui->startMmModeIn->isChecked())
-        word |= (1 << 4);
-    if (ui->stopMmModeIn->isChecked())
-        word |= (1 << 5);
-    if (ui->moveUpMmModeIn->isChecked())
-        word |= (1 << 6);
-    if (ui->moveDownMmModeIn->isChecked())
-        word |= (1 << 7);
-    if (ui->useServoDriveIn->isChecked())
-        word |= (1 << 8);
-    if (ui->useTopGripIn->isChecked())
-        word |= (1 << 9);
-    if (ui->compressionModeIn->isChecked())
-        word |= (1 << 10);
+    auto put = [&](bool on, RegisterMap::Bit b) {
+        if (on && regMap.bit(b) >= 0)
+            word |= (1 << regMap.bit(b));
+    };
+    put(ui->startTestingIn->isChecked(), RegisterMap::BitStartTest);
+    put(ui->stopIn->isChecked(), RegisterMap::BitStop);
+    put(ui->moveTraverseUpIn->isChecked(), RegisterMap::BitLiftTraverse);
+    put(ui->moveTraverseDownIn->isChecked(), RegisterMap::BitLowerTraverse);
+    put(ui->startMmModeIn->isChecked(), RegisterMap::BitStartMMMode);
+    put(ui->stopMmModeIn->isChecked(), RegisterMap::BitStopMMMode);
+    put(ui->moveUpMmModeIn->isChecked(), RegisterMap::BitUpMMMode);
+    put(ui->moveDownMmModeIn->isChecked(), RegisterMap::BitDownMMMode);
+    put(ui->useServoDriveIn->isChecked(), RegisterMap::BitServoAsync);
+    put(ui->useTopGripIn->isChecked(), RegisterMap::BitClamp);
+    put(ui->compressionModeIn->isChecked(), RegisterMap::BitTensileCompress);
     return word;
 }
 
 void MainWindow::setCommandUIFromWord(quint16 word)
 {
-    ui->startTestingOut->setChecked(word & (1 << 0));
-    ui->stopOut->setChecked(word & (1 << 1));
-    ui->moveTraverseUpOut->setChecked(word & (1 << 2));
-    ui->moveTraverseDownOut->setChecked(word & (1 << 3));
-    ui->startMmModeOut->setChecked(word & (1 << 4));
-    ui->stopMmModeOut->setChecked(word & (1 << 5));
-    ui->moveUpMmModeOut->setChecked(word & (1 << 6));
-    ui->moveDownMmModeOut->setChecked(word & (1 << 7));
-    ui->useServoDriveOut->setChecked(word & (1 << 8));
-    ui->useTopGripOut->setChecked(word & (1 << 9));
-    ui->compressionModeOut->setChecked(word & (1 << 10));
-}
-
-QVector<quint16> MainWindow::floatToRegisters(float value)
-{
-    QVector<quint16> regs;
-    quint32 data;
-    memcpy(&data, &value, sizeof(float));
-    regs.append(data >> 16);
-    regs.append(data & 0xFFFF);
-    return regs;
-}
-
-float MainWindow::registersToFloat(const QVector<quint16> &values)
-{
-    if (values.size() < 2)
-        return 0.0f;
-    quint32 data = (values[0] << 16) | values[1];
-    float value;
-    memcpy(&value, &data, sizeof(float));
-    return value;
+    auto get = [&](RegisterMap::Bit b) { return regMap.bit(b) >= 0 && (word >> regMap.bit(b)) & 1; };
+    ui->startTestingOut->setChecked(get(RegisterMap::BitStartTest));
+    ui->stopOut->setChecked(get(RegisterMap::BitStop));
+    ui->moveTraverseUpOut->setChecked(get(RegisterMap::BitLiftTraverse));
+    ui->moveTraverseDownOut->setChecked(get(RegisterMap::BitLowerTraverse));
+    ui->startMmModeOut->setChecked(get(RegisterMap::BitStartMMMode));
+    ui->stopMmModeOut->setChecked(get(RegisterMap::BitStopMMMode));
+    ui->moveUpMmModeOut->setChecked(get(RegisterMap::BitUpMMMode));
+    ui->moveDownMmModeOut->setChecked(get(RegisterMap::BitDownMMMode));
+    ui->useServoDriveOut->setChecked(get(RegisterMap::BitServoAsync));
+    ui->useTopGripOut->setChecked(get(RegisterMap::BitClamp));
+    ui->compressionModeOut->setChecked(get(RegisterMap::BitTensileCompress));
+}
+
+void MainWindow::showField(const FieldView &view, const QVector<quint16> &values, int base)
+{
+    const RegisterMap::Entry &e = regMap.entry(view.field);
+    const int offset = e.address - base;
+    if (!e.isValid() || offset < 0 || offset + e.size() > values.size())
+        return;
+    const double value = regMap.decode(view.field, values.constData() + offset);
+    if (view.precision < 0)
+        view.out->setText(QString::number((short) qint32(value)));
+    else
+        view.out->setText(QString::number(value, 'f', view.precision));
 }
 
 void MainWindow::writeSingleRegister(int address, quint16 value)
@@ -386,16 +338,31 @@ void MainWindow::writeSingleRegister(int address, quint16 value)
     }
 }
 
-void MainWindow::writeFloatRegister(int address, float value)
+void MainWindow::writeField(RegisterMap::Field field, double value)
 {
-    if (modbusDevice->state() != QModbusDevice::ConnectedState)
+    const RegisterMap::Entry &e = regMap.entry(field);
+    if (modbusDevice->state() != QModbusDevice::ConnectedState || !e.isValid())
         return;
-    QModbusDataUnit writeUnit(QModbusDataUnit::HoldingRegisters, address, floatToRegisters(value));
+    QVector<quint16> regs(e.size());
+    regMap.encode(field, value, regs.data());
+    QModbusDataUnit writeUnit(QModbusDataUnit::HoldingRegisters, e.address, regs);
     if (auto *reply = modbusDevice->sendWriteRequest(writeUnit, ui->slaveIdIn->value())) {
         connect(reply, &QModbusReply::finished, reply, &QModbusReply::deleteLater);
     }
 }
 
+void MainWindow::readField(RegisterMap::Field field)
+{
+    const RegisterMap::Entry &e = regMap.entry(field);
+    if (!e.isValid())
+        return;
+    const QString id = QString::fromLatin1(RegisterMap::fieldName(field));
+    if (RegisterMap::tableOf(field) == RegisterMap::Holding)
+        readHoldingRegister(e.address, e.size(), id);
+    else
+        readInputRegister(e.address, e.size(), id);
+}
+
 void MainWindow::readHoldingRegister(int address, int count, const QString &id)
 {
     if (modbusDevice->state() != QModbusDevice::ConnectedState)
@@ -435,129 +402,129 @@ void MainWindow::readInputRegister(int address, int count, const QString &id)
 // ==========================================
 void MainWindow::on_writeAllCommandsBtn_clicked()
 {
-    writeSingleRegister(0, getCommandWordFromUI());
+    writeSingleRegister(regMap.address(RegisterMap::Control), getCommandWordFromUI());
 }
 void MainWindow::on_readAllCommandsBtn_clicked()
 {
-    readHoldingRegister(0, 1, "CMD");
+    readHoldingRegister(regMap.address(RegisterMap::Control), 1, "CMD");
 }
 
 void MainWindow::on_speedMmMinWriteBtn_clicked()
 {
-    writeSingleRegister(2, ui->speedMmMinIn->text().toUShort());
+    writeField(RegisterMap::SpeedMmMin, ui->speedMmMinIn->text().toUShort());
 }
 void MainWindow::on_speedMmMinReadBtn_clicked()
 {
-    readHoldingRegister(2, 1, "speedMmMin");
+    readField(RegisterMap::SpeedMmMin);
 }
 
 void MainWindow::on_moveByMmWriteBtn_clicked()
 {
-    writeFloatRegister(3, ui->moveByMmIn->text().toFloat());
+    writeField(RegisterMap::MoveByX, ui->moveByMmIn->text().toFloat());
 }
 void MainWindow::on_moveByMmReadBtn_clicked()
 {
-    readHoldingRegister(3, 2, "moveByMm");
+    readField(RegisterMap::MoveByX);
 }
 
 void MainWindow::on_moveToMmWriteBtn_clicked()
 {
-    writeFloatRegister(5, ui->moveToMmIn->text().toFloat());
+    writeField(RegisterMap::MoveToX, ui->moveToMmIn->text().toFloat());
 }
 void MainWindow::on_moveToMmReadBtn_clicked()
 {
-    readHoldingRegister(5, 2, "moveToMm");
+    readField(RegisterMap::MoveToX);
 }
 
 void MainWindow::on_encoderPulsesWriteBtn_clicked()
 {
-    writeSingleRegister(7, ui->encoderPulsesIn->text().toUShort());
+    writeField(RegisterMap::EncoderPulses, ui->encoderPulsesIn->text().toUShort());
 }
 void MainWindow::on_encoderPulsesReadBtn_clicked()
 {
-    readHoldingRegister(7, 1, "encoderPulses");
+    readField(RegisterMap::EncoderPulses);
 }
 
 void MainWindow::on_motorScrewRatioWriteBtn_clicked()
 {
-    writeSingleRegister(8, ui->motorScrewRatioIn->text().toUShort());
+    writeField(RegisterMap::MotorRevs, ui->motorScrewRatioIn->text().toUShort());
 }
 void MainWindow::on_motorScrewRatioReadBtn_clicked()
 {
-    readHoldingRegister(8, 1, "motorScrewRatio");
+    readField(RegisterMap::MotorRevs);
 }
 
 void MainWindow::on_screwPitchWriteBtn_clicked()
 {
-    writeSingleRegister(9, ui->screwPitchIn->text().toUShort());
+    writeField(RegisterMap::ScrewMmRev, ui->screwPitchIn->text().toUShort());
 }
 void MainWindow::on_screwPitchReadBtn_clicked()
 {
-    readHoldingRegister(9, 1, "screwPitch");
+    readField(RegisterMap::ScrewMmRev);
 }
 
 void MainWindow::on_sensorRangeKnWriteBtn_clicked()
 {
-    writeFloatRegister(10, ui->sensorRangeKnIn->text().toFloat());
+    writeField(RegisterMap::SensorRange, ui->sensorRangeKnIn->text().toFloat());
 }
 void MainWindow::on_sensorRangeKnReadBtn_clicked()
 {
-    readHoldingRegister(10, 2, "sensorRangeKn");
+    readField(RegisterMap::SensorRange);
 }
 
 void MainWindow::on_sensorSensitivityWriteBtn_clicked()
 {
-    writeSingleRegister(12, ui->sensorSensitivityIn->text().toUShort());
+    writeField(RegisterMap::Sensitivity, ui->sensorSensitivityIn->text().toUShort());
 }
 void MainWindow::on_sensorSensitivityReadBtn_clicked()
 {
-    readHoldingRegister(12, 1, "sensorSensitivity");
+    readField(RegisterMap::Sensitivity);
 }
 
 void MainWindow::on_controlErrorMmWriteBtn_clicked()
 {
-    writeFloatRegister(13, ui->controlErrorMmIn->text().toFloat());
+    writeField(RegisterMap::MaxError, ui->controlErrorMmIn->text().toFloat());
 }
 void MainWindow::on_controlErrorMmReadBtn_clicked()
 {
-    readHoldingRegister(13, 2, "controlErrorMm");
+    readField(RegisterMap::MaxError);
 }
 
 void MainWindow::on_testSpeedWriteBtn_clicked()
 {
-    writeSingleRegister(15, ui->testSpeedIn->text().toUShort());
+    writeField(RegisterMap::TestSpeed, ui->testSpeedIn->text().toUShort());
 }
 void MainWindow::on_testSpeedReadBtn_clicked()
 {
-    readHoldingRegister(15, 1, "testSpeed");
+    readField(RegisterMap::TestSpeed);
 }
 
 void MainWindow::on_manualSpeedWriteBtn_clicked()
 {
-    writeSingleRegister(16, ui->manualSpeedIn->text().toUShort());
+    writeField(RegisterMap::ManualSpeed, ui->manualSpeedIn->text().toUShort());
 }
 void MainWindow::on_manualSpeedReadBtn_clicked()
 {
-    readHoldingRegister(16, 1, "manualSpeed");
+    readField(RegisterMap::ManualSpeed);
 }
 
 void MainWindow::on_currentPositionReadBtn_clicked()
 {
-    readInputRegister(0, 2, "currentPosition");
+    readField(RegisterMap::Position);
 }
 void MainWindow::on_currentLoadReadBtn_clicked()
 {
-    readInputRegister(2, 2, "currentLoad");
+    readField(RegisterMap::Load);
 }
 void MainWindow::on_testTimeReadBtn_clicked()
 {
-    readInputRegister(4, 2, "testTime");
+    readField(RegisterMap::TestTime);
 }
 void MainWindow::on_testLengthReadBtn_clicked()
 {
-    readInputRegister(6, 2, "testLength");
+    readField(RegisterMap::Elongation);
 }
 void MainWindow::on_maxLoadReadBtn_clicked()
 {
-    readInputRegister(8, 2, "maxLoad");
+    readField(RegisterMap::MaxLoad);
 }
@@ -6,6 +6,9 @@
 #include <QModbusTcpClient>
 #include <QTimer>
 #include <QVector>
+#include "RegisterMap.h"
+
+class QLineEdit;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -82,15 +85,27 @@ private:
     QTimer *timerParams;
     QTimer *timerIndicators;
 
+    // Карта регистров (общий профиль с EvoLiteApp)
+    RegisterMap regMap;
+
+    // Поле карты -> поле вывода (precision < 0 - целое со знаком)
+    struct FieldView
+    {
+        RegisterMap::Field field;
+        QLineEdit *out;
+        int precision;
+    };
+    QVector<FieldView> fieldViews;
+
     // Вспомогательные функции
     quint16 getCommandWordFromUI();
     void setCommandUIFromWord(quint16 word);
-
-    QVector<quint16> floatToRegisters(float value);
-    float registersToFloat(const QVector<quint16> &values);
+    // Показать поле из блока values, прочитанного с адреса base
+    void showField(const FieldView &view, const QVector<quint16> &values, int base);
 
     void writeSingleRegister(int address, quint16 value);
-    void writeFloatRegister(int address, float value);
+    void writeField(RegisterMap::Field field, double value);
+    void readField(RegisterMap::Field field);
     void readHoldingRegister(int address, int count, const QString &id);
     void readInputRegister(int address, int count, const QString &id);
 };
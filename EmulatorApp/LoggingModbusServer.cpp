@@ -36,6 +36,17 @@ QModbusResponse LoggingModbusServer::processRequest(const QModbusPdu &request)
         request.decodeData(&startAddr, &count);
         hasDetails = true;
         break;
+    case QModbusPdu::MaskWriteRegister: {
+        // Атомарная смена битов командного слова (обрабатывает базовый сервер)
+        quint16 andMask = 0;
+        quint16 orMask = 0;
+        request.decodeData(&startAddr, &andMask, &orMask);
+        emit logMessage(QString("REQ: Mask Write (22) | Addr: %1 | AND: 0x%2 | OR: 0x%3")
+                            .arg(startAddr)
+                            .arg(andMask, 4, 16, QChar('0'))
+                            .arg(orMask, 4, 16, QChar('0')));
+        return QModbusTcpServer::processRequest(request);
+    }
     default:
         funcName = QString("Func 0x%1").arg(request.functionCode(), 2, 16, QChar('0'));
     }
@@ -13,6 +13,18 @@ MainWindow::MainWindow(QWidget *parent)
 {
     setupUi();
 
+    // Карта регистров: registermap.json рядом с exe, иначе встроенная v2 -
+    // эмулятор отдает статус, эхо команд и FIFO
+    QString mapError;
+    regMap = RegisterMap::loadDefault(&mapError, 2);
+    if (!mapError.isEmpty())
+        onLogMessage("Ошибка профиля регистров: " + mapError);
+    onLogMessage("Карта регистров: " + regMap.name());
+    tableHolding->setRowCount(regMap.tableSize(RegisterMap::Holding));
+    const RegisterMap::Span snap = regMap.span(RegisterMap::SnapshotFields.data(),
+                                               int(RegisterMap::SnapshotFields.size()));
+    tableInput->setRowCount(snap.start + snap.count);
+
     // Создаем наш кастомный сервер с логированием
     modbusDevice = new LoggingModbusServer(this);
     connect(modbusDevice, &LoggingModbusServer::logMessage, this, &MainWindow::onLogMessage);
@@ -20,8 +32,9 @@ MainWindow::MainWindow(QWidget *parent)
     // !!! ВАЖНО: Подключаем сигнал записи для мгновенной реакции на кнопки !!!
     connect(modbusDevice, &QModbusServer::dataWritten, this, &MainWindow::handleDataWritten);
 
-    // Таймер физики процесса (100 мс = 10 Гц)
+    // Таймер физики процесса (10 мс; внутри - подшаги с частотой FIFO)
     simTimer = new QTimer(this);
+    simTimer->setTimerType(Qt::PreciseTimer);
     connect(simTimer, &QTimer::timeout, this, &MainWindow::updateSimulation);
 }
 
@@ -80,7 +93,7 @@ void MainWindow::setupUi()
     tableHolding->setColumnWidth(0, 40);
     tableHolding->setColumnWidth(1, 130);
 
-    tableInput = new QTableWidget(10, 2);
+    tableInput = new QTableWidget(12, 2);
     tableInput->setHorizontalHeaderLabels({"Addr", "Input (RO)"});
     tableInput->setColumnWidth(0, 40);
     tableInput->setColumnWidth(1, 130);
@@ -108,12 +121,21 @@ void MainWindow::onBtnStartClicked()
     if (!modbusDevice)
         return;
 
-    // Настраиваем карту памяти
-    QModbusDataUnitMap regMap;
-    regMap.insert(QModbusDataUnit::HoldingRegisters, {QModbusDataUnit::HoldingRegisters, 0, 50});
-    regMap.insert(QModbusDataUnit::InputRegisters, {QModbusDataUnit::InputRegisters, 0, 50});
-
-    modbusDevice->setMap(regMap);
+    // Настраиваем карту памяти: все поля профиля + кольцо FIFO
+    int inputSize = regMap.tableSize(RegisterMap::Input);
+    if (regMap.has(RegisterMap::FifoHead))
+        inputSize = qMax(inputSize,
+                         regMap.address(RegisterMap::FifoHead) + FIFO_HEADER_REGS
+                             + FIFO_DEPTH * FIFO_SLOT_REGS);
+    QModbusDataUnitMap memMap;
+    memMap.insert(QModbusDataUnit::HoldingRegisters,
+                  {QModbusDataUnit::HoldingRegisters,
+                   0,
+                   quint16(qMax(50, regMap.tableSize(RegisterMap::Holding)))});
+    memMap.insert(QModbusDataUnit::InputRegisters,
+                  {QModbusDataUnit::InputRegisters, 0, quint16(inputSize)});
+
+    modbusDevice->setMap(memMap);
     modbusDevice->setServerAddress(sbSlaveId->value());
     modbusDevice->setConnectionParameter(QModbusDevice::NetworkAddressParameter, leIp->text());
     modbusDevice->setConnectionParameter(QModbusDevice::NetworkPortParameter, sbPort->value());
@@ -135,25 +157,33 @@ void MainWindow::onBtnStartClicked()
         maxLoad = 0.0f;
         startPos = 0.0f;
         isTestRunning = false;
+        fifoSeq = 0;
+        fifoBudget = 0.0f;
 
         // --- 2. СБРОС МАТЕМАТИЧЕСКОЙ МОДЕЛИ ---
         isoEmulator.reset(0.0f);
 
         // --- 3. ЗАПИСЬ НУЛЕЙ В MODBUS (Input Registers) ---
         // Чтобы клиент сразу увидел чистое состояние
-        setInputFloat(I_POS, 0.0f);
-        setInputFloat(I_LOAD, 0.0f);
-        setInputFloat(I_TIME, 0.0f);
-        setInputFloat(I_ELONGATION, 0.0f);
-        setInputFloat(I_MAX_LOAD, 0.0f);
+        setInputField(RegisterMap::Position, 0.0);
+        setInputField(RegisterMap::Load, 0.0);
+        setInputField(RegisterMap::TestTime, 0.0);
+        setInputField(RegisterMap::Elongation, 0.0);
+        setInputField(RegisterMap::MaxLoad, 0.0);
 
         // --- 4. УСТАНОВКА НАСТРОЕК ПО УМОЛЧАНИЮ (Holding Registers) ---
-        setHoldingInt(H_TEST_SPEED, 50);    // 50 мм/мин
-        setHoldingInt(H_MANUAL_SPEED, 200); // 200 мм/мин
-        setHoldingInt(H_CMD, 0);            // Сброс командного слова
+        if (regMap.has(RegisterMap::TestSpeed))
+            setHoldingInt(regMap.address(RegisterMap::TestSpeed), 50); // 50 мм/мин
+        if (regMap.has(RegisterMap::ManualSpeed))
+            setHoldingInt(regMap.address(RegisterMap::ManualSpeed), 200); // 200 мм/мин
+        setHoldingInt(regMap.address(RegisterMap::Control), 0); // Сброс командного слова
+        publishStatus(0);
+        if (regMap.has(RegisterMap::FifoRate)) // FIFO выключен, пока клиент не включит
+            setHoldingInt(regMap.address(RegisterMap::FifoRate), 0);
+        publishFifoHeader(0);
 
         // Запуск таймера физики
-        simTimer->start(100);
+        simTimer->start(SIM_TICK_MS);
 
         onLogMessage("СЕРВЕР ЗАПУЩЕН. Память очищена.");
     } else {
@@ -185,20 +215,21 @@ void MainWindow::onLogMessage(const QString &msg)
 // --- МГНОВЕННАЯ ОБРАБОТКА КОМАНД ---
 void MainWindow::handleDataWritten(QModbusDataUnit::RegisterType type, int address, int size)
 {
-    // Нас интересуют только Holding Register 0 (Команды)
+    // Нас интересует только командное слово (Holding)
     if (type != QModbusDataUnit::HoldingRegisters)
         return;
 
-    // Проверяем, попал ли адрес 0 в диапазон записи
-    bool cmdRegisterChanged = (address <= H_CMD) && (address + size > H_CMD);
+    // Проверяем, попал ли адрес командного слова в диапазон записи
+    const int cmdAddr = regMap.address(RegisterMap::Control);
+    bool cmdRegisterChanged = (address <= cmdAddr) && (address + size > cmdAddr);
 
     if (cmdRegisterChanged) {
-        quint16 cmd = getHoldingInt(H_CMD);
+        quint16 cmd = getHoldingInt(cmdAddr);
 
         // Разбираем биты
-        bool bStart = getBit(cmd, 0);
-        bool bStop = getBit(cmd, 1);
-        if (getBit(cmd, 5))
+        bool bStart = cmdBit(cmd, RegisterMap::BitStartTest);
+        bool bStop = cmdBit(cmd, RegisterMap::BitStop);
+        if (cmdBit(cmd, RegisterMap::BitStopMMMode))
             bStop = true; // Доп. стоп
 
         // 1. ЛОГИКА СТОП
@@ -232,12 +263,15 @@ void MainWindow::handleDataWritten(QModbusDataUnit::RegisterType type, int addre
 
                 // --- ПРИНУДИТЕЛЬНОЕ ОБНУЛЕНИЕ РЕГИСТРОВ ---
                 // Чтобы клиент мгновенно увидел сброс графиков
-                setInputFloat(I_TIME, 0.0f);
-                setInputFloat(I_ELONGATION, 0.0f);
-                setInputFloat(I_MAX_LOAD, 0.0f);
-                setInputFloat(I_LOAD, 0.0f);
+                setInputField(RegisterMap::TestTime, 0.0);
+                setInputField(RegisterMap::Elongation, 0.0);
+                setInputField(RegisterMap::MaxLoad, 0.0);
+                setInputField(RegisterMap::Load, 0.0);
             }
         }
+
+        // Подтверждаем прием только после обработки: клиент меряет задержку до эха
+        publishStatus(cmd);
     }
 }
 
@@ -248,21 +282,62 @@ void MainWindow::updateSimulation()
         return;
 
     // Читаем текущие кнопки для ручного режима (удержание)
-    quint16 cmd = getHoldingInt(H_CMD);
-    bool bUp = getBit(cmd, 2);
-    bool bDown = getBit(cmd, 3);
-    bool bStop = getBit(cmd, 1) || getBit(cmd, 5);
-
-    if (bStop)
+    quint16 cmd = getHoldingInt(regMap.address(RegisterMap::Control));
+    if (cmdBit(cmd, RegisterMap::BitStop) || cmdBit(cmd, RegisterMap::BitStopMMMode))
         isTestRunning = false;
 
-    float dt = 0.1f; // 100ms
+    const float tick = SIM_TICK_MS / 1000.0f;
+    const quint16 rate = regMap.has(RegisterMap::FifoHead)
+                             ? qMin<quint16>(quint16(getHoldingField(RegisterMap::FifoRate)),
+                                             FIFO_MAX_RATE)
+                             : 0;
+
+    if (rate == 0) {
+        stepPhysics(tick, cmd);
+        fifoBudget = 0.0f;
+    } else {
+        // Модель считается с шагом отсчета FIFO, каждый шаг - отдельный слот.
+        // Дробный остаток переносится в следующий тик (например, 250 Гц = 2.5 на тик).
+        const float dt = 1.0f / rate;
+        fifoBudget += tick * rate;
+        while (fifoBudget >= 1.0f) {
+            fifoBudget -= 1.0f;
+            stepPhysics(dt, cmd);
+            pushFifoSample();
+        }
+    }
+    publishFifoHeader(rate);
+    publishSnapshot();
+    publishStatus(cmd);
+
+    // Логирование фаз (опционально)
+    if (isTestRunning && cmbSimType->currentIndex() == 1) {
+        static QString lastPh;
+        QString ph = isoEmulator.getCurrentPhaseName();
+        if (!ph.isEmpty() && ph != lastPh) {
+            // onLogMessage("Фаза: " + ph); // Можно раскомментировать
+            lastPh = ph;
+        }
+    }
+
+    // Таблицы - 10 раз в секунду, как и раньше
+    if (++tableDivider >= 100 / SIM_TICK_MS) {
+        tableDivider = 0;
+        updateTables();
+    }
+}
+
+void MainWindow::stepPhysics(float dt, quint16 cmd)
+{
+    bool bUp = cmdBit(cmd, RegisterMap::BitLiftTraverse);
+    bool bDown = cmdBit(cmd, RegisterMap::BitLowerTraverse);
+    bool bStop = cmdBit(cmd, RegisterMap::BitStop) || cmdBit(cmd, RegisterMap::BitStopMMMode);
 
     if (isTestRunning) {
         // === РЕЖИМ ИСПЫТАНИЯ ===
         testTime += dt;
 
-        float speed = (float) getHoldingInt(H_TEST_SPEED);
+        float speed = (float) getHoldingField(RegisterMap::TestSpeed);
         if (speed < 0.1f)
             speed = 50.0f;
 
@@ -285,16 +360,10 @@ void MainWindow::updateSimulation()
         // Пиковый детектор
         if (currentLoad > maxLoad)
             maxLoad = currentLoad;
-        float elong = currentPos - startPos;
-
-        // Запись в Modbus
-        setInputFloat(I_TIME, testTime);
-        setInputFloat(I_ELONGATION, elong);
-        setInputFloat(I_MAX_LOAD, maxLoad);
 
     } else {
         // === РУЧНОЙ РЕЖИМ ===
-        float mSpeed = (float) getHoldingInt(H_MANUAL_SPEED);
+        float mSpeed = (float) getHoldingField(RegisterMap::ManualSpeed);
         if (mSpeed < 0.1f)
             mSpeed = 50.0f;
 
@@ -314,28 +383,62 @@ void MainWindow::updateSimulation()
         // Шум нуля
         currentLoad = (QRandomGenerator::global()->generateDouble() - 0.5) * 0.05;
     }
+}
+
+void MainWindow::publishSnapshot()
+{
+    if (isTestRunning) {
+        setInputField(RegisterMap::TestTime, testTime);
+        setInputField(RegisterMap::Elongation, currentPos - startPos);
+        setInputField(RegisterMap::MaxLoad, maxLoad);
+    }
 
     // Обновляем главные регистры (всегда)
-    setInputFloat(I_POS, currentPos);
-    setInputFloat(I_LOAD, currentLoad);
+    setInputField(RegisterMap::Position, currentPos);
+    setInputField(RegisterMap::Load, currentLoad);
+}
 
-    // Логирование фаз (опционально)
-    if (isTestRunning && cmbSimType->currentIndex() == 1) {
-        static QString lastPh;
-        QString ph = isoEmulator.getCurrentPhaseName();
-        if (!ph.isEmpty() && ph != lastPh) {
-            // onLogMessage("Фаза: " + ph); // Можно раскомментировать
-            lastPh = ph;
-        }
-    }
+void MainWindow::pushFifoSample()
+{
+    ++fifoSeq;
+    const int addr = regMap.address(RegisterMap::FifoHead) + FIFO_HEADER_REGS
+                     + int(fifoSeq % quint32(FIFO_DEPTH)) * FIFO_SLOT_REGS;
+    setInputInt(addr, quint16(fifoSeq & 0xFFFF));
+    setInputFloat(addr + 1, testTime);
+    setInputFloat(addr + 3, currentPos);
+    setInputFloat(addr + 5, currentLoad);
+    setInputFloat(addr + 7, isTestRunning ? currentPos - startPos : 0.0f);
+}
 
-    updateTables();
+void MainWindow::publishStatus(quint16 cmd)
+{
+    const bool bStop = cmdBit(cmd, RegisterMap::BitStop) || cmdBit(cmd, RegisterMap::BitStopMMMode);
+    quint16 status = 0;
+    if (isTestRunning)
+        status |= 1 << 0;
+    if (!isTestRunning && !bStop && cmdBit(cmd, RegisterMap::BitLiftTraverse))
+        status |= 1 << 1;
+    if (!isTestRunning && !bStop && cmdBit(cmd, RegisterMap::BitLowerTraverse))
+        status |= 1 << 2;
+    setInputField(RegisterMap::Status, status);
+    setInputField(RegisterMap::CmdEcho, cmd);
+}
+
+void MainWindow::publishFifoHeader(quint16 rateHz)
+{
+    if (!regMap.has(RegisterMap::FifoHead))
+        return;
+    // Заголовок пишется после слотов: клиент не увидит seq раньше данных
+    const int head = regMap.address(RegisterMap::FifoHead);
+    setInputField(RegisterMap::FifoHead, fifoSeq);
+    setInputInt(head + 2, quint16(FIFO_DEPTH));
+    setInputInt(head + 3, rateHz > 0 ? quint16(1000000 / rateHz) : 0);
 }
 
 void MainWindow::updateTables()
 {
     // Обновление таблицы Holding
-    for (int i = 0; i < 20; i++) {
+    for (int i = 0; i < tableHolding->rowCount(); i++) {
         quint16 val;
         modbusDevice->data(QModbusDataUnit::HoldingRegisters, i, &val);
         if (!tableHolding->item(i, 0)) {
@@ -346,7 +449,7 @@ void MainWindow::updateTables()
     }
 
     // Обновление таблицы Input
-    for (int i = 0; i < 10; i++) {
+    for (int i = 0; i < tableInput->rowCount(); i++) {
         quint16 val;
         modbusDevice->data(QModbusDataUnit::InputRegisters, i, &val);
         if (!tableInput->item(i, 0)) {
@@ -354,22 +457,15 @@ void MainWindow::updateTables()
             tableInput->setItem(i, 1, new QTableWidgetItem());
         }
         QString txt = QString::number(val);
-        // Подсказка для float значений (парсим 2 регистра)
-        if ((i == 0 || i == 2 || i == 4 || i == 6 || i == 8) && i + 1 < 10) {
-            quint16 nextVal;
-            modbusDevice->data(QModbusDataUnit::InputRegisters, i + 1, &nextVal);
-            QByteArray b;
-            b.resize(4);
-            // Big Endian
-            b[0] = (val >> 8) & 0xFF;
-            b[1] = val & 0xFF;
-            b[2] = (nextVal >> 8) & 0xFF;
-            b[3] = nextVal & 0xFF;
-            float f;
-            QDataStream s(b);
-            s.setFloatingPointPrecision(QDataStream::SinglePrecision);
-            s >> f;
-            txt += QString(" (f: %1)").arg(f, 0, 'f', 2);
+        // Подсказка для float значений: поле карты типа f32, начинающееся с этого регистра
+        for (RegisterMap::Field f : RegisterMap::SnapshotFields) {
+            const RegisterMap::Entry &e = regMap.entry(f);
+            if (e.address != i || e.type != RegisterMap::Type::F32)
+                continue;
+            quint16 regs[2] = {val, 0};
+            modbusDevice->data(QModbusDataUnit::InputRegisters, i + 1, &regs[1]);
+            txt += QString(" (f: %1)").arg(regMap.decode(f, regs), 0, 'f', 2);
+            break;
         }
         tableInput->item(i, 1)->setText(txt);
     }
@@ -394,15 +490,50 @@ bool MainWindow::getBit(quint16 val, int bit)
     return (val >> bit) & 1;
 }
 
+bool MainWindow::cmdBit(quint16 cmd, RegisterMap::Bit b)
+{
+    const int bit = regMap.bit(b);
+    return bit >= 0 && getBit(cmd, bit);
+}
+
+void MainWindow::setInputField(RegisterMap::Field f, double val)
+{
+    const RegisterMap::Entry &e = regMap.entry(f);
+    if (!e.isValid())
+        return;
+    quint16 regs[2] = {0, 0};
+    regMap.encode(f, val, regs);
+    for (int k = 0; k < e.size(); ++k)
+        modbusDevice->setData(QModbusDataUnit::InputRegisters, e.address + k, regs[k]);
+}
+
+double MainWindow::getHoldingField(RegisterMap::Field f, double fallback)
+{
+    const RegisterMap::Entry &e = regMap.entry(f);
+    if (!e.isValid())
+        return fallback;
+    quint16 regs[2] = {0, 0};
+    for (int k = 0; k < e.size(); ++k)
+        modbusDevice->data(QModbusDataUnit::HoldingRegisters, e.address + k, &regs[k]);
+    return regMap.decode(f, regs);
+}
+
+void MainWindow::setInputInt(int addr, quint16 val)
+{
+    modbusDevice->setData(QModbusDataUnit::InputRegisters, addr, val);
+}
+
 void MainWindow::setInputFloat(int addr, float val)
 {
     QByteArray buf;
     QDataStream s(&buf, QIODevice::WriteOnly);
     s.setFloatingPointPrecision(QDataStream::SinglePrecision);
     s << val;
-    // Big Endian для Modbus
+    // Big Endian для Modbus; порядок слов - как в профиле
     quint16 h = (static_cast<quint8>(buf[0]) << 8) | static_cast<quint8>(buf[1]);
     quint16 l = (static_cast<quint8>(buf[2]) << 8) | static_cast<quint8>(buf[3]);
+    if (regMap.wordOrder() == RegisterMap::WordOrder::LowFirst)
+        qSwap(h, l);
     modbusDevice->setData(QModbusDataUnit::InputRegisters, addr, h);
     modbusDevice->setData(QModbusDataUnit::InputRegisters, addr + 1, l);
 }
@@ -15,6 +15,7 @@
 // Подключаем наши кастомные классы
 #include "EmulIso6892.h"
 #include "LoggingModbusServer.h"
+#include "RegisterMap.h"
 
 class MainWindow : public QMainWindow
 {
@@ -64,24 +65,42 @@ private:
     float maxLoad = 0.0f;
     bool isTestRunning = false;
 
-    // --- Карта регистров (Holding - Управление) ---
-    const int H_CMD = 0;           // Командное слово (Биты)
-    const int H_TEST_SPEED = 15;   // Скорость испытания (мм/мин)
-    const int H_MANUAL_SPEED = 16; // Скорость ручного перемещения
+    // --- FIFO отсчетов (буферизованный режим) ---
+    quint32 fifoSeq = 0;     // Номер последнего записанного отсчета
+    float fifoBudget = 0.0f; // Накопленная доля отсчета между тиками таймера
+    int tableDivider = 0;    // Таблицы обновляются реже, чем идет физика
 
-    // --- Карта регистров (Input - Датчики) ---
-    const int I_POS = 0;        // Текущее положение (Float)
-    const int I_LOAD = 2;       // Текущая нагрузка (Float)
-    const int I_TIME = 4;       // Время испытания (Float)
-    const int I_ELONGATION = 6; // Удлинение (Float)
-    const int I_MAX_LOAD = 8;   // Пиковая нагрузка (Float)
+    // --- Карта регистров (общий профиль с EvoLiteApp) ---
+    RegisterMap regMap;
+
+    // --- FIFO (Input): заголовок с адреса fifoHead + кольцо слотов ---
+    // [head..head+1] seq последнего отсчета (u32), [+2] глубина, [+3] период, мкс
+    const int FIFO_HEADER_REGS = 4;
+    const int FIFO_SLOT_REGS = 9;   // Слот: seq16, time, pos, load, elong (float)
+    const int FIFO_DEPTH = 256;     // 256 мс истории при 1 кГц
+    const int FIFO_MAX_RATE = 1000; // Гц
+    const int SIM_TICK_MS = 10;     // Период таймера физики
 
     // --- Вспомогательные функции ---
     void setupUi();      // Построение интерфейса кодом
     void updateTables(); // Обновление таблиц на экране
 
+    // Шаг физики на dt секунд (без записи в регистры)
+    void stepPhysics(float dt, quint16 cmd);
+    // Текущее состояние -> регистры снимка
+    void publishSnapshot();
+    // Текущее состояние -> очередной слот FIFO
+    void pushFifoSample();
+    void publishFifoHeader(quint16 rateHz);
+    // Состояние и эхо командного слова
+    void publishStatus(quint16 cmd);
+
     // Работа с данными Modbus
+    void setInputField(RegisterMap::Field f, double val); // Адрес и тип - из карты
+    double getHoldingField(RegisterMap::Field f, double fallback = 0.0);
+    bool cmdBit(quint16 cmd, RegisterMap::Bit b); // Бит команды по карте
     void setInputFloat(int addr, float val);
+    void setInputInt(int addr, quint16 val);
     quint16 getHoldingInt(int addr);
     void setHoldingInt(int addr, quint16 val);
     bool getBit(quint16 val, int bit);
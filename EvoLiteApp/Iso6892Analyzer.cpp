@@ -1,4 +1,7 @@
 #include "Iso6892Analyzer.h"
+#include <algorithm>
+#include <utility>
+#include "LinearRegion.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -10,49 +13,237 @@ Iso6892Analyzer::Iso6892Analyzer(QObject *parent)
     , m_L0(50.0)
 {}
 
-void Iso6892Analyzer::setSpecimenParams(double areaS0, double gaugeLengthL0)
+void Iso6892Analyzer::setSpecimenParams(EvoUnit::SquareMillimeters areaS0,
+                                        EvoUnit::Millimeters gaugeLengthL0)
 {
-    m_S0 = (areaS0 > 0.0001) ? areaS0 : 1.0;
-    m_L0 = (gaugeLengthL0 > 0.1) ? gaugeLengthL0 : 50.0;
+    m_S0 = (areaS0.value() > 0.0001) ? areaS0.value() : 1.0;
+    m_L0 = (gaugeLengthL0.value() > 0.1) ? gaugeLengthL0.value() : 50.0;
 }
 
 void Iso6892Analyzer::reset()
 {
-    m_rawForce.clear();
-    m_rawExtension.clear();
-    m_stress.clear();
-    m_strain.clear();
+    m_arena.clear();
+    m_stress = SampleArena::View();
+    m_strain = SampleArena::View();
     m_results = Iso6892Results();
+    m_online = OnlineState();
+    m_forceStream = SignalFilter::Stream(m_filter);
+    m_filteredCount = 0;
 }
 
-void Iso6892Analyzer::addDataPoint(double forceN, double extensionMm)
+void Iso6892Analyzer::setFilter(const SignalFilter &filter)
 {
-    m_rawForce.append(forceN);
-    m_rawExtension.append(extensionMm);
+    m_filter = filter;
+    m_forceStream = SignalFilter::Stream(m_filter);
 }
 
-void Iso6892Analyzer::normalizeData()
+void Iso6892Analyzer::setFractureThreshold(double fractionOfRm)
+{
+    m_fractureFraction = qBound(0.01, fractionOfRm, 0.95);
+}
+
+void Iso6892Analyzer::addDataPoint(EvoUnit::Newtons force, EvoUnit::Millimeters extension)
 {
-    m_stress.clear();
-    m_strain.clear();
-    int count = m_rawForce.size();
+    m_arena.append(force.value(), extension.value());
 
-    m_stress.reserve(count);
-    m_strain.reserve(count);
+    m_streamOut.clear();
+    m_forceStream.push(force.value(), &m_streamOut);
+    takeFiltered();
+}
 
-    for (int i = 0; i < count; ++i) {
-        // Stress [MPa] = Force [N] / Area [mm2]
-        m_stress.append(m_rawForce[i] / m_S0);
+void Iso6892Analyzer::takeFiltered()
+{
+    for (const double f : std::as_const(m_streamOut)) {
+        const qint64 idx = m_filteredCount++;
+        m_arena.set(SampleArena::ForceFiltered, idx, f);
+        // Те же формулы, что в normalizeData, но для одной точки
+        updateOnline(f / m_S0, m_arena.value(SampleArena::Extension, idx) * 100.0 / m_L0);
+    }
+}
 
-        // Strain [%] = (DeltaL [mm] / L0 [mm]) * 100
-        m_strain.append((m_rawExtension[i] / m_L0) * 100.0);
+// =========================================================================
+// ОНЛАЙН-РАСЧЕТ
+// =========================================================================
+void Iso6892Analyzer::updateOnline(double stress, double strain)
+{
+    OnlineState &o = m_online;
+    const int idx = o.count++;
+    o.lastStrain = strain;
+
+    // 1. Rm / Ag и корзины МНК (только восходящая ветвь: после шейки и разрыва
+    //    напряжение снова проходит 10..40%, эти точки в E попадать не должны)
+    const bool rising = stress >= o.maxStress * 0.98;
+    if (stress > o.maxStress) {
+        o.maxStress = stress;
+        o.strainAtMax = strain;
+    }
+    if (rising && stress >= 0 && !o.fractured) {
+        while (stress >= o.binWidth * FitBins) {
+            for (int i = 0; i < FitBins / 2; ++i) {
+                FitSums &a = o.bins[2 * i];
+                const FitSums &b = o.bins[2 * i + 1];
+                o.bins[i] = {a.n + b.n, a.sx + b.sx, a.sy + b.sy, a.sxy + b.sxy, a.sxx + b.sxx};
+            }
+            std::fill(o.bins.begin() + FitBins / 2, o.bins.end(), FitSums());
+            o.binWidth *= 2;
+        }
+        const double x = strain / 100.0;
+        FitSums &bin = o.bins[int(stress / o.binWidth)];
+        bin.n += 1;
+        bin.sx += x;
+        bin.sy += stress;
+        bin.sxy += x * stress;
+        bin.sxx += x * x;
+    }
+    if (++o.sinceRefit >= RefitEvery)
+        refitOnline();
+
+    const double corrected = strain - o.slopeOffset;
+
+    // 2. Зуб текучести: спад от пика, подтвержденный последующим ростом выше пика
+    //    (спад без роста - это Rm и шейка, а не текучесть)
+    if (!o.yieldFound && !o.fractured) {
+        if (stress > o.peak) {
+            const double drop = o.peak - o.minAfterPeak;
+            if (idx > 0 && drop > std::max(o.peak * 0.005, 1.0) && o.peakStrain > 0.05) {
+                o.yieldFound = true;
+                o.ReH = o.peak;
+                o.ReL = o.minAfterPeak;
+            } else {
+                o.peak = stress;
+                o.peakStrain = corrected;
+                o.peakIdx = idx;
+                o.minAfterPeak = stress;
+            }
+        } else if (idx - o.peakIdx < 500) {
+            o.minAfterPeak = std::min(o.minAfterPeak, stress);
+        }
     }
+
+    // 3. Rp0.2: напряжение опустилось под линию E * (e - 0.2%)
+    if (o.fitValid && !o.proofFound && idx > 0) {
+        const double gap = stress - o.E * (corrected - 0.2) / 100.0;
+        if (gap < 0) {
+            // Пересечение - линейной интерполяцией между соседними точками
+            const double prevGap = o.prevStress - o.E * (o.prevCorrected - 0.2) / 100.0;
+            const double t = prevGap > 0 ? prevGap / (prevGap - gap) : 0.0;
+            o.proofFound = true;
+            o.Rp02 = o.prevStress + t * (stress - o.prevStress);
+        }
+    }
+    o.prevStress = stress;
+    o.prevCorrected = corrected;
+
+    // 4. Разрыв: после максимума напряжение резко рухнуло ниже доли от Rm.
+    //    Пока кривая не ушла с упругой линии, Rm не достоверен (посадка и
+    //    проскальзывание в захватах) - тогда засчитывается только разделение образца.
+    //    Плавный спад на шейке не резкий и разрывом не считается.
+    o.recent[size_t(idx % RecentPoints)] = stress;
+    const bool plastic = o.proofFound || o.yieldFound;
+    const double fraction = plastic ? m_fractureFraction : SeparationFraction;
+    const bool dropped = stress < o.maxStress * fraction;
+    if (!o.fractured && o.fitValid && o.maxStress >= 1.0 && dropped) {
+        const int have = qMin(o.count, RecentPoints);
+        const double recentMax = *std::max_element(o.recent.begin(), o.recent.begin() + have);
+        const bool abrupt = recentMax - stress >= o.maxStress * AbruptDrop;
+        if (++o.belowCount >= FractureConfirmPoints && abrupt) {
+            o.fractured = true;
+            refitOnline();
+            emit fractureDetected();
+        }
+    } else {
+        o.belowCount = 0;
+    }
+}
+
+void Iso6892Analyzer::refitOnline()
+{
+    OnlineState &o = m_online;
+    o.sinceRefit = 0;
+    o.fitValid = false;
+    if (o.maxStress < 1.0)
+        return;
+
+    // Окно 10..40% от текущего максимума с точностью до корзины
+    const int lo = qBound(0, int(o.maxStress * 0.10 / o.binWidth), FitBins - 1);
+    const int hi = qBound(0, int(o.maxStress * 0.40 / o.binWidth), FitBins - 1);
+    FitSums t;
+    for (int i = lo; i <= hi; ++i) {
+        t.n += o.bins[i].n;
+        t.sx += o.bins[i].sx;
+        t.sy += o.bins[i].sy;
+        t.sxy += o.bins[i].sxy;
+        t.sxx += o.bins[i].sxx;
+    }
+    if (t.n < 5)
+        return;
+    const double denominator = t.n * t.sxx - t.sx * t.sx;
+    if (std::abs(denominator) < 1e-9)
+        return;
+    const double E = (t.n * t.sxy - t.sx * t.sy) / denominator;
+    if (E <= 0)
+        return;
+    o.E = E;
+    o.slopeOffset = -((t.sy - E * t.sx) / t.n) / E * 100.0;
+    o.fitValid = true;
+}
+
+Iso6892Results Iso6892Analyzer::provisionalResults() const
+{
+    const OnlineState &o = m_online;
+    Iso6892Results res;
+    if (!o.fitValid)
+        return res;
+
+    res.E_Modulus = o.E;
+    res.Rm = o.maxStress;
+    res.Ag = std::max(0.0, o.strainAtMax - o.slopeOffset);
+    res.At = std::max(0.0, o.lastStrain - o.slopeOffset);
+    res.hasYieldPoint = o.yieldFound;
+    res.ReH = o.ReH;
+    res.ReL = o.ReL;
+    res.Rp02 = o.yieldFound ? 0 : o.Rp02;
+    res.isValid = true;
+    return res;
+}
+
+void Iso6892Analyzer::normalizeData()
+{
+    // Stress [MPa] = Force [N] / Area [mm2]; пересчет линейный - достаточно
+    // коэффициента для 1 N, массив напряжений не нужен
+    const double oneNewton = 1.0;
+    double stressPerNewton = 0.0;
+    EvoUnit::forceToStress(&oneNewton,
+                           &stressPerNewton,
+                           1,
+                           EvoUnit::MeasUnit::Newton,
+                           m_S0,
+                           EvoUnit::MeasUnit::MegaPascal);
+    m_stress = m_arena.column(SampleArena::ForceFiltered).affine(stressPerNewton, 0.0);
+
+    // Strain [%] = (DeltaL [mm] / L0 [mm]) * 100
+    m_strain = m_arena.column(SampleArena::Extension).affine(100.0 / m_L0, 0.0);
 }
 
 Iso6892Results Iso6892Analyzer::calculateResults()
 {
     m_results = Iso6892Results();
 
+    // 0. Фильтр силы: хвост потока, а если поток не совпадает с пакетом
+    //    (LowPass) - заново по всему массиву
+    m_streamOut.clear();
+    m_forceStream.finish(&m_streamOut);
+    takeFiltered();
+    if (m_filter.needsBatch() && m_arena.size() > 0) {
+        const qint64 n = m_arena.size();
+        std::vector<double> force(static_cast<size_t>(n));
+        for (qint64 i = 0; i < n; ++i)
+            force[size_t(i)] = m_arena.value(SampleArena::Force, i);
+        m_filter.apply(force.data(), force.data(), n);
+        for (qint64 i = 0; i < n; ++i)
+            m_arena.set(SampleArena::ForceFiltered, i, force[size_t(i)]);
+    }
+
     // 1. Нормализация данных
     normalizeData();
 
@@ -73,11 +264,7 @@ Iso6892Results Iso6892Analyzer::calculateResults()
 
     // 3. Применение Коррекции нуля
     // Сдвигаем весь график влево, чтобы упругий участок выходил из (0,0)
-    for (int i = 0; i < m_strain.size(); ++i) {
-        m_strain[i] -= slopeOffset;
-        if (m_strain[i] < 0)
-            m_strain[i] = 0;
-    }
+    m_strain = m_strain.affine(1.0, -slopeOffset).clampedBelow(0.0);
 
     // 4. Поиск Rm (Максимальное напряжение)
     double maxS = -1.0;
@@ -89,6 +276,7 @@ Iso6892Results Iso6892Analyzer::calculateResults()
         }
     }
     m_results.Rm = maxS;
+    m_idxRm = idxRm;
 
     // 5. Поиск Ag (Удлинение при максимальной силе)
     if (idxRm < m_strain.size()) {
@@ -111,66 +299,59 @@ Iso6892Results Iso6892Analyzer::calculateResults()
         m_results.ReL = valReL;
         m_results.Rp02 = 0; // Rp0.2 не применяется, если есть ReH (обычно)
     } else {
-        // Зуба нет, плавная кривая (Continuous yielding)
+        // Зуба нет, плавная кривая (Continuous yielding): Rp0.2 - ниже, с остальными пределами
         m_results.hasYieldPoint = false;
-        m_results.Rp02 = findProofStrength(E, 0.2); // Ищем Rp0.2
+    }
+
+    // 8. Условные пределы Rp/Rt (в т.ч. Rp0.2) - одним проходом
+    m_results.strengths = findStrengths(standardStrengths());
+    if (!foundYield) {
+        for (const Iso6892Strength &st : m_results.strengths) {
+            if (st.kind == Iso6892Strength::Proof && st.percent == 0.2)
+                m_results.Rp02 = st.found ? st.stress : 0.0;
+        }
     }
 
     m_results.isValid = true;
     return m_results;
 }
 
-// Метод наименьших квадратов для поиска наклона E
+// Метод наименьших квадратов по самому линейному участку кривой нагружения
 bool Iso6892Analyzer::fitElasticModulus(double &E, double &slopeOffset)
 {
-    // Находим максимум
-    double maxVal = *std::max_element(m_stress.begin(), m_stress.end());
-    if (maxVal < 1.0)
-        return false;
-
-    // ISO 6892 рекомендует диапазон для E
-    // Берем участок от 10% до 40% от максимальной нагрузки
-    double lowerLimit = maxVal * 0.10;
-    double upperLimit = maxVal * 0.40;
-
-    double sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
-    int n = 0;
-
-    for (int i = 0; i < m_stress.size(); ++i) {
-        // Дополнительная проверка: только на восходящем участке (до Rm)
-        if (m_stress[i] >= lowerLimit && m_stress[i] <= upperLimit) {
-            // Если m_strain хранит проценты (например 0.2%),
-            // для расчета модуля их нужно превратить в абсолютную величину (0.002)
-            double x = m_strain[i] / 100.0;
-            double y = m_stress[i];
-            sumX += x;
-            sumY += y;
-            sumXY += x * y;
-            sumXX += x * x;
-            n++;
+    // Находим максимум: кривая нагружения - до него
+    double maxVal = m_stress[0];
+    int idxMax = 0;
+    for (int i = 1; i < m_stress.size(); ++i) {
+        if (m_stress[i] > maxVal) {
+            maxVal = m_stress[i];
+            idxMax = i;
         }
-        // Если нагрузка стала падать (шейка) или ушла далеко, прерываем
-        if (m_stress[i] > upperLimit * 1.5)
-            break;
     }
+    if (maxVal < 1.0)
+        return false;
 
-    if (n < 5)
-        return false; // Мало точек
-
-    double denominator = (n * sumXX - sumX * sumX);
-    if (std::abs(denominator) < 1e-9)
+    // Фиксированная полоса 10..40% от максимума ошибается при провисании образца
+    // (в полосу попадает выборка слабины) и при ранней текучести (попадает изгиб).
+    // Поэтому перебираются все окна полос 15/20/30% от максимума и берется окно
+    // с наибольшим R². Начало окна - выше 2% от максимума (шум около нуля).
+    // Деформация - в абсолютных единицах (0.002, а не 0.2%), тогда E - в МПа.
+    const LinearRegion region(m_strain.affine(0.01, 0.0), m_stress, 0, idxMax + 1);
+    const LinearRegion::Fit fit = region.best(maxVal, {0.15, 0.2, 0.3}, maxVal * 0.02);
+    if (!fit.valid)
         return false;
 
+    m_results.E_FitLow = fit.yLow;
+    m_results.E_FitHigh = fit.yHigh;
+    m_results.E_FitR2 = fit.r2;
+
     // Результат будет в тех же единицах, что и Y (Stress).
     // Если Stress в МПа, то и E в МПа.
     // 190000 МПа = 190 ГПа.
-    E = (n * sumXY - sumX * sumY) / denominator; // Наклон
-    double intercept = (sumY - E * sumX) / n;    // Свободный член b
+    E = fit.slope;                        // Наклон
+    const double intercept = fit.intercept; // Свободный член b
 
-    // Смещение тоже нужно вернуть, но slopeOffset обычно нужен в % для графика.
-    // Тут зависит от того, как вы его применяете.
-    // Если график в %, то offset нужно умножить обратно на 100.
-    // Смещение нуля по X (Toe correction)
+    // Смещение нуля по X (Toe correction), в % - как и деформация на графике
     // 0 = E * x + b  =>  x = -b / E
     slopeOffset = -intercept / E * 100.0;
 
@@ -261,50 +442,76 @@ bool Iso6892Analyzer::findYieldPointPhenomenon(double E_modulus,
     return false; // Не нашли (плавная кривая)
 }
 
-// Поиск Rp0.2 (Метод пересечения со смещением)
-double Iso6892Analyzer::findProofStrength(double E_modulus, double offsetPercent)
+QVector<Iso6892Strength> Iso6892Analyzer::standardStrengths()
 {
-    // offsetPercent = 0.2
-
-    // Оптимизация: начинаем поиск с зоны, где пластика уже могла начаться
-    int startIdx = m_stress.size() / 20;
-
-    for (int i = startIdx; i < m_stress.size(); ++i) {
-        double e = m_strain[i]; // Уже скорректированная деформация
-        double s_real = m_stress[i];
-
-        // Уравнение прямой: y = E * (x - offset)
-        double s_target = E_modulus * (e - offsetPercent);
-
-        // Если реальный график нырнул ПОД линию
-        if (s_real < s_target) {
-            // Интерполяция
-            if (i > 0) {
-                double y1 = m_stress[i - 1];
-                double y2 = m_stress[i];
-                // Простое среднее, достаточно для MVP
-                return (y1 + y2) / 2.0;
-            }
-            return s_real;
-        }
+    QVector<Iso6892Strength> list;
+    for (const double p : {0.01, 0.05, 0.1, 0.2, 0.5, 1.0}) {
+        Iso6892Strength st;
+        st.percent = p;
+        list.append(st);
     }
-    return 0.0; // Не найдено (хрупкое разрушение до 0.2%)
+    Iso6892Strength rt;
+    rt.kind = Iso6892Strength::TotalExtension;
+    rt.percent = 0.5;
+    list.append(rt);
+    return list;
 }
 
-QVector<QPointF> Iso6892Analyzer::getCorrectedCurve() const
+// Пределы Rp/Rt: пересечение кривой со смещенной линией упругости (Rp)
+// или с вертикалью полной деформации (Rt).
+// Rp_x - первая точка, где непропорциональная деформация e - 100*s/E дошла до x;
+// Rt_x - первая точка, где полная деформация дошла до x. Обе величины при
+// движении по кривой растут, поэтому запросы, упорядоченные по x, закрываются
+// по очереди за один проход: O(n + q log q) вместо прохода на каждый предел.
+QVector<Iso6892Strength> Iso6892Analyzer::findStrengths(QVector<Iso6892Strength> queries) const
 {
-    QVector<QPointF> points;
-    if (m_stress.size() != m_strain.size())
-        return points;
-
-    points.reserve(m_stress.size());
-    for (int i = 0; i < m_stress.size(); ++i) {
-        points.append(QPointF(m_strain[i], m_stress[i]));
+    const double E = m_results.E_Modulus;
+    for (Iso6892Strength &q : queries)
+        q.found = false;
+    if (E <= 0 || m_stress.size() < 2 || m_strain.size() != m_stress.size())
+        return queries;
+
+    // Два курсора: по возрастающим смещениям Rp и по возрастающим Rt
+    QVector<int> proofs, totals;
+    for (int k = 0; k < queries.size(); ++k)
+        (queries[k].kind == Iso6892Strength::Proof ? proofs : totals).append(k);
+    const auto byPercent = [&queries](int a, int b) {
+        return queries[a].percent < queries[b].percent;
+    };
+    std::sort(proofs.begin(), proofs.end(), byPercent);
+    std::sort(totals.begin(), totals.end(), byPercent);
+    int nextProof = 0, nextTotal = 0;
+
+    // Точка пересечения между i-1 и i: доля t по величине v, которая прошла x
+    const auto settle = [&](Iso6892Strength &q, int i, double vPrev, double v) {
+        const double t = (v > vPrev) ? qBound(0.0, (q.percent - vPrev) / (v - vPrev), 1.0) : 1.0;
+        q.stress = m_stress[i - 1] + t * (m_stress[i] - m_stress[i - 1]);
+        q.strain = m_strain[i - 1] + t * (m_strain[i] - m_strain[i - 1]);
+        q.found = true;
+    };
+
+    // Rp ищется до Rm: после максимума (шейка, разрыв) напряжение падает и
+    // непропорциональная деформация растет скачком - это уже не предел
+    const int proofEnd = qMin(m_idxRm, int(m_stress.size()) - 1);
+    double prevPlastic = m_strain[0] - 100.0 * m_stress[0] / E;
+    double prevTotal = m_strain[0];
+    for (int i = 1; i < m_stress.size(); ++i) {
+        const double total = m_strain[i];
+        const double plastic = total - 100.0 * m_stress[i] / E;
+        while (nextProof < proofs.size() && i <= proofEnd
+               && plastic >= queries[proofs[nextProof]].percent)
+            settle(queries[proofs[nextProof++]], i, prevPlastic, plastic);
+        while (nextTotal < totals.size() && total >= queries[totals[nextTotal]].percent)
+            settle(queries[totals[nextTotal++]], i, prevTotal, total);
+        if ((nextProof == proofs.size() || i >= proofEnd) && nextTotal == totals.size())
+            break;
+        prevPlastic = plastic;
+        prevTotal = total;
     }
-    return points;
+    return queries;
 }
 
-double Iso6892Analyzer::calculateZ(double finalDiameterDu) const
+double Iso6892Analyzer::calculateZ(EvoUnit::Millimeters finalDiameterDu) const
 {
     // Защита: Если S0 не задана или некорректна, вернуть 0
     if (m_S0 <= 0.0001)
@@ -312,7 +519,7 @@ double Iso6892Analyzer::calculateZ(double finalDiameterDu) const
 
     // 1. Считаем конечную площадь шейки (Su)
     // Su = pi * r^2 = pi * (d/2)^2
-    double radius = finalDiameterDu / 2.0;
+    double radius = finalDiameterDu.value() / 2.0;
     double Su = M_PI * radius * radius;
 
     // 2. Формула Z = (S0 - Su) / S0 * 100%
@@ -325,14 +532,14 @@ double Iso6892Analyzer::calculateZ(double finalDiameterDu) const
     return Z;
 }
 
-double Iso6892Analyzer::calculateManualA(double finalLengthLu) const
+double Iso6892Analyzer::calculateManualA(EvoUnit::Millimeters finalLengthLu) const
 {
     // Защита: Если L0 не задана
     if (m_L0 <= 0.1)
         return 0.0;
 
     // Формула A = (Lu - L0) / L0 * 100%
-    double A = (finalLengthLu - m_L0) / m_L0 * 100.0;
+    double A = (finalLengthLu.value() - m_L0) / m_L0 * 100.0;
 
     if (A < 0)
         return 0.0; // Образец не может сжаться при растяжении
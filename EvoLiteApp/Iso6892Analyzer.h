@@ -5,13 +5,33 @@
 #include <QObject>
 #include <QPointF>
 #include <QVector>
+#include <array>
 #include <cmath>
+#include "EvoQuantity.h"
+#include "SampleArena.h"
+#include "SignalFilter.h"
+
+// Условный предел: Rp (по непропорциональному удлинению) или Rt (по полному)
+struct Iso6892Strength
+{
+    enum Kind { Proof = 0, TotalExtension };
+
+    Kind kind{Proof};
+    double percent{0.0}; // Rp0.2 -> 0.2
+    double stress{0.0};  // МПа
+    double strain{0.0};  // Полная деформация в точке, %
+    bool found{false};
+};
 
 // Структура для хранения полных результатов по ISO 6892-1
 struct Iso6892Results
 {
     // --- Основные параметры ---
     double E_Modulus; // Модуль упругости (Young's Modulus), МПа
+    // Окно, по которому посчитан E (самый линейный участок): границы по напряжению и R²
+    double E_FitLow;  // МПа
+    double E_FitHigh; // МПа
+    double E_FitR2;
     double Rm;        // Временное сопротивление (Tensile Strength), МПа
     double At;        // Полное удлинение при разрыве (Total Extension), %
     double Ag;        // Равномерное удлинение при макс. силе (Plastic+Elastic extension at Fmax), %
@@ -23,10 +43,16 @@ struct Iso6892Results
     double ReH;  // Верхний предел текучести (Upper Yield Strength), МПа
     double ReL;  // Нижний предел текучести (Lower Yield Strength), МПа
 
+    // Набор Rp/Rt для протокола (Iso6892Analyzer::standardStrengths)
+    QVector<Iso6892Strength> strengths;
+
     bool isValid; // Флаг успешности расчета
 
     Iso6892Results()
         : E_Modulus(0)
+        , E_FitLow(0)
+        , E_FitHigh(0)
+        , E_FitR2(0)
         , Rm(0)
         , At(0)
         , Ag(0)
@@ -45,65 +71,160 @@ public:
     explicit Iso6892Analyzer(QObject *parent = nullptr);
 
     // [Setup] Установка параметров образца. Вызывать перед стартом теста.
-    // areaS0: Площадь сечения (мм^2)
-    // gaugeLengthL0: Начальная длина (мм)
-    void setSpecimenParams(double areaS0, double gaugeLengthL0);
+    // areaS0: Площадь сечения
+    // gaugeLengthL0: Начальная длина
+    void setSpecimenParams(EvoUnit::SquareMillimeters areaS0, EvoUnit::Millimeters gaugeLengthL0);
 
     // [Control] Сброс данных
     void reset();
+    // [Control] Память под ожидаемое число точек (кусками, без переездов при росте)
+    void reserve(qint64 expectedPoints) { m_arena.reserve(expectedPoints); }
 
     // [Input] Добавление данных в реальном времени (Слот)
-    // forceN: Сила с тензодатчика (Ньютоны)
-    // extensionMm: Перемещение с энкодера/экстензометра (мм)
-    void addDataPoint(double forceN, double extensionMm);
+    // force: Сила с тензодатчика
+    // extension: Перемещение с энкодера/экстензометра
+    // Заодно обновляет онлайн-расчет (амортизированное O(1) на точку).
+    void addDataPoint(EvoUnit::Newtons force, EvoUnit::Millimeters extension);
 
     // [Process] Основной расчет. Вызывать после остановки машины.
     Iso6892Results calculateResults();
 
-    // [Output] Получить данные для построения графика (Stress-Strain)
-    // Данные возвращаются уже с КОРРЕКЦИЕЙ НУЛЯ (сдвинуты влево).
-    // X = Strain (%), Y = Stress (MPa)
-    QVector<QPointF> getCorrectedCurve() const;
+    // [Process] Пределы Rp/Rt для списка смещений одним проходом по кривой
+    // с линейной интерполяцией в точке пересечения. Вызывать после calculateResults()
+    // (нужны E и коррекция нуля); порядок результатов - как в запросе.
+    QVector<Iso6892Strength> findStrengths(QVector<Iso6892Strength> queries) const;
+    // Rp0.01, Rp0.05, Rp0.1, Rp0.2, Rp0.5, Rp1.0, Rt0.5
+    static QVector<Iso6892Strength> standardStrengths();
+
+    // [Online] Предварительные результаты по уже полученным точкам:
+    // E - по суммам МНК, ReH/ReL - по детектору спада, Rp0.2 - по первому
+    // пересечению с линией смещения. Окончательные значения дает calculateResults().
+    Iso6892Results provisionalResults() const;
+    bool isFractured() const { return m_online.fractured; }
+
+    // Разрыв: после Rm напряжение резко упало ниже этой доли от Rm (по умолчанию 0.2).
+    // Детектор взводится только после пластического участка (найден Rp0.2 или зуб):
+    // проскальзывание в захватах на упругом участке испытание не останавливает.
+    void setFractureThreshold(double fractionOfRm);
+
+    // Фильтр силы перед анализом (по умолчанию пустой - сила как есть).
+    // Онлайн-расчет идет по потоку фильтра (с задержкой latency() точек),
+    // calculateResults() - по тому же фильтру по всему массиву. Вызывать до старта.
+    void setFilter(const SignalFilter &filter);
+    const SignalFilter &filter() const { return m_filter; }
+
+    // [Output] Данные для графика и выгрузки (Stress-Strain) - виды на арену, без копий.
+    // Действительны до reset(); после calculateResults() деформация - с КОРРЕКЦИЕЙ НУЛЯ.
+    // Strain (%), Stress (MPa)
+    SampleArena::View strainView() const { return m_strain; }
+    SampleArena::View stressView() const { return m_stress; }
+    // Сырые столбцы: сила (N), удлинение (mm), сила после фильтра (N)
+    const SampleArena &arena() const { return m_arena; }
 
     // [Manual Input] Расчет относительного сужения (Z) после разрыва
-    // finalDiameterDu: Конечный диаметр шейки образца (мм), измеренный вручную
+    // finalDiameterDu: Конечный диаметр шейки образца, измеренный вручную
     // Возвращает Z в процентах (%).
-    double calculateZ(double finalDiameterDu) const;
+    double calculateZ(EvoUnit::Millimeters finalDiameterDu) const;
 
     // [Manual Input] Расчет относительного удлинения (A) после разрыва вручную
-    // finalLengthLu: Конечная длина образца (мм), измеренная вручную (сложив половинки)
+    // finalLengthLu: Конечная длина образца, измеренная вручную (сложив половинки)
     // Возвращает A в процентах (%).
-    double calculateManualA(double finalLengthLu) const;
+    double calculateManualA(EvoUnit::Millimeters finalLengthLu) const;
+
+signals:
+    // Разрыв обнаружен (один раз до reset): пора останавливать машину и считать итог
+    void fractureDetected();
 
 private:
-    // Параметры
+    // Параметры (внутри - числа в мм² и мм, типы проверяются на входе)
     double m_S0;
     double m_L0;
 
-    // Сырые данные
-    QVector<double> m_rawForce;     // N
-    QVector<double> m_rawExtension; // mm
+    // Сырые данные: столбцы силы (N) и удлинения (mm)
+    SampleArena m_arena;
+
+    // Фильтр силы: поток пишет в столбец ForceFiltered по мере готовности точек
+    SignalFilter m_filter;
+    SignalFilter::Stream m_forceStream;
+    QVector<double> m_streamOut;
+    qint64 m_filteredCount{0}; // Точек, уже записанных в ForceFiltered
 
-    // Расчетные данные (Нормализованные)
-    QVector<double> m_stress; // MPa
-    QVector<double> m_strain; // %
+    // Расчетные данные (Нормализованные) - виды на арену с пересчетом на лету
+    SampleArena::View m_stress; // MPa
+    SampleArena::View m_strain; // %
 
     Iso6892Results m_results;
 
+    // --- Онлайн-расчет ---
+    // Суммы МНК копятся по корзинам напряжения: окно 10..40% от Rm сдвигается
+    // вместе с растущим максимумом, а пересчет E идет по корзинам, не по точкам.
+    // При выходе за диапазон соседние корзины сливаются (ширина удваивается).
+    static constexpr int FitBins = 256;
+    static constexpr int RefitEvery = 32; // Точек между пересчетами E
+    // Разрыв: ниже порога FractureConfirmPoints точек подряд, и напряжение упало
+    // резко - не меньше чем на AbruptDrop * Rm за последние RecentPoints точек
+    static constexpr int RecentPoints = 64;
+    static constexpr int FractureConfirmPoints = 5;
+    static constexpr double AbruptDrop = 0.25;
+    // Без пластического участка (хрупкий образец) разрыв - только полное разделение
+    static constexpr double SeparationFraction = 0.05;
+    struct FitSums
+    {
+        double n{0}, sx{0}, sy{0}, sxy{0}, sxx{0};
+    };
+    struct OnlineState
+    {
+        std::array<FitSums, FitBins> bins{};
+        double binWidth{1.0 / 16}; // МПа
+        int sinceRefit{0};
+        bool fitValid{false};
+        double E{0};           // МПа
+        double slopeOffset{0}; // %, коррекция нуля
+        int count{0};
+        double maxStress{0}; // Rm
+        double strainAtMax{0}; // Сырая деформация, %
+        double lastStrain{0};
+        // Детектор зуба текучести: пик, минимум после него и подтверждение
+        double peak{0};
+        double peakStrain{0};
+        int peakIdx{0};
+        double minAfterPeak{0};
+        bool yieldFound{false};
+        double ReH{0};
+        double ReL{0};
+        // Rp0.2: первое пересечение с линией смещения
+        bool proofFound{false};
+        double Rp02{0};
+        double prevStress{0};
+        double prevCorrected{0};
+        // Детектор разрыва: последние напряжения и счетчик точек ниже порога
+        std::array<double, RecentPoints> recent{};
+        int belowCount{0};
+        bool fractured{false};
+    };
+    OnlineState m_online;
+    double m_fractureFraction{0.2};
+
     // --- Внутренние алгоритмы ---
 
-    // 1. Пересчет Force/Ext -> Stress/Strain
+    // 1. Виды Force/Ext -> Stress/Strain (коэффициенты, без копирования)
     void normalizeData();
 
-    // 2. Расчет Модуля Упругости (Least Squares)
+    // 2. Расчет Модуля Упругости (Least Squares по самому линейному окну)
     // slopeOffset - выходной параметр (сдвиг по X для коррекции нуля)
     bool fitElasticModulus(double &E, double &slopeOffset);
 
     // 3. Поиск физического предела текучести (Зуб - ReH/ReL)
     bool findYieldPointPhenomenon(double E_modulus, int maxLoadIdx, double &ReH, double &ReL);
 
-    // 4. Поиск условного предела текучести (Rp0.2)
-    double findProofStrength(double E_modulus, double offsetPercent);
+    // Индекс Rm последнего calculateResults (Rp ищется до него)
+    int m_idxRm{0};
+
+    // Онлайн: шаг по новой точке и пересчет E по корзинам
+    void updateOnline(double stress, double strain);
+    // Записать готовые точки потока фильтра и передать их в онлайн-расчет
+    void takeFiltered();
+    void refitOnline();
 };
 
 #endif // ISO6892ANALYZER_H
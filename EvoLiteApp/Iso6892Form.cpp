@@ -1,9 +1,11 @@
 #include "Iso6892Form.h"
+#include <QDateTime>
+#include <QDebug>
 #include <QLCDNumber>
 #include <QMessageBox>
 #include "Iso6892Analyzer.h"
-#include "MachineControl.h"
 #include "TensilePlotWidget.h"
+#include "TestJournal.h"
 #include "ui_Iso6892Form.h"
 #include <cmath>
 
@@ -12,11 +14,11 @@ Iso6892Form::Iso6892Form(MachineControl *machine, QWidget *parent)
     , ui(new Ui::Iso6892Form)
     , m_machine(machine)
     , m_isTestRunning(false)
-    , m_lastRawForceKg(0)
-    , m_lastRawExtMm(0)
+    , m_lastRawForce(0)
+    , m_lastRawExt(0)
     , m_lastTestTimeS(0)
-    , m_forceOffsetKg(0)
-    , m_extOffsetMm(0)
+    , m_forceOffset(0)
+    , m_extOffset(0)
     , m_currentS0(1.0)
 {
     ui->setupUi(this);
@@ -25,6 +27,13 @@ Iso6892Form::Iso6892Form(MachineControl *machine, QWidget *parent)
     m_plot = new TensilePlotWidget(this);
     m_analyzer = new Iso6892Analyzer(this);
     m_guiTimer = new QTimer(this);
+    m_journal = new TestJournal(m_machine, this);
+    connect(m_journal, &TestJournal::journalError, this, [this](const QString &msg) {
+        qWarning() << "Iso6892Form:" << msg;
+        // Оператор должен видеть, что испытание больше не защищено от сбоя
+        ui->lblJournal->setText("Журнал не пишется: " + msg);
+        ui->lblJournal->setToolTip(m_journal->path());
+    });
 
     replaceWidgetInGroupBox(ui->gbPlot, m_plot);
 
@@ -32,11 +41,54 @@ Iso6892Form::Iso6892Form(MachineControl *machine, QWidget *parent)
     connect(m_machine, &MachineControl::connected, this, &Iso6892Form::onMachineConnected);
     connect(m_machine, &MachineControl::disconnected, this, &Iso6892Form::onMachineDisconnected);
     connect(m_machine,
-            &MachineControl::currentLoadChanged,
+            &MachineControl::linkQualityChanged,
+            this,
+            &Iso6892Form::onLinkQualityChanged);
+    m_analysisReader = m_machine->createSampleReader();
+    m_readBuffer.resize(1024);
+    connect(m_machine, &MachineControl::samplesAvailable, this, &Iso6892Form::onSamplesAvailable);
+    connect(m_machine,
+            &MachineControl::tareDriftDetected,
             this,
-            &Iso6892Form::onCurrentLoadChanged);
-    connect(m_machine, &MachineControl::lengthChanged, this, &Iso6892Form::onLengthChanged);
-    connect(m_machine, &MachineControl::testTimeChanged, this, &Iso6892Form::onTestTimeChanhed);
+            [this](double forceKgf, double extMm) {
+                if (m_isTestRunning)
+                    return;
+                ui->btnZero->setStyleSheet("background-color: #FFC107;");
+                ui->btnZero->setToolTip(QString("Дрейф нуля: %1 кгс, %2 мм")
+                                            .arg(forceKgf, 0, 'f', 2)
+                                            .arg(extMm, 0, 'f', 3));
+            });
+    connect(m_machine, &MachineControl::commandTimedOut, this, [this](int bit, bool state) {
+        if (bit == MachineControl::BitStop && state)
+            QMessageBox::warning(this, "Машина", "ПЛК не подтвердил команду СТОП.");
+    });
+
+    // Фильтр силы: выбросы (Hampel) и сглаживание шума датчика без среза пиков
+    // (Савицкий-Голай). Задержка онлайн-расчета - 3 + 5 точек, итог не сдвигается
+    SignalFilter forceFilter;
+    SignalFilter::Stage hampel;
+    hampel.type = SignalFilter::Hampel;
+    hampel.window = 7;
+    hampel.threshold = 3.0;
+    forceFilter.addStage(hampel);
+    SignalFilter::Stage smooth;
+    smooth.type = SignalFilter::SavitzkyGolay;
+    smooth.window = 11;
+    smooth.order = 3;
+    forceFilter.addStage(smooth);
+    m_analyzer->setFilter(forceFilter);
+
+    // Разрыв виден по онлайн-расчету: стоп и итог сразу, не дожидаясь оператора.
+    // Через очередь - сигнал приходит из addDataPoint внутри цикла чтения кольца
+    connect(
+        m_analyzer,
+        &Iso6892Analyzer::fractureDetected,
+        this,
+        [this]() {
+            if (m_isTestRunning)
+                on_btnStop_clicked();
+        },
+        Qt::QueuedConnection);
 
     // Таймер GUI
     connect(m_guiTimer, &QTimer::timeout, this, &Iso6892Form::onGuiTimerTick);
@@ -46,6 +98,9 @@ Iso6892Form::Iso6892Form(MachineControl *machine, QWidget *parent)
     ui->btnStop->setEnabled(false);
     ui->btnReturn->setEnabled(false);
     ui->btnZero->setEnabled(false);
+
+    // После показа окна: диалог восстановления не должен появляться раньше формы
+    QTimer::singleShot(0, this, &Iso6892Form::offerJournalRecovery);
 }
 
 Iso6892Form::~Iso6892Form()
@@ -64,12 +119,15 @@ void Iso6892Form::onMachineConnected()
     ui->btnStart->setEnabled(true);
     ui->btnReturn->setEnabled(true);
     ui->btnZero->setEnabled(true);
-    m_machine->startPolling(50);
+    m_machine->startPolling(SnapshotPollMs);
     m_guiTimer->start(50);
 }
 
 void Iso6892Form::onMachineDisconnected()
 {
+    // Полученные до обрыва отсчеты не теряем: итог и журнал закрываются как при СТОП
+    if (m_isTestRunning)
+        finishTest(false);
     ui->btnStart->setEnabled(false);
     ui->btnStop->setEnabled(false);
     ui->btnReturn->setEnabled(false);
@@ -77,26 +135,79 @@ void Iso6892Form::onMachineDisconnected()
     m_guiTimer->stop();
 }
 
-void Iso6892Form::onCurrentLoadChanged(float kgVal)
+void Iso6892Form::onSamplesAvailable()
 {
-    m_lastRawForceKg = kgVal;
+    using namespace EvoUnit;
+    int n = 0;
+    while ((n = m_analysisReader.read(m_readBuffer.data(), m_readBuffer.size())) > 0) {
+        for (int i = 0; i < n; ++i) {
+            const MachineControl::Sample &sample = m_readBuffer[i];
+            m_lastRawForce = KilogramsForce(sample.load);
+            m_lastRawExt = Millimeters(sample.elongation);
+            m_lastTestTimeS = sample.time;
+
+            // Сила и удлинение - из одного ответа ПЛК, каждый отсчет в анализ попадает один раз
+            if (m_isTestRunning) {
+                const Newtons force = netForce(m_lastRawForce);
+                const Millimeters ext = m_lastRawExt - m_extOffset;
+                m_analyzer->addDataPoint(force, ext);
+                m_livePending.append(QPointF(force.value(), ext.value()));
+            }
+        }
+    }
+}
+
+void Iso6892Form::onLinkQualityChanged(MachineControl::LinkQuality quality)
+{
+    if (quality == MachineControl::LinkGood || !m_isTestRunning)
+        return;
+
+    const MachineControl::LinkStats stats = m_machine->linkStats();
+    qWarning() << "Iso6892Form: link" << quality << "- timeouts" << stats.timeouts << "errors"
+               << stats.errors << "last reply" << stats.lastReplyAgeMs << "ms ago";
+
+    // СТОП идет вне очереди (если драйвер еще подключен); результаты считаются
+    // по уже полученным отсчетам в любом случае, журнал помечается прерванным
+    if (m_machine->isConnected())
+        sendCommand(MachineControl::BitStop);
+    finishTest(false);
+    QMessageBox::warning(this,
+                         "Машина",
+                         "Связь с ПЛК ухудшилась - испытание остановлено.\n"
+                         "Проверьте, что траверса остановилась.");
 }
-void Iso6892Form::onLengthChanged(float mmVal)
+
+EvoUnit::Newtons Iso6892Form::netForce(EvoUnit::KilogramsForce raw) const
 {
-    m_lastRawExtMm = mmVal;
+    // В анализ сила идет без мертвой зоны - она только для индикатора
+    return raw - m_forceOffset;
 }
 
-void Iso6892Form::onTestTimeChanhed(float sVal)
+bool Iso6892Form::applyTare()
 {
-    m_lastTestTimeS = sVal;
+    using namespace EvoUnit;
+    const MachineControl::TareState tare = m_machine->captureTare();
+    if (!tare.valid) {
+        qWarning() << "Iso6892Form: tare window not filled yet";
+        return false;
+    }
+    m_forceOffset = KilogramsForce(tare.forceKgf);
+    m_extOffset = Millimeters(tare.extMm);
+    m_forceDeadband = KilogramsForce(3.0 * tare.forceNoiseKgf);
+    ui->btnZero->setStyleSheet(QString());
+    ui->btnZero->setToolTip(QString("Шум нуля: %1 кгс").arg(tare.forceNoiseKgf, 0, 'f', 3));
+    return true;
 }
 
 // --- УПРАВЛЕНИЕ ---
 
 void Iso6892Form::on_btnZero_clicked()
 {
-    m_forceOffsetKg = m_lastRawForceKg;
-    m_extOffsetMm = m_lastRawExtMm;
+    if (!applyTare()) {
+        // Окно не набрано (только что подключились) - по последнему отсчету
+        m_forceOffset = m_lastRawForce;
+        m_extOffset = m_lastRawExt;
+    }
 
     // Сброс виджета графика
     m_plot->resetPlot();
@@ -113,20 +224,28 @@ void Iso6892Form::on_btnStart_clicked()
 
     // 1. Геометрия
     double L0 = ui->sbL0->value();
-    m_currentS0 = 1.0;
     if (ui->rbRound->isChecked()) {
-        double d = ui->sbDiameter->value();
-        m_currentS0 = 3.14159265 * (d / 2.0) * (d / 2.0);
+        const EvoUnit::Millimeters r(ui->sbDiameter->value() / 2.0);
+        m_currentS0 = 3.14159265 * r * r;
     } else {
-        m_currentS0 = ui->sbThickness->value() * ui->sbWidth->value();
+        m_currentS0 = EvoUnit::Millimeters(ui->sbThickness->value())
+                      * EvoUnit::Millimeters(ui->sbWidth->value());
     }
 
     // 2. Настройка Анализатора
-    m_analyzer->setSpecimenParams(m_currentS0, L0);
+    m_analyzer->setSpecimenParams(m_currentS0, EvoUnit::Millimeters(L0));
+    // Разрыв - спад напряжения на заданный процент от Rm
+    m_analyzer->setFractureThreshold(1.0 - ui->sbBreakThreshold->value() / 100.0);
     m_analyzer->reset();
+    // Память под все испытание сразу: до удлинения L0 (100%) при заданной скорости, мм/мин.
+    // Очень медленные испытания резервируются частично - дальше арена растет кусками
+    const bool buffered = m_machine->supportsBufferedMode();
+    m_testRateHz = buffered ? BufferedRateHz : quint16(1000 / SnapshotPollMs);
+    const double expectedSeconds = L0 / qMax(0.1, ui->sbSpeed->value()) * 60.0;
+    m_analyzer->reserve(qMin(qint64(expectedSeconds * m_testRateHz), qint64(10000000)));
 
     // 3. Настройка Графика (передаем параметры для Live-рисования)
-    m_plot->setSpecimenParams(m_currentS0, L0);
+    m_plot->setSpecimenParams(m_currentS0.value(), L0);
     m_plot->resetPlot();
 
     // 4. Очистка полей результатов
@@ -139,9 +258,44 @@ void Iso6892Form::on_btnStart_clicked()
     ui->leAg->clear();
 
     // 5. Старт машины
+    if (ui->cbAutoZero->isChecked()) {
+        const MachineControl::TareState tare = m_machine->tareState();
+        // Под нагрузкой или в движении окно шумит - такой нуль хуже прежнего
+        if (tare.idle)
+            applyTare();
+        else
+            qWarning() << "Iso6892Form: auto-zero skipped, signal not settled";
+    }
     m_machine->setTestSpeed(static_cast<int>(ui->sbSpeed->value()));
+    if (buffered)
+        m_machine->setBufferedMode(BufferedRateHz);
+    m_analysisReader.skipToHead();
+    m_lostAtStart = m_analysisReader.dropped();
+    m_livePending.clear();
+
+    TestJournal::Header header;
+    header.areaS0 = m_currentS0.value();
+    header.gaugeLengthL0 = L0;
+    header.forceOffsetKgf = m_forceOffset.value();
+    header.extOffsetMm = m_extOffset.value();
+    header.startedMsecs = QDateTime::currentMSecsSinceEpoch();
+    header.rateHz = m_testRateHz;
+    if (m_journal->begin(TestJournal::newJournalPath(), header)) {
+        ui->lblJournal->clear();
+    } else {
+        const auto answer = QMessageBox::question(this,
+                                                  "Журнал испытания",
+                                                  "Не удалось создать журнал испытания.\n"
+                                                  "При сбое полученные данные будут потеряны.\n"
+                                                  "Начать испытание без журнала?");
+        if (answer != QMessageBox::Yes) {
+            m_machine->setBufferedMode(0);
+            return;
+        }
+    }
 
-    QTimer::singleShot(500, [this]() { sendCommand(MachineControl::BitStartTest); });
+    // Очередь записи сохраняет порядок: скорость дойдет до ПЛК раньше старта
+    sendCommand(MachineControl::BitStartTest);
 
     m_isTestRunning = true;
     ui->gbGeometry->setEnabled(false);
@@ -152,27 +306,41 @@ void Iso6892Form::on_btnStart_clicked()
 
 void Iso6892Form::on_btnStop_clicked()
 {
-    if (!m_machine->isConnected())
-        return;
-
-    sendCommand(MachineControl::BitStop);
-
-    if (m_isTestRunning) {
-        m_isTestRunning = false;
-
-        // --- АНАЛИЗ ---
-        Iso6892Results res = m_analyzer->calculateResults();
-        displayResults(res);
+    // Без связи стоп не отправить, но испытание все равно завершается - как прерванное
+    const bool connected = m_machine->isConnected();
+    if (connected)
+        sendCommand(MachineControl::BitStop);
 
-        // --- ГРАФИК ---
-        // Передаем результаты и чистую кривую в виджет для отрисовки
-        m_plot->plotFinalAnalysis(res, m_analyzer->getCorrectedCurve());
+    if (m_isTestRunning)
+        finishTest(connected);
+}
 
-        ui->gbGeometry->setEnabled(true);
-        ui->btnStart->setEnabled(true);
-        ui->btnReturn->setEnabled(true);
-        ui->btnStop->setEnabled(false);
-    }
+void Iso6892Form::finishTest(bool completed)
+{
+    // Дочитываем хвост, пришедший до стоп-команды
+    onSamplesAvailable();
+    m_isTestRunning = false;
+    m_livePending.clear(); // График заменит скорректированная кривая
+    m_journal->end(completed);
+    m_machine->setBufferedMode(0);
+
+    const quint64 lost = m_analysisReader.dropped() - m_lostAtStart;
+    if (lost > 0)
+        qWarning() << "Iso6892Form: analysis skipped" << lost << "samples";
+
+    // --- АНАЛИЗ ---
+    Iso6892Results res = m_analyzer->calculateResults();
+    displayResults(res);
+
+    // --- ГРАФИК ---
+    // Передаем результаты и чистую кривую в виджет для отрисовки
+    m_plot->plotFinalAnalysis(res, m_analyzer->strainView(), m_analyzer->stressView());
+
+    const bool online = m_machine->isConnected();
+    ui->gbGeometry->setEnabled(true);
+    ui->btnStart->setEnabled(online);
+    ui->btnReturn->setEnabled(online);
+    ui->btnStop->setEnabled(false);
 }
 
 void Iso6892Form::on_btnReturn_clicked()
@@ -187,33 +355,33 @@ void Iso6892Form::on_btnReturn_clicked()
 // --- GUI UPDATE LOOP ---
 void Iso6892Form::onGuiTimerTick()
 {
-    double netForceKg = m_lastRawForceKg - m_forceOffsetKg;
-    double netExtMm = m_lastRawExtMm - m_extOffsetMm;
-
-    // Фильтр нуля
-    if (std::abs(netForceKg) < 0.05)
-        netForceKg = 0;
-
-    double forceN = netForceKg * 9.80665;
+    using namespace EvoUnit;
+    KilogramsForce shown = m_lastRawForce - m_forceOffset;
+    if (abs(shown) < m_forceDeadband)
+        shown = KilogramsForce(0);
+    const Newtons force = shown;
+    const Millimeters netExt = m_lastRawExt - m_extOffset;
 
     // Обновляем дисплеи
-    double stress = (m_currentS0 > 0) ? (forceN / m_currentS0) : 0;
-    //ui->lcdLoad->display(forceN / 1000.0); // кН
-    //ui->lcdExtension->display(netExtMm);
-    //ui->lcdStress->display(stress);
-    //ui->lcdTime->display(m_lastTestTimeS);
-
-    setLcdUniversal(ui->lcdLoad, forceN / 1000.0);
-    setLcdUniversal(ui->lcdExtension, netExtMm);
-    setLcdUniversal(ui->lcdStress, stress);
+    const MegaPascals stress = (m_currentS0 > SquareMillimeters(0)) ? force / m_currentS0
+                                                                    : MegaPascals(0);
+
+    setLcdUniversal(ui->lcdLoad, KiloNewtons(force).value());
+    setLcdUniversal(ui->lcdExtension, netExt.value());
+    setLcdUniversal(ui->lcdStress, stress.value());
     setLcdUniversal(ui->lcdTime, m_lastTestTimeS);
 
-    if (m_isTestRunning) {
-        // Данные для математики
-        m_analyzer->addDataPoint(forceN, netExtMm);
+    if (m_isTestRunning && !m_livePending.isEmpty()) {
+        // Все точки с прошлого тика, одна перерисовка (виджет сам переведет в % и МПа)
+        m_plot->addLivePoints(m_livePending);
+        m_livePending.clear();
+    }
 
-        // Данные для Live-графика (виджет сам переведет их в % и МПа)
-        m_plot->addLivePoint(forceN, netExtMm);
+    // Предварительные E, ReH/ReL, Rp0.2, Rm по уже полученным точкам
+    if (m_isTestRunning) {
+        const Iso6892Results live = m_analyzer->provisionalResults();
+        if (live.isValid)
+            displayResults(live);
     }
 }
 
@@ -225,6 +393,11 @@ void Iso6892Form::displayResults(const Iso6892Results &res)
     }
     ui->leRm->setText(QString::number(res.Rm, 'f', 1));
     ui->leE->setText(QString::number(res.E_Modulus / 1000.0, 'f', 1) + " ГПа");
+    ui->leE->setToolTip(res.E_FitR2 > 0 ? QString("Участок %1..%2 МПа, R² = %3")
+                                               .arg(res.E_FitLow, 0, 'f', 1)
+                                               .arg(res.E_FitHigh, 0, 'f', 1)
+                                               .arg(res.E_FitR2, 0, 'f', 5)
+                                         : QString());
     ui->leAt->setText(QString::number(res.At, 'f', 1));
     ui->leAg->setText(QString::number(res.Ag, 'f', 1));
 
@@ -237,15 +410,70 @@ void Iso6892Form::displayResults(const Iso6892Results &res)
         ui->leReL->setText("-");
         ui->leRp02->setText(QString::number(res.Rp02, 'f', 1));
     }
+
+    // Полный набор Rp/Rt для протокола - в подсказке
+    QStringList strengths;
+    for (const Iso6892Strength &st : res.strengths) {
+        if (st.found)
+            strengths << QString("%1%2 = %3 МПа")
+                             .arg(st.kind == Iso6892Strength::Proof ? "Rp" : "Rt")
+                             .arg(st.percent)
+                             .arg(st.stress, 0, 'f', 1);
+    }
+    ui->leRp02->setToolTip(strengths.join('\n'));
+}
+
+void Iso6892Form::offerJournalRecovery()
+{
+    const QString path = TestJournal::findUnfinished();
+    if (path.isEmpty())
+        return;
+
+    TestJournal::Recovered rec;
+    QString error;
+    if (!TestJournal::read(path, &rec, &error) || rec.samples.isEmpty()) {
+        TestJournal::seal(path);
+        return;
+    }
+    const QString started = QDateTime::fromMSecsSinceEpoch(rec.header.startedMsecs)
+                                .toString("dd.MM.yyyy HH:mm:ss");
+    const auto answer = QMessageBox::question(this,
+                                              "Журнал испытания",
+                                              QString("Испытание от %1 было прервано (%2 отсчетов).\n"
+                                                      "Восстановить данные и пересчитать результаты?")
+                                                  .arg(started)
+                                                  .arg(rec.samples.size()));
+    // Журнал закрывается в любом случае, чтобы не спрашивать снова
+    TestJournal::seal(path);
+    if (answer != QMessageBox::Yes)
+        return;
+
+    // Тот же путь, что при испытании: тара из заголовка, каждый отсчет в анализ
+    using namespace EvoUnit;
+    m_currentS0 = SquareMillimeters(rec.header.areaS0);
+    m_forceOffset = KilogramsForce(rec.header.forceOffsetKgf);
+    m_extOffset = Millimeters(rec.header.extOffsetMm);
+    m_analyzer->setSpecimenParams(m_currentS0, Millimeters(rec.header.gaugeLengthL0));
+    m_analyzer->reset();
+    m_analyzer->reserve(rec.samples.size());
+    m_plot->setSpecimenParams(rec.header.areaS0, rec.header.gaugeLengthL0);
+    m_plot->resetPlot();
+    for (const MachineControl::Sample &s : rec.samples)
+        m_analyzer->addDataPoint(netForce(KilogramsForce(s.load)),
+                                 Millimeters(s.elongation) - m_extOffset);
+    if (rec.truncated || rec.lostSamples > 0)
+        qWarning() << "Iso6892Form: journal" << path << "truncated" << rec.truncated << "lost"
+                   << rec.lostSamples;
+
+    Iso6892Results res = m_analyzer->calculateResults();
+    displayResults(res);
+    m_plot->plotFinalAnalysis(res, m_analyzer->strainView(), m_analyzer->stressView());
 }
 
 void Iso6892Form::sendCommand(int cmd)
 {
-    m_machine->sendCommand((MachineControl::ControlBit) cmd, true);
-    QTimer::singleShot(500, [this, cmd]() {
-        if (m_machine->isConnected())
-            m_machine->sendCommand((MachineControl::ControlBit) cmd, false);
-    });
+    // Импульс ведет драйвер: перекрывающиеся нажатия не гоняются за общим словом
+    m_machine->pulseCommand((MachineControl::ControlBit) cmd, 500);
 }
 
 void Iso6892Form::replaceWidgetInGroupBox(QGroupBox *groupBox, QWidget *newWidget)
@@ -309,8 +537,8 @@ void Iso6892Form::on_btnCalcManual_clicked()
     double du = ui->sbDu->value();
     double lu = ui->sbLu->value();
 
-    double Z = m_analyzer->calculateZ(du);
-    double A = m_analyzer->calculateManualA(lu);
+    double Z = m_analyzer->calculateZ(EvoUnit::Millimeters(du));
+    double A = m_analyzer->calculateManualA(EvoUnit::Millimeters(lu));
 
     ui->label_ResZ->setText(QString("Z: %1 %").arg(Z, 0, 'f', 1));
     ui->label_ResA->setText(QString("A: %1 %").arg(A, 0, 'f', 1));
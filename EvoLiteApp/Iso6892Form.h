@@ -1,13 +1,15 @@
 #pragma once
 #include <QTimer>
 #include <QWidget>
+#include "EvoQuantity.h"
+#include "MachineControl.h"
 class QGroupBox;
 class QLCDNumber;
 
-class MachineControl;
 class Iso6892Analyzer;
 class Iso6892Results;
 class TensilePlotWidget;
+class TestJournal;
 
 namespace Ui {
 class Iso6892Form;
@@ -38,14 +40,15 @@ private slots:
     // --- Слоты от MachineControl ---
     void onMachineConnected();
     void onMachineDisconnected();
+    // Связь ухудшилась: испытание останавливается, пока СТОП еще доходит до ПЛК
+    void onLinkQualityChanged(MachineControl::LinkQuality quality);
 
-    // Получение сырых данных (сигналы MachineControl)
-    void onCurrentLoadChanged(float kgVal);
-    void onLengthChanged(float mmVal);
-    void onTestTimeChanhed(float sVal);
+    // Новые отсчеты в кольце драйвера: забираем все по порядку (каждый ровно один раз)
+    void onSamplesAvailable();
 
     // --- Таймер GUI ---
-    // Обновляет графики и цифры (независимо от частоты Modbus)
+    // Обновляет цифры по последнему отсчету и дорисовывает накопленные точки графика
+    // (сбор и анализ идут в onSamplesAvailable с полной частотой машины)
     void onGuiTimerTick();
 
 private:
@@ -56,29 +59,57 @@ private:
     // Логика анализа ISO 6892-1
     Iso6892Analyzer *m_analyzer;
 
-    // Драйвер машины
+    // Драйвер машины (живет в потоке опроса)
     MachineControl *m_machine;
 
+    // Журнал испытания на диске (свой поток и свой курсор в кольце)
+    TestJournal *m_journal;
+
+    // Свой курсор в кольце отсчетов: анализ не зависит от темпа других потребителей
+    MachineControl::SampleBuffer::Reader m_analysisReader;
+    QVector<MachineControl::Sample> m_readBuffer;
+    quint64 m_lostAtStart{0};
+    // Точки графика, накопленные с прошлого тика GUI (все отсчеты, не только последний)
+    QVector<QPointF> m_livePending;
+
     // Таймер для отрисовки (20-25 FPS)
     QTimer *m_guiTimer;
 
     // Состояние теста
     bool m_isTestRunning;
 
-    // Кэш последних данных с машины
-    double m_lastRawForceKg;
-    double m_lastRawExtMm;
+    // Последний отсчет с машины (контроллер передает силу в кгс)
+    EvoUnit::KilogramsForce m_lastRawForce;
+    EvoUnit::Millimeters m_lastRawExt;
     double m_lastTestTimeS;
 
-    // Смещение нуля (Tare)
-    double m_forceOffsetKg;
-    double m_extOffsetMm;
+    // Смещение нуля (Tare): робастная оценка из потока опроса
+    EvoUnit::KilogramsForce m_forceOffset;
+    EvoUnit::Millimeters m_extOffset;
+    // Мертвая зона индикатора силы: 3 СКО шума на момент обнуления
+    EvoUnit::KilogramsForce m_forceDeadband{0.05};
 
     // Текущая площадь сечения (для Live-расчета напряжения)
-    double m_currentS0;
+    EvoUnit::SquareMillimeters m_currentS0;
+
+    // Частота FIFO на время испытания (упругий участок длится секунды)
+    static constexpr quint16 BufferedRateHz = 1000;
+    // Период опроса снимками (ПЛК без FIFO)
+    static constexpr int SnapshotPollMs = 50;
+    // Частота отсчетов текущего испытания: FIFO или снимки
+    quint16 m_testRateHz{0};
 
     // Вспомогательные методы
+    EvoUnit::Newtons netForce(EvoUnit::KilogramsForce raw) const;
+    // Нуль по оценке драйвера (медиана окна); false - окно еще не набрано
+    bool applyTare();
+    // Конец испытания (СТОП, разрыв, потеря связи): дочитать кольцо, закрыть журнал,
+    // выйти из FIFO, посчитать и нарисовать итог. Команду СТОП не отправляет.
+    // completed = false - обрыв связи/отключение: журнал закрывается как прерванный
+    void finishTest(bool completed);
     void displayResults(const Iso6892Results &res);
+    // Журнал прерванного испытания (сбой, отключение питания): предложить пересчет
+    void offerJournalRecovery();
     void setupPlot();
     void sendCommand(int cmd);
 
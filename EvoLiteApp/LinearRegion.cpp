@@ -0,0 +1,108 @@
+#include "LinearRegion.h"
+#include <cmath>
+
+LinearRegion::LinearRegion(const SampleArena::View &x,
+                           const SampleArena::View &y,
+                           qint64 first,
+                           qint64 last)
+    : m_x(x)
+    , m_y(y)
+    , m_first(qMax(qint64(0), first))
+    , m_last(qMin(last, qMin(x.size(), y.size())))
+{
+    if (m_last <= m_first)
+        return;
+    double sx = 0, sy = 0;
+    for (qint64 i = m_first; i < m_last; ++i) {
+        sx += m_x[i];
+        sy += m_y[i];
+    }
+    m_cx = sx / double(m_last - m_first);
+    m_cy = sy / double(m_last - m_first);
+}
+
+LinearRegion::Fit LinearRegion::solve(const Sums &a, const Sums &b) const
+{
+    Fit f;
+    const double n = b.n - a.n;
+    if (n < 3)
+        return f;
+    const double sx = b.sx - a.sx;
+    const double sy = b.sy - a.sy;
+    const double dxx = (b.sxx - a.sxx) - sx * sx / n;
+    const double dxy = (b.sxy - a.sxy) - sx * sy / n;
+    const double dyy = (b.syy - a.syy) - sy * sy / n;
+    if (dxx <= 0 || dyy <= 0)
+        return f;
+
+    f.slope = dxy / dxx;
+    // Центр возвращаем: y - cy = k (x - cx) + b0
+    f.intercept = (sy - f.slope * sx) / n + m_cy - f.slope * m_cx;
+    f.r2 = (dxy * dxy) / (dxx * dyy);
+    f.valid = true;
+    return f;
+}
+
+LinearRegion::Fit LinearRegion::fit(qint64 from, qint64 to) const
+{
+    from = qMax(from, m_first);
+    to = qMin(to, m_last);
+    Sums s;
+    double lo = 0, hi = 0;
+    for (qint64 i = from; i < to; ++i) {
+        add(s, i);
+        lo = (i == from) ? m_y[i] : qMin(lo, m_y[i]);
+        hi = (i == from) ? m_y[i] : qMax(hi, m_y[i]);
+    }
+    Fit f = solve(Sums(), s);
+    f.from = from;
+    f.to = to;
+    f.yLow = lo;
+    f.yHigh = hi;
+    return f;
+}
+
+LinearRegion::Fit LinearRegion::best(double yMax,
+                                     std::initializer_list<double> bands,
+                                     double minY,
+                                     int minPoints) const
+{
+    Fit best;
+    if (yMax <= 0 || m_last - m_first < minPoints)
+        return best;
+
+    for (const double band : bands) {
+        const double height = band * yMax;
+        // pi - суммы [first, i), pj - суммы [first, j); огибающие - максимум y до указателя
+        Sums pi, pj;
+        double envI = -INFINITY, envJ = -INFINITY;
+        qint64 j = m_first;
+        for (qint64 i = m_first; i < m_last; ++i) {
+            envI = qMax(envI, m_y[i]);
+            const double top = envI + height;
+            if (top > yMax)
+                break; // Дальше окна выходят за максимум кривой
+            if (envI >= minY) {
+                while (j < m_last && (j <= i || envJ < top)) {
+                    envJ = qMax(envJ, m_y[j]);
+                    add(pj, j);
+                    ++j;
+                }
+                if (envJ < top)
+                    break; // Данные кончились раньше полосы
+                if (j - i >= minPoints) {
+                    Fit f = solve(pi, pj);
+                    if (f.valid && f.slope > 0 && f.r2 > best.r2) {
+                        f.from = i;
+                        f.to = j;
+                        f.yLow = envI;
+                        f.yHigh = envJ;
+                        best = f;
+                    }
+                }
+            }
+            add(pi, i);
+        }
+    }
+    return best;
+}
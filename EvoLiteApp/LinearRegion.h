@@ -0,0 +1,67 @@
+#pragma once
+
+#include <initializer_list>
+#include "SampleArena.h"
+
+// Поиск самого линейного участка кривой y(x) на отрезке точек [first, last).
+// Кандидаты - окна, покрывающие по y полосу заданной ширины (доля от yMax);
+// окно начинается в каждой точке, конец ищется вторым указателем по огибающей y.
+// Суммы окна - разность двух префиксных сумм, которые ведут сами указатели,
+// поэтому один проход по полосе - O(n) и без дополнительных массивов.
+// Окна ранжируются по R².
+class LinearRegion
+{
+public:
+    struct Fit
+    {
+        double slope{0.0};
+        double intercept{0.0};
+        double r2{0.0};
+        qint64 from{0}; // Окно [from, to)
+        qint64 to{0};
+        double yLow{0.0}; // Границы окна по y (по огибающей)
+        double yHigh{0.0};
+        bool valid{false};
+    };
+
+    LinearRegion(const SampleArena::View &x,
+                 const SampleArena::View &y,
+                 qint64 first,
+                 qint64 last);
+
+    // МНК по точкам [from, to) - O(to - from)
+    Fit fit(qint64 from, qint64 to) const;
+
+    // Лучшее окно среди полос bands (доли от yMax); начало окна - не ниже minY
+    Fit best(double yMax,
+             std::initializer_list<double> bands = {0.15, 0.2, 0.3},
+             double minY = 0.0,
+             int minPoints = 10) const;
+
+private:
+    // Суммы по центрированным точкам (центр - средние отрезка): меньше потеря
+    // точности при вычитании больших префиксных сумм
+    struct Sums
+    {
+        double n{0}, sx{0}, sy{0}, sxx{0}, sxy{0}, syy{0};
+        void add(double x, double y)
+        {
+            n += 1;
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+            syy += y * y;
+        }
+    };
+
+    SampleArena::View m_x;
+    SampleArena::View m_y;
+    qint64 m_first;
+    qint64 m_last;
+    double m_cx{0.0};
+    double m_cy{0.0};
+
+    void add(Sums &s, qint64 i) const { s.add(m_x[i] - m_cx, m_y[i] - m_cy); }
+    Fit solve(const Sums &a, const Sums &b) const; // Окно = b - a
+};
@@ -1,36 +1,25 @@
 #include "MachineControl.h"
 #include <QDebug>
 #include <QModbusReply>
+#include <QModbusRequest>
 #include <QModbusRtuSerialMaster>
 #include <QModbusTcpClient>
 #include <QSerialPort>
 #include <QTimer>
+#include <memory>
 
-// Адреса Holding (RW)
-namespace RegRW {
-const int Control = 0;
-const int SpeedMmMin = 2;
-const int MoveByX = 3;
-const int MoveToX = 5;
-const int EncoderPls = 7;
-const int MotorRevs = 8;
-const int ScrewMm = 9;
-const int SensorRange = 10;
-const int Sensitivity = 12;
-const int MaxError = 13;
-const int TestSpeed = 15;
-const int ManualSpeed = 16;
-} // namespace RegRW
-
-// Адреса Input (RO)
-namespace RegRO {
-const int CurrentPos = 0;
-const int CurrentLoad = 2;
-const int TestTime = 4;
-const int LengthStart = 6;
-const int MaxLoad = 8;
-const int TotalCount = 10;
-} // namespace RegRO
+// Окно FIFO в Input-регистрах, начиная с поля fifoHead карты (base):
+//   [base..base+1] seq последнего записанного отсчета (u32, порядок слов - по карте)
+//   [base+2]       глубина кольца (слотов), 0 - ПЛК не поддерживает режим
+//   [base+3]       период отсчетов, мкс
+//   [base+4..]     слоты по 9 регистров: seq (младшие 16 бит), time, pos, load, elong (float)
+// Отсчет seq лежит в слоте seq % depth.
+namespace RegFifo {
+const int HeaderCount = 4;
+const int SlotRegs = 9;
+const int MaxSlotsPerRead = 125 / SlotRegs; // Лимит PDU: 125 регистров на чтение
+const quint32 GuardSlots = 4; // Запас: пока идет чтение, ПЛК продолжает писать
+} // namespace RegFifo
 
 MachineControl::MachineControl(QObject *parent)
     : QObject(parent)
@@ -40,11 +29,19 @@ MachineControl::MachineControl(QObject *parent)
 {
     m_pollTimer = new QTimer(this);
     connect(m_pollTimer, &QTimer::timeout, this, &MachineControl::doPoll);
+    m_watchdogTimer = new QTimer(this);
+    connect(m_watchdogTimer, &QTimer::timeout, this, &MachineControl::onWatchdog);
+    m_clock.start();
+    qRegisterMetaType<MachineControl::Sample>();
+    qRegisterMetaType<MachineControl::Params>();
+    qRegisterMetaType<MachineControl::LinkQuality>();
+    m_paramMirror.resize(m_map.paramSpan().count);
 }
 
 MachineControl::~MachineControl()
 {
-    disconnectDevice();
+    // Поток драйвера к этому моменту может быть уже остановлен - без очередей
+    releaseDevice();
     if (m_modbusDevice)
         m_modbusDevice->deleteLater();
 }
@@ -52,6 +49,16 @@ MachineControl::~MachineControl()
 // === ПОДКЛЮЧЕНИЕ RTU (SERIAL) ===
 bool MachineControl::connectRTU(const QString &portName, int baudRate, int serverAddress)
 {
+    // Устройство создается в потоке драйвера, вызывающий ждет результат
+    if (QThread::currentThread() != thread()) {
+        bool ok = false;
+        QMetaObject::invokeMethod(
+            this,
+            [&]() { ok = connectRTU(portName, baudRate, serverAddress); },
+            Qt::BlockingQueuedConnection);
+        return ok;
+    }
+
     disconnectDevice(); // Сначала отключаем и удаляем старое устройство
 
     // Создаем RTU мастер
@@ -68,7 +75,8 @@ bool MachineControl::connectRTU(const QString &portName, int baudRate, int serve
                                            QSerialPort::OneStop);
 
     m_modbusDevice->setTimeout(1000);
-    m_modbusDevice->setNumberOfRetries(3);
+    // Повтор чтения - следующий опрос, записи повторяет retryWrite; таймаут виден сторожу
+    m_modbusDevice->setNumberOfRetries(0);
 
     m_serverAddress = serverAddress;
 
@@ -78,6 +86,15 @@ bool MachineControl::connectRTU(const QString &portName, int baudRate, int serve
 // === ПОДКЛЮЧЕНИЕ TCP (ETHERNET) ===
 bool MachineControl::connectTCP(const QString &ip, int port, int serverAddress)
 {
+    if (QThread::currentThread() != thread()) {
+        bool ok = false;
+        QMetaObject::invokeMethod(
+            this,
+            [&]() { ok = connectTCP(ip, port, serverAddress); },
+            Qt::BlockingQueuedConnection);
+        return ok;
+    }
+
     disconnectDevice(); // Сначала отключаем и удаляем старое устройство
 
     // Создаем TCP клиент
@@ -88,7 +105,8 @@ bool MachineControl::connectTCP(const QString &ip, int port, int serverAddress)
     m_modbusDevice->setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
 
     m_modbusDevice->setTimeout(1000);
-    m_modbusDevice->setNumberOfRetries(3);
+    // Повтор чтения - следующий опрос, записи повторяет retryWrite; таймаут виден сторожу
+    m_modbusDevice->setNumberOfRetries(0);
 
     // В Modbus TCP serverAddress (Unit ID) тоже используется, если за TCP стоит шлюз,
     // или для идентификации устройства. Если устройство "чистый" TCP, часто это 1 или 255.
@@ -111,7 +129,22 @@ void MachineControl::initDeviceSignals()
 
 void MachineControl::disconnectDevice()
 {
-    stopPolling();
+    // Синхронно: после возврата устройство гарантированно удалено
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this]() { disconnectDevice(); }, Qt::BlockingQueuedConnection);
+        return;
+    }
+    releaseDevice();
+}
+
+void MachineControl::releaseDevice()
+{
+    m_pollTimer->stop();
+    m_watchdogTimer->stop();
+    m_inFlight = 0;
+    resetFifo();
+    dropPendingWrites();
+    m_paramKnown = 0; // Другой ПЛК или перезапуск - зеркало недействительно
     if (m_modbusDevice) {
         if (m_modbusDevice->state() == QModbusDevice::ConnectedState)
             m_modbusDevice->disconnectDevice();
@@ -120,128 +153,738 @@ void MachineControl::disconnectDevice()
         delete m_modbusDevice;
         m_modbusDevice = nullptr;
     }
+    m_connected = false;
+    setLinkQuality(LinkLost);
 }
 
 bool MachineControl::isConnected() const
 {
-    return m_modbusDevice && m_modbusDevice->state() == QModbusDevice::ConnectedState;
+    return m_connected.load();
+}
+
+void MachineControl::setRegisterMap(const RegisterMap &map)
+{
+    if (postToOwnThread([=]() { setRegisterMap(map); }))
+        return;
+    // Очередь и FIFO относятся к старой раскладке
+    resetFifo();
+    dropPendingWrites();
+    m_map = map;
+    m_fifoSupported = m_map.has(RegisterMap::FifoRate) && m_map.has(RegisterMap::FifoHead);
+    m_paramMirror.fill(0, m_map.paramSpan().count);
+    m_paramKnown = 0;
 }
 
 void MachineControl::onStateChanged(int state)
 {
-    if (state == QModbusDevice::ConnectedState)
+    m_connected = (state == QModbusDevice::ConnectedState);
+    if (state == QModbusDevice::ConnectedState) {
+        // Новая сессия - статистика с нуля, отсчет сторожа от момента подключения
+        {
+            QMutexLocker lock(&m_statsMutex);
+            m_link = {};
+        }
+        m_lastReplyUs = m_clock.nsecsElapsed() / 1000;
+        m_lastSampleUs = 0;
+        m_failStreak = 0;
+        m_inFlight = 0;
+        setLinkQuality(LinkGood);
+        m_watchdogTimer->start(qBound(10, m_heartbeatMs / 5, 100));
         emit connected();
-    else if (state == QModbusDevice::UnconnectedState)
+    } else if (state == QModbusDevice::UnconnectedState) {
+        m_watchdogTimer->stop();
+        resetFifo();
+        setLinkQuality(LinkLost);
         emit disconnected();
+    }
+}
+
+// =========================================================================
+// СТОРОЖ СВЯЗИ
+// =========================================================================
+void MachineControl::setWatchdog(int heartbeatMs, int degradedMs, int lostMs)
+{
+    if (postToOwnThread([=]() { setWatchdog(heartbeatMs, degradedMs, lostMs); }))
+        return;
+    m_heartbeatMs = qMax(10, heartbeatMs);
+    m_degradedMs = qMax(m_heartbeatMs, degradedMs);
+    m_lostMs = qMax(m_degradedMs, lostMs);
+    if (m_watchdogTimer->isActive())
+        m_watchdogTimer->start(qBound(10, m_heartbeatMs / 5, 100));
+}
+
+MachineControl::LinkStats MachineControl::linkStats() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    LinkStats stats = m_link;
+    stats.lastReplyAgeMs = (m_clock.nsecsElapsed() / 1000 - m_lastReplyUs) / 1000;
+    return stats;
+}
+
+// Каждый запрос к ПЛК проходит здесь: RTT, таймауты, время последнего ответа
+void MachineControl::trackReply(QModbusReply *reply)
+{
+    const qint64 sentUs = m_clock.nsecsElapsed() / 1000;
+    ++m_inFlight;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        ++m_link.requests;
+        if (m_failStreak > 0)
+            ++m_link.retries;
+    }
+    connect(reply, &QModbusReply::finished, this, [this, reply, sentUs]() {
+        onTrackedReply(sentUs, reply->error());
+    });
+}
+
+void MachineControl::onTrackedReply(qint64 sentUs, int error)
+{
+    m_inFlight = qMax(0, m_inFlight - 1);
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    // Исключение Modbus (ProtocolError) - тоже ответ: ПЛК жив, связь в порядке
+    const bool alive = error == QModbusDevice::NoError || error == QModbusDevice::ProtocolError;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        if (alive) {
+            const qint64 rtt = now - sentUs;
+            ++m_link.replies;
+            m_link.lastRttUs = rtt;
+            m_link.avgRttUs = m_link.avgRttUs == 0 ? rtt
+                                                   : m_link.avgRttUs + (rtt - m_link.avgRttUs) / 8;
+            m_link.maxRttUs = qMax(m_link.maxRttUs, rtt);
+        } else if (error == QModbusDevice::TimeoutError) {
+            ++m_link.timeouts;
+        } else {
+            ++m_link.errors;
+        }
+    }
+    if (alive) {
+        m_lastReplyUs = now;
+        m_failStreak = 0;
+    } else {
+        ++m_failStreak;
+    }
+    updateLinkQuality();
+}
+
+void MachineControl::onWatchdog()
+{
+    if (!isConnected())
+        return;
+    // Опрос остановлен (или ответы не идут): проверяем связь сами, по одному запросу
+    const qint64 idleMs = (m_clock.nsecsElapsed() / 1000 - m_lastReplyUs) / 1000;
+    if (idleMs >= m_heartbeatMs && m_inFlight == 0)
+        sendHeartbeat();
+    updateLinkQuality();
+}
+
+void MachineControl::sendHeartbeat()
+{
+    // Самый дешевый запрос: эхо команд, иначе само управляющее слово
+    const bool echo = m_map.has(RegisterMap::CmdEcho);
+    QModbusDataUnit unit(echo ? QModbusDataUnit::InputRegisters : QModbusDataUnit::HoldingRegisters,
+                         m_map.address(echo ? RegisterMap::CmdEcho : RegisterMap::Control),
+                         1);
+    auto *reply = m_modbusDevice->sendReadRequest(unit, m_serverAddress);
+    if (!reply)
+        return;
+    if (reply->isFinished()) {
+        delete reply;
+        return;
+    }
+    trackReply(reply);
+    connect(reply, &QModbusReply::finished, reply, &QModbusReply::deleteLater);
+}
+
+void MachineControl::updateLinkQuality()
+{
+    if (!isConnected()) {
+        setLinkQuality(LinkLost);
+        return;
+    }
+    const qint64 idleMs = (m_clock.nsecsElapsed() / 1000 - m_lastReplyUs) / 1000;
+    if (idleMs >= m_lostMs)
+        setLinkQuality(LinkLost);
+    else if (idleMs >= m_degradedMs || m_failStreak >= DegradedFailures)
+        setLinkQuality(LinkDegraded);
+    else
+        setLinkQuality(LinkGood);
+}
+
+void MachineControl::setLinkQuality(LinkQuality quality)
+{
+    if (quality == m_quality)
+        return;
+    m_quality = quality;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        m_link.quality = quality;
+    }
+    emit linkQualityChanged(quality);
 }
 
 // --- ДАЛЕЕ КОД БЕЗ ИЗМЕНЕНИЙ (ЛОГИКА ОДИНАКОВА ДЛЯ TCP И RTU) ---
 
 void MachineControl::sendCommand(ControlBit bit, bool state)
 {
+    // Управляющее слово меняется только в потоке драйвера
+    if (postToOwnThread([=]() { sendCommand(bit, state); }))
+        return;
+    if (!isConnected())
+        return;
+    const int wordBit = m_map.bit(RegisterMap::Bit(bit));
+    if (wordBit < 0 || !m_map.has(RegisterMap::Control)) {
+        emit errorOccurred(tr("Command %1 is not supported by register map").arg(int(bit)));
+        return;
+    }
+
+    // Локальная копия слова - только для справки, в ПЛК меняется один бит
+    const quint16 mask = quint16(1u << wordBit);
     if (state)
-        m_currentControlWord |= (1 << bit);
+        m_currentControlWord |= mask;
     else
-        m_currentControlWord &= ~(1 << bit);
-    writeRegister(RegRW::Control, m_currentControlWord);
+        m_currentControlWord &= ~mask;
+
+    PendingWrite w;
+    w.address = m_map.address(RegisterMap::Control);
+    w.isMask = true;
+    w.andMask = quint16(~mask);
+    w.orMask = state ? mask : 0;
+    w.bit = bit;
+    w.state = state;
+
+    const bool isStop = state && (bit == BitStop || bit == BitStopMMMode);
+    enqueueWrite(isStop ? LaneStop : LaneNormal, w);
+}
+
+void MachineControl::pulseCommand(ControlBit bit, int holdMs)
+{
+    if (postToOwnThread([=]() { pulseCommand(bit, holdMs); }))
+        return;
+
+    const quint32 gen = ++m_pulseGen[bit];
+    sendCommand(bit, true);
+    QTimer::singleShot(holdMs, this, [this, bit, gen]() {
+        // Бит уже перезапущен новым импульсом - снимет его тот таймер
+        if (m_pulseGen[bit] == gen)
+            sendCommand(bit, false);
+    });
 }
 
 void MachineControl::setFullControlWord(quint16 word)
 {
+    if (postToOwnThread([=]() { setFullControlWord(word); }))
+        return;
+    if (!isConnected() || !m_map.has(RegisterMap::Control))
+        return;
     m_currentControlWord = word;
-    writeRegister(RegRW::Control, m_currentControlWord);
+
+    PendingWrite w;
+    w.address = m_map.address(RegisterMap::Control);
+    w.values = {word};
+    enqueueWrite(LaneNormal, w);
 }
 
 void MachineControl::setSpeedMmMin(quint16 value)
 {
-    writeRegister(RegRW::SpeedMmMin, value);
+    writeField(RegisterMap::SpeedMmMin, value);
 }
 void MachineControl::setMoveByX(float value)
 {
-    writeFloat(RegRW::MoveByX, value);
+    writeField(RegisterMap::MoveByX, value);
 }
 void MachineControl::setMoveToX(float value)
 {
-    writeFloat(RegRW::MoveToX, value);
+    writeField(RegisterMap::MoveToX, value);
 }
 void MachineControl::setEncoderPulses(quint16 value)
 {
-    writeRegister(RegRW::EncoderPls, value);
+    writeField(RegisterMap::EncoderPulses, value);
 }
 void MachineControl::setMotorRevs(quint16 value)
 {
-    writeRegister(RegRW::MotorRevs, value);
+    writeField(RegisterMap::MotorRevs, value);
 }
 void MachineControl::setScrewMmRev(quint16 value)
 {
-    writeRegister(RegRW::ScrewMm, value);
+    writeField(RegisterMap::ScrewMmRev, value);
 }
 void MachineControl::setSensorRange(float value)
 {
-    writeFloat(RegRW::SensorRange, value);
+    writeField(RegisterMap::SensorRange, value);
 }
 void MachineControl::setSensitivity(quint16 value)
 {
-    writeRegister(RegRW::Sensitivity, value);
+    writeField(RegisterMap::Sensitivity, value);
 }
 void MachineControl::setMaxError(float value)
 {
-    writeFloat(RegRW::MaxError, value);
+    writeField(RegisterMap::MaxError, value);
 }
 void MachineControl::setTestSpeed(quint16 value)
 {
-    writeRegister(RegRW::TestSpeed, value);
+    writeField(RegisterMap::TestSpeed, value);
 }
 void MachineControl::setManualSpeed(quint16 value)
 {
-    writeRegister(RegRW::ManualSpeed, value);
+    writeField(RegisterMap::ManualSpeed, value);
 }
 
-void MachineControl::writeRegister(int address, quint16 value)
+void MachineControl::writeField(RegisterMap::Field field,
+                                double value,
+                                std::function<void(bool)> done)
 {
-    if (!isConnected())
+    // Все сеттеры параметров сходятся сюда: адрес и тип (u16/f32/...) - из карты
+    if (postToOwnThread([=]() { writeField(field, value, done); }))
+        return;
+    if (!isConnected()) {
+        if (done)
+            done(false);
+        return;
+    }
+    const RegisterMap::Entry &e = m_map.entry(field);
+    if (!e.isValid()) {
+        emit errorOccurred(tr("Parameter %1 is not supported by register map")
+                               .arg(QString::fromLatin1(RegisterMap::fieldName(field))));
+        if (done)
+            done(false);
         return;
-    QModbusDataUnit writeUnit(QModbusDataUnit::HoldingRegisters, address, 1);
-    writeUnit.setValue(0, value);
+    }
+    forgetParams(e.address, e.size()); // Без чтения обратно значение в ПЛК не подтверждено
 
-    if (auto *reply = m_modbusDevice->sendWriteRequest(writeUnit, m_serverAddress)) {
-        if (!reply->isFinished()) {
-            connect(reply, &QModbusReply::finished, reply, &QObject::deleteLater);
-        } else {
-            reply->deleteLater();
+    PendingWrite w;
+    w.address = e.address;
+    w.values.resize(e.size());
+    m_map.encode(field, value, w.values.data());
+    w.done = std::move(done);
+    enqueueWrite(LaneNormal, w);
+}
+
+// =========================================================================
+// ПЛАНИРОВЩИК ЗАПИСИ
+// =========================================================================
+// В ПЛК одновременно не более одной записи из общей очереди (порядок сохраняется),
+// кроме СТОП: он уходит сразу. Опросы чтения идут независимо.
+void MachineControl::enqueueWrite(Lane lane, PendingWrite w)
+{
+    w.queuedUs = m_clock.nsecsElapsed() / 1000;
+
+    if (lane == LaneStop) {
+        // Не отправленные команды движения после СТОП только навредят;
+        // прочие биты (зажим, режимы) остаются в очереди
+        auto &queue = m_lanes[LaneNormal];
+        for (int i = queue.size() - 1; i >= 0; --i) {
+            const PendingWrite &q = queue.at(i);
+            if (q.isMask && q.state && isMotionBit(q.bit))
+                queue.removeAt(i);
         }
+        sendWrite(w, false);
+        return;
+    }
+
+    // Повтор той же команды (удержание кнопки) или того же параметра заменяет
+    // еще не отправленную запись, а не растит очередь. Для бита сравнивается
+    // последняя запись этого бита и только в том же состоянии: снятие импульса
+    // не должно затирать его неотправленную установку.
+    auto &queue = m_lanes[lane];
+    for (int i = queue.size() - 1; i >= 0; --i) {
+        PendingWrite &q = queue[i];
+        if (w.isMask && q.isMask && q.bit == w.bit) {
+            if (q.state != w.state)
+                break;
+            q = w;
+            pumpWrites();
+            return;
+        }
+        const bool sameRegs = !w.isMask && !q.isMask && q.address == w.address
+                              && q.values.size() == w.values.size() && !q.done && !w.done;
+        if (sameRegs) {
+            q = w;
+            pumpWrites();
+            return;
+        }
+    }
+    queue.enqueue(w);
+    pumpWrites();
+}
+
+void MachineControl::pumpWrites()
+{
+    if (m_writeInFlight || !isConnected())
+        return;
+    for (auto &queue : m_lanes) {
+        if (!queue.isEmpty()) {
+            sendWrite(queue.dequeue(), true);
+            return;
+        }
+    }
+}
+
+void MachineControl::sendWrite(const PendingWrite &w, bool gated)
+{
+    QModbusReply *reply = nullptr;
+    if (w.isMask) {
+        // FC22: result = (current AND andMask) OR (orMask AND NOT andMask)
+        QModbusRequest request(QModbusRequest::MaskWriteRegister,
+                               quint16(w.address),
+                               w.andMask,
+                               w.orMask);
+        reply = m_modbusDevice->sendRawRequest(request, m_serverAddress);
     } else {
+        QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, w.address, w.values);
+        reply = m_modbusDevice->sendWriteRequest(unit, m_serverAddress);
+    }
+
+    if (!reply) {
         emit errorOccurred(tr("Write error: ") + m_modbusDevice->errorString());
+        m_lastWriteError = m_modbusDevice->error();
+        if (retryWrite(w, gated))
+            return;
+        if (isStopWrite(w))
+            emit stopNotDelivered(w.bit);
+        if (w.done)
+            w.done(false);
+        if (gated)
+            pumpWrites();
+        return;
     }
+
+    {
+        QMutexLocker lock(&m_statsMutex);
+        ++m_stats.sent;
+    }
+    if (w.bit >= 0 && m_map.has(RegisterMap::CmdEcho)) {
+        // Ждем подтверждения бита; более старое ожидание того же бита уже неактуально
+        for (int i = m_pendingAcks.size() - 1; i >= 0; --i) {
+            if (m_pendingAcks.at(i).bit == w.bit)
+                m_pendingAcks.removeAt(i);
+        }
+        m_pendingAcks.append({w.bit, w.state, w.queuedUs});
+    }
+
+    if (reply->isFinished()) {
+        onWriteFinished(reply, w, gated);
+        return;
+    }
+    if (gated)
+        m_writeInFlight = true;
+    trackReply(reply);
+    connect(reply, &QModbusReply::finished, this, [this, reply, w, gated]() {
+        onWriteFinished(reply, w, gated);
+    });
 }
 
-void MachineControl::writeFloat(int address, float value)
+void MachineControl::onWriteFinished(QModbusReply *reply, const PendingWrite &w, bool gated)
 {
-    if (!isConnected())
+    reply->deleteLater();
+    m_lastWriteError = reply->error();
+    const bool ok = m_lastWriteError == QModbusDevice::NoError;
+    if (!ok) {
+        emit errorOccurred(tr("Write error: ") + reply->errorString());
+        if (retryWrite(w, gated))
+            return; // Очередь держим: порядок записей сохраняется
+        if (isStopWrite(w))
+            emit stopNotDelivered(w.bit);
+    } else {
+        const qint64 us = m_clock.nsecsElapsed() / 1000 - w.queuedUs;
+        QMutexLocker lock(&m_statsMutex);
+        m_stats.lastWriteUs = us;
+        m_stats.maxWriteUs = qMax(m_stats.maxWriteUs, us);
+    }
+    // Запрос из done (чтение обратно) уходит раньше следующей записи очереди
+    if (w.done)
+        w.done(ok);
+    if (gated) {
+        m_writeInFlight = false;
+        pumpWrites();
+    }
+}
+
+bool MachineControl::retryWrite(const PendingWrite &w, bool gated)
+{
+    // Исключение Modbus - ПЛК ответил отказом, повтор ответа не изменит
+    if (m_lastWriteError == QModbusDevice::ProtocolError || !isConnected())
+        return false;
+    // СТОП - до успеха или до потери связи (сторож переводит в LinkLost)
+    const bool stop = isStopWrite(w) && m_quality != LinkLost;
+    if (w.attempt >= WriteRetries && !stop)
+        return false;
+
+    PendingWrite next = w;
+    ++next.attempt;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        ++m_stats.retried;
+    }
+    QTimer::singleShot(WriteRetryDelayMs, this, [this, next, gated, epoch = m_writeEpoch]() {
+        if (epoch != m_writeEpoch || !isConnected()) {
+            // Отключились, пока ждали: очередь уже разобрана dropPendingWrites
+            if (isStopWrite(next))
+                emit stopNotDelivered(next.bit);
+            if (next.done)
+                next.done(false);
+            return;
+        }
+        if (gated)
+            m_writeInFlight = false; // sendWrite займет очередь заново
+        sendWrite(next, gated);
+    });
+    return true;
+}
+
+void MachineControl::dropPendingWrites()
+{
+    // Незавершенные транзакции должны получить ответ, иначе вызывающий ждет вечно
+    for (auto &queue : m_lanes) {
+        const auto pending = queue;
+        queue.clear();
+        for (const auto &w : pending) {
+            if (w.done)
+                w.done(false);
+        }
+    }
+    m_writeInFlight = false;
+    ++m_writeEpoch;
+    m_pendingAcks.clear();
+}
+
+void MachineControl::requestStatus()
+{
+    if (!m_map.has(RegisterMap::CmdEcho))
+        return;
+    QModbusDataUnit unit(QModbusDataUnit::InputRegisters, m_map.address(RegisterMap::CmdEcho), 1);
+    auto *reply = m_modbusDevice->sendReadRequest(unit, m_serverAddress);
+    if (!reply)
+        return;
+    if (reply->isFinished()) {
+        delete reply;
         return;
-    QVector<quint16> values;
-    const quint8 *p = reinterpret_cast<const quint8 *>(&value);
-    quint16 r1 = (quint16(p[3]) << 8) | p[2];
-    quint16 r2 = (quint16(p[1]) << 8) | p[0];
-    values.append(r1);
-    values.append(r2);
+    }
+    trackReply(reply);
+    connect(reply, &QModbusReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (reply->error() == QModbusDevice::NoError && reply->result().valueCount() >= 1)
+            checkAcks(reply->result().value(0));
+    });
+}
 
-    QModbusDataUnit writeUnit(QModbusDataUnit::HoldingRegisters, address, values);
-    if (auto *reply = m_modbusDevice->sendWriteRequest(writeUnit, m_serverAddress)) {
-        connect(reply, &QModbusReply::finished, reply, &QObject::deleteLater);
+void MachineControl::checkAcks(quint16 echo)
+{
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    for (int i = m_pendingAcks.size() - 1; i >= 0; --i) {
+        const PendingAck a = m_pendingAcks.at(i);
+        const qint64 us = now - a.queuedUs;
+        const int wordBit = m_map.bit(RegisterMap::Bit(a.bit));
+        if (bool((echo >> wordBit) & 1) == a.state) {
+            m_pendingAcks.removeAt(i);
+            {
+                QMutexLocker lock(&m_statsMutex);
+                ++m_stats.acknowledged;
+                m_stats.lastAckUs = us;
+                m_stats.maxAckUs = qMax(m_stats.maxAckUs, us);
+                m_stats.sumAckUs += us;
+            }
+            emit commandAcknowledged(a.bit, a.state, us);
+        } else if (us > AckTimeoutMs * 1000) {
+            m_pendingAcks.removeAt(i);
+            {
+                QMutexLocker lock(&m_statsMutex);
+                ++m_stats.timedOut;
+            }
+            emit commandTimedOut(a.bit, a.state);
+        }
+    }
+}
+
+// =========================================================================
+// НАБОР ПАРАМЕТРОВ
+// =========================================================================
+void MachineControl::uploadParams(const Params &params, bool force)
+{
+    if (postToOwnThread([=]() { uploadParams(params, force); }))
+        return;
+    if (!isConnected()) {
+        emit paramsUploaded(false, {tr("Not connected")});
+        return;
+    }
+    const RegisterMap::Span block = m_map.paramSpan();
+    if (!block.isValid()) {
+        emit paramsUploaded(false, {tr("Not supported by register map")});
+        return;
+    }
+
+    // Пишем только участок от первого до последнего измененного регистра
+    const QVector<quint16> regs = encodeParams(params);
+    int first = -1;
+    int last = -1;
+    for (int i = 0; i < block.count; ++i) {
+        const bool known = (m_paramKnown >> i) & 1;
+        if (force || !known || m_paramMirror.at(i) != regs.at(i)) {
+            if (first < 0)
+                first = i;
+            last = i;
+        }
+    }
+    if (first < 0) {
+        emit paramsUploaded(true, {});
+        return;
+    }
+
+    PendingWrite w;
+    w.address = block.start + first;
+    w.values = regs.mid(first, last - first + 1);
+    w.done = [this, regs, block](bool ok) {
+        if (!ok) {
+            forgetParams(block.start, block.count);
+            emit paramsUploaded(false, {tr("Write failed")});
+            return;
+        }
+        verifyParams(regs);
+    };
+    enqueueWrite(LaneNormal, w);
+}
+
+void MachineControl::readParams()
+{
+    if (postToOwnThread([this]() { readParams(); }))
+        return;
+    verifyParams({});
+}
+
+// Чтение блока обратно: обновляет зеркало; если expected задан - сверка для uploadParams
+void MachineControl::verifyParams(const QVector<quint16> &expected)
+{
+    const bool verify = !expected.isEmpty();
+    const RegisterMap::Span block = m_map.paramSpan();
+    QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, block.start, quint16(block.count));
+    auto *reply = (isConnected() && block.isValid())
+                      ? m_modbusDevice->sendReadRequest(unit, m_serverAddress)
+                      : nullptr;
+    if (!reply) {
+        if (verify)
+            emit paramsUploaded(false, {tr("Read-back failed")});
+        return;
+    }
+    auto onFinished = [this, reply, expected, verify, block]() {
+        reply->deleteLater();
+        const QModbusDataUnit result = reply->result();
+        // Карта могла смениться, пока ждали ответ
+        if (block.start != m_map.paramSpan().start || block.count != m_map.paramSpan().count)
+            return;
+        if (reply->error() != QModbusDevice::NoError || result.valueCount() < uint(block.count)) {
+            emit errorOccurred(tr("Parameter read error: ") + reply->errorString());
+            if (verify)
+                emit paramsUploaded(false, {tr("Read-back failed")});
+            return;
+        }
+
+        const QVector<quint16> actual = result.values();
+        m_paramMirror = actual.mid(0, block.count);
+        m_paramKnown = block.count >= 32 ? ~0u : (1u << block.count) - 1;
+
+        if (!verify) {
+            emit paramsRead(decodeParams(m_paramMirror));
+            return;
+        }
+        QStringList mismatches;
+        for (RegisterMap::Field f : RegisterMap::ParamFields) {
+            const RegisterMap::Entry &e = m_map.entry(f);
+            if (!e.isValid())
+                continue;
+            const int i = e.address - block.start;
+            for (int k = 0; k < e.size(); ++k) {
+                if (actual.at(i + k) != expected.at(i + k)) {
+                    mismatches.append(QString::fromLatin1(RegisterMap::fieldName(f)));
+                    break;
+                }
+            }
+        }
+        emit paramsUploaded(mismatches.isEmpty(), mismatches);
+    };
+    if (reply->isFinished()) {
+        onFinished();
     } else {
-        emit errorOccurred(tr("Write float error: ") + m_modbusDevice->errorString());
+        trackReply(reply);
+        connect(reply, &QModbusReply::finished, this, onFinished);
+    }
+}
+
+void MachineControl::forgetParams(int address, int count)
+{
+    const RegisterMap::Span block = m_map.paramSpan();
+    for (int a = address; a < address + count; ++a) {
+        const int i = a - block.start;
+        if (i >= 0 && i < block.count)
+            m_paramKnown &= ~(1u << i);
     }
 }
 
+QVector<quint16> MachineControl::encodeParams(const Params &p) const
+{
+    const RegisterMap::Span block = m_map.paramSpan();
+    QVector<quint16> regs(block.count, 0);
+    // Поле, которого нет в карте, не пишется
+    auto put = [&](RegisterMap::Field f, double value) {
+        if (m_map.has(f))
+            m_map.encode(f, value, regs.data() + m_map.address(f) - block.start);
+    };
+    put(RegisterMap::SpeedMmMin, p.speedMmMin);
+    put(RegisterMap::MoveByX, p.moveByX);
+    put(RegisterMap::MoveToX, p.moveToX);
+    put(RegisterMap::EncoderPulses, p.encoderPulses);
+    put(RegisterMap::MotorRevs, p.motorRevs);
+    put(RegisterMap::ScrewMmRev, p.screwMmRev);
+    put(RegisterMap::SensorRange, p.sensorRange);
+    put(RegisterMap::Sensitivity, p.sensitivity);
+    put(RegisterMap::MaxError, p.maxError);
+    put(RegisterMap::TestSpeed, p.testSpeed);
+    put(RegisterMap::ManualSpeed, p.manualSpeed);
+    return regs;
+}
+
+MachineControl::Params MachineControl::decodeParams(const QVector<quint16> &regs) const
+{
+    const RegisterMap::Span block = m_map.paramSpan();
+    auto get = [&](RegisterMap::Field f) {
+        const int i = m_map.address(f) - block.start;
+        if (!m_map.has(f) || i + m_map.entry(f).size() > regs.size())
+            return 0.0;
+        return m_map.decode(f, regs.constData() + i);
+    };
+    Params p;
+    p.speedMmMin = quint16(get(RegisterMap::SpeedMmMin));
+    p.moveByX = float(get(RegisterMap::MoveByX));
+    p.moveToX = float(get(RegisterMap::MoveToX));
+    p.encoderPulses = quint16(get(RegisterMap::EncoderPulses));
+    p.motorRevs = quint16(get(RegisterMap::MotorRevs));
+    p.screwMmRev = quint16(get(RegisterMap::ScrewMmRev));
+    p.sensorRange = float(get(RegisterMap::SensorRange));
+    p.sensitivity = quint16(get(RegisterMap::Sensitivity));
+    p.maxError = float(get(RegisterMap::MaxError));
+    p.testSpeed = quint16(get(RegisterMap::TestSpeed));
+    p.manualSpeed = quint16(get(RegisterMap::ManualSpeed));
+    return p;
+}
+
+MachineControl::CommandStats MachineControl::commandStats() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_stats;
+}
+
 void MachineControl::startPolling(int intervalMs)
 {
+    // Таймер опроса принадлежит потоку драйвера
+    if (postToOwnThread([=]() { startPolling(intervalMs); }))
+        return;
     if (!m_pollTimer->isActive())
         m_pollTimer->start(intervalMs);
 }
 
 void MachineControl::stopPolling()
 {
+    if (postToOwnThread([this]() { stopPolling(); }))
+        return;
     m_pollTimer->stop();
 }
 
@@ -249,40 +892,378 @@ void MachineControl::doPoll()
 {
     if (!isConnected())
         return;
-    // Опрос Input Registers (0-9)
-    QModbusDataUnit readUnit(QModbusDataUnit::InputRegisters, RegRO::CurrentPos, RegRO::TotalCount);
+    // Отсчеты идут либо из FIFO, либо снимками - два потока не смешиваются
+    if (isBufferedMode()) {
+        if (!m_fifoBusy)
+            requestFifoHeader();
+        // Снимки не читаются - эхо команд запрашиваем отдельно, пока его ждем
+        if (!m_pendingAcks.isEmpty())
+            requestStatus();
+        return;
+    }
 
-    if (auto *reply = m_modbusDevice->sendReadRequest(readUnit, m_serverAddress)) {
-        if (!reply->isFinished())
-            connect(reply, &QModbusReply::finished, this, &MachineControl::onReadReady);
-        else
+    // Снимок по скомпилированному плану карты: обычно один блок, при разнесенных
+    // полях - несколько. Отсчет собирается, когда пришли все блоки опроса.
+    const RegisterMap::ReadPlan &plan = m_map.snapshotPlan();
+    if (plan.blocks.isEmpty())
+        return;
+    struct Pending
+    {
+        QVector<QVector<quint16>> blocks;
+        int remaining{0};
+        bool failed{false};
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->blocks.resize(plan.blocks.size());
+    pending->remaining = plan.blocks.size();
+
+    for (int b = 0; b < plan.blocks.size(); ++b) {
+        const RegisterMap::Span &span = plan.blocks.at(b);
+        QModbusDataUnit unit(QModbusDataUnit::InputRegisters, span.start, quint16(span.count));
+        auto *reply = m_modbusDevice->sendReadRequest(unit, m_serverAddress);
+        if (!reply || reply->isFinished()) {
             delete reply;
+            return; // Оставшиеся блоки не запрашиваем - отсчет все равно неполный
+        }
+        trackReply(reply);
+        connect(reply, &QModbusReply::finished, this, [this, reply, pending, b]() {
+            reply->deleteLater();
+            if (reply->error() == QModbusDevice::NoError) {
+                pending->blocks[b] = reply->result().values();
+            } else if (!pending->failed) {
+                pending->failed = true;
+                emit errorOccurred(tr("Read error: ") + reply->errorString());
+            }
+            if (--pending->remaining == 0 && !pending->failed)
+                onSnapshot(pending->blocks);
+        });
     }
 }
 
-void MachineControl::onReadReady()
+void MachineControl::onSnapshot(const QVector<QVector<quint16>> &blocks)
 {
-    auto reply = qobject_cast<QModbusReply *>(sender());
+    // Декодирование - по готовой таблице (блок + смещение + тип), без поиска адресов
+    const RegisterMap::ReadPlan &plan = m_map.snapshotPlan();
+    if (blocks.size() != plan.blocks.size()) // Карта сменилась, пока ждали ответ
+        return;
+
+    // Ответ на снимок, запрошенный до включения FIFO, в поток не попадает
+    if (!isBufferedMode()) {
+        Sample s;
+        s.seq = ++m_snapshotSeq;
+        s.position = float(m_map.read(plan, blocks, RegisterMap::Position));
+        s.load = float(m_map.read(plan, blocks, RegisterMap::Load));
+        s.time = float(m_map.read(plan, blocks, RegisterMap::TestTime));
+        s.elongation = float(m_map.read(plan, blocks, RegisterMap::Elongation));
+        s.maxLoad = float(m_map.read(plan, blocks, RegisterMap::MaxLoad));
+        s.hostTimestampUs = m_clock.nsecsElapsed() / 1000;
+        publish({s});
+    }
+    if (plan.block[RegisterMap::CmdEcho] >= 0)
+        checkAcks(quint16(m_map.read(plan, blocks, RegisterMap::CmdEcho)));
+}
+
+// =========================================================================
+// БУФЕРИЗОВАННЫЙ СБОР
+// =========================================================================
+void MachineControl::setBufferedMode(quint16 rateHz)
+{
+    if (postToOwnThread([=]() { setBufferedMode(rateHz); }))
+        return;
+    resetFifo();
+    m_fifoLost = 0;
+    if (!m_fifoSupported) {
+        // Выключать нечего - молча; включение без FIFO - ошибка вызывающего
+        m_fifoRateHz = 0;
+        if (rateHz > 0)
+            emit errorOccurred(tr("PLC does not support buffered acquisition"));
+        return;
+    }
+    m_fifoRateHz = rateHz;
+    writeField(RegisterMap::FifoRate, rateHz, [this, rateHz](bool ok) {
+        // Исключение ПЛК на записи частоты - регистра нет, FIFO не заработает
+        if (!ok && rateHz > 0 && m_lastWriteError == QModbusDevice::ProtocolError)
+            disableBufferedMode();
+    });
+}
+
+void MachineControl::disableBufferedMode()
+{
+    // Прошивка без FIFO: возвращаемся на снимки; ошибка - один раз за включение
+    const bool wasBuffered = isBufferedMode();
+    m_fifoRateHz = 0;
+    m_fifoSupported = false; // До следующей setRegisterMap
+    resetFifo();
+    if (wasBuffered)
+        emit errorOccurred(tr("PLC does not support buffered acquisition"));
+}
+
+void MachineControl::resetFifo()
+{
+    m_fifoSynced = false;
+    m_fifoBusy = false;
+    m_fifoPendingLost = 0;
+    m_fifoLastTime = 0.0f;
+    m_fifoMaxLoad = 0.0f;
+    m_fifoBatch.clear();
+}
+
+void MachineControl::requestFifoHeader()
+{
+    QModbusDataUnit unit(QModbusDataUnit::InputRegisters,
+                         m_map.address(RegisterMap::FifoHead),
+                         RegFifo::HeaderCount);
+    auto *reply = m_modbusDevice->sendReadRequest(unit, m_serverAddress);
     if (!reply)
         return;
+    m_fifoBusy = true;
+    if (reply->isFinished()) {
+        delete reply;
+        m_fifoBusy = false;
+        return;
+    }
+    trackReply(reply);
+    connect(reply, &QModbusReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (reply->error() == QModbusDevice::ProtocolError) {
+            // Исключение ПЛК (нет окна FIFO), а не сбой связи
+            disableBufferedMode();
+            return;
+        }
+        if (reply->error() != QModbusDevice::NoError) {
+            // Цепочка прерывается, недочитанное заберет следующий опрос
+            m_fifoBusy = false;
+            emit errorOccurred(tr("FIFO read error: ") + reply->errorString());
+            return;
+        }
+        onFifoHeader(reply->result());
+    });
+}
+
+void MachineControl::onFifoHeader(const QModbusDataUnit &unit)
+{
+    if (!isBufferedMode() || unit.valueCount() < uint(RegFifo::HeaderCount)) {
+        m_fifoBusy = false;
+        return;
+    }
+
+    const QVector<quint16> header = unit.values();
+    const quint32 head = quint32(m_map.decode(RegisterMap::FifoHead, header.constData()));
+    const quint16 depth = unit.value(2);
+    m_fifoPeriodUs = unit.value(3);
+    m_fifoHeadUs = m_clock.nsecsElapsed() / 1000;
+    if (depth <= RegFifo::GuardSlots) {
+        disableBufferedMode();
+        return;
+    }
 
-    if (reply->error() == QModbusDevice::NoError) {
-        const QModbusDataUnit unit = reply->result();
-        if (unit.valueCount() >= 10) {
-            emit currentPositionChanged(decodeFloat(unit.value(0), unit.value(1)));
-            emit currentLoadChanged(decodeFloat(unit.value(2), unit.value(3)));
-            emit testTimeChanged(decodeFloat(unit.value(4), unit.value(5)));
-            emit lengthChanged(decodeFloat(unit.value(6), unit.value(7)));
-            emit maxLoadChanged(decodeFloat(unit.value(8), unit.value(9)));
+    // Первый заход или перезапуск ПЛК (счетчик ушел назад): читаем только новое
+    if (!m_fifoSynced || depth != m_fifoDepth || head + 1 < m_fifoNextSeq) {
+        m_fifoSynced = true;
+        m_fifoDepth = depth;
+        m_fifoNextSeq = head + 1;
+        m_fifoBusy = false;
+        return;
+    }
+
+    // Отсчеты старше head - readable уже перезаписаны (или будут, пока читаем)
+    const quint32 readable = depth - RegFifo::GuardSlots;
+    const quint32 pending = head + 1 - m_fifoNextSeq;
+    if (pending > readable) {
+        m_fifoPendingLost += pending - readable;
+        m_fifoNextSeq = head + 1 - readable;
+    }
+    m_fifoEndSeq = head;
+    requestFifoChunk();
+}
+
+void MachineControl::requestFifoChunk()
+{
+    if (m_fifoNextSeq > m_fifoEndSeq || !isConnected()) {
+        finishFifoDrain();
+        return;
+    }
+
+    // Непрерывный участок кольца: не дальше конца буфера и лимита PDU
+    const quint32 slot = m_fifoNextSeq % m_fifoDepth;
+    const quint32 count = qMin<quint32>(qMin<quint32>(m_fifoEndSeq - m_fifoNextSeq + 1,
+                                                      m_fifoDepth - slot),
+                                        RegFifo::MaxSlotsPerRead);
+    const quint32 firstSeq = m_fifoNextSeq;
+
+    QModbusDataUnit unit(QModbusDataUnit::InputRegisters,
+                         m_map.address(RegisterMap::FifoHead) + RegFifo::HeaderCount
+                             + int(slot) * RegFifo::SlotRegs,
+                         quint16(count * RegFifo::SlotRegs));
+    auto *reply = m_modbusDevice->sendReadRequest(unit, m_serverAddress);
+    if (!reply) {
+        finishFifoDrain();
+        return;
+    }
+    if (reply->isFinished()) {
+        delete reply;
+        finishFifoDrain();
+        return;
+    }
+    trackReply(reply);
+    connect(reply, &QModbusReply::finished, this, [this, reply, firstSeq]() {
+        reply->deleteLater();
+        if (reply->error() != QModbusDevice::NoError) {
+            emit errorOccurred(tr("FIFO read error: ") + reply->errorString());
+            finishFifoDrain();
+            return;
         }
-    } else {
-        emit errorOccurred(tr("Read error: ") + reply->errorString());
+        onFifoChunk(reply->result(), firstSeq);
+    });
+}
+
+void MachineControl::onFifoChunk(const QModbusDataUnit &unit, quint32 firstSeq)
+{
+    if (!m_fifoBusy || firstSeq != m_fifoNextSeq) // Режим сброшен, пока ждали ответ
+        return;
+
+    const int count = int(unit.valueCount()) / RegFifo::SlotRegs;
+    for (int i = 0; i < count; ++i) {
+        const int base = i * RegFifo::SlotRegs;
+        const quint32 seq = firstSeq + quint32(i);
+        // Несовпадение номера - слот уже перезаписан более новым отсчетом
+        if (unit.value(base) != quint16(seq & 0xFFFF)) {
+            ++m_fifoPendingLost;
+            continue;
+        }
+        Sample s;
+        s.seq = seq;
+        s.time = decodeFloat(unit.value(base + 1), unit.value(base + 2));
+        s.position = decodeFloat(unit.value(base + 3), unit.value(base + 4));
+        s.load = decodeFloat(unit.value(base + 5), unit.value(base + 6));
+        s.elongation = decodeFloat(unit.value(base + 7), unit.value(base + 8));
+
+        // Новое испытание: время в ПЛК начинается заново
+        if (s.time < m_fifoLastTime)
+            m_fifoMaxLoad = 0.0f;
+        m_fifoLastTime = s.time;
+        m_fifoMaxLoad = qMax(m_fifoMaxLoad, s.load);
+        s.maxLoad = m_fifoMaxLoad;
+
+        // Отсчет head измерен примерно в момент ответа на заголовок,
+        // более ранние - на (head - seq) периодов раньше
+        s.hostTimestampUs = m_fifoHeadUs - qint64(m_fifoEndSeq - seq) * m_fifoPeriodUs;
+        m_fifoBatch.append(s);
     }
-    reply->deleteLater();
+    m_fifoNextSeq = firstSeq + quint32(qMax(count, 1));
+    requestFifoChunk();
+}
+
+void MachineControl::finishFifoDrain()
+{
+    m_fifoBusy = false;
+    if (m_fifoPendingLost > 0) {
+        m_fifoLost += m_fifoPendingLost;
+        m_fifoPendingLost = 0;
+    }
+    if (!m_fifoBatch.isEmpty()) {
+        publish(m_fifoBatch);
+        m_fifoBatch.clear();
+    }
+}
+
+void MachineControl::publish(const QVector<Sample> &batch)
+{
+    // Разрыв потока: отсчеты идут реже двух ожидаемых периодов
+    const qint64 periodUs = isBufferedMode() && m_fifoPeriodUs > 0
+                                ? qint64(m_fifoPeriodUs)
+                                : qint64(m_pollTimer->interval()) * 1000;
+    for (const Sample &s : batch) {
+        if (m_lastSampleUs > 0 && periodUs > 0) {
+            const qint64 gap = s.hostTimestampUs - m_lastSampleUs;
+            if (gap > 2 * periodUs) {
+                QMutexLocker lock(&m_statsMutex);
+                ++m_link.sampleGaps;
+                m_link.maxGapUs = qMax(m_link.maxGapUs, gap);
+            }
+        }
+        m_lastSampleUs = s.hostTimestampUs;
+        m_samples.push(s);
+        m_forceTare.add(s.load, s.hostTimestampUs);
+        m_extTare.add(s.elongation, s.hostTimestampUs);
+    }
+    if (m_lastSampleUs - m_tareUpdatedUs >= qint64(TareUpdateMs) * 1000)
+        updateTare();
+    emit samplesAvailable();
+}
+
+// =========================================================================
+// ТАРА
+// =========================================================================
+void MachineControl::setTareWindow(int windowMs, TareEstimator::Method method)
+{
+    if (postToOwnThread([=]() { setTareWindow(windowMs, method); }))
+        return;
+    m_forceTare.configure(windowMs, method);
+    m_extTare.configure(windowMs, method);
+}
+
+void MachineControl::setTareDriftLimit(double forceKgf, double extMm)
+{
+    QMutexLocker lock(&m_statsMutex);
+    m_forceDriftLimit = forceKgf;
+    m_extDriftLimit = extMm;
+}
+
+MachineControl::TareState MachineControl::tareState() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_tare;
+}
+
+MachineControl::TareState MachineControl::captureTare()
+{
+    QMutexLocker lock(&m_statsMutex);
+    m_tare.forceDriftKgf = 0.0;
+    m_tare.extDriftMm = 0.0;
+    m_tareZero = m_tare;
+    m_tareCaptured = m_tare.valid;
+    m_tareDriftReported = false;
+    return m_tare;
+}
+
+void MachineControl::updateTare()
+{
+    m_tareUpdatedUs = m_lastSampleUs;
+    const TareEstimator::Estimate force = m_forceTare.estimate();
+    const TareEstimator::Estimate ext = m_extTare.estimate();
+
+    bool drifted = false;
+    TareState st;
+    {
+        QMutexLocker lock(&m_statsMutex);
+        st.forceKgf = force.value;
+        st.extMm = ext.value;
+        st.forceNoiseKgf = force.noise;
+        st.extNoiseMm = ext.noise;
+        st.valid = force.valid && ext.valid;
+        st.idle = st.valid && force.noise <= m_forceDriftLimit && ext.noise <= m_extDriftLimit;
+        if (m_tareCaptured) {
+            st.forceDriftKgf = st.forceKgf - m_tareZero.forceKgf;
+            st.extDriftMm = st.extMm - m_tareZero.extMm;
+            if (st.idle && !m_tareDriftReported
+                && (qAbs(st.forceDriftKgf) > m_forceDriftLimit
+                    || qAbs(st.extDriftMm) > m_extDriftLimit)) {
+                m_tareDriftReported = true;
+                drifted = true;
+            }
+        }
+        m_tare = st;
+    }
+    if (drifted)
+        emit tareDriftDetected(st.forceDriftKgf, st.extDriftMm);
 }
 
 float MachineControl::decodeFloat(quint16 r1, quint16 r2)
 {
+    // Слоты FIFO: float в порядке слов профиля
+    if (m_map.wordOrder() == RegisterMap::WordOrder::LowFirst)
+        qSwap(r1, r2);
     quint32 temp = (quint32(r1) << 16) | r2;
     float result;
     memcpy(&result, &temp, sizeof(float));
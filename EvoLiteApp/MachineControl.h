@@ -1,13 +1,29 @@
 #ifndef MACHINECONTROL_H
 #define MACHINECONTROL_H
 
+#include <QElapsedTimer>
 #include <QModbusDataUnit>
+#include <QModbusDevice>
+#include <QMutex>
 #include <QObject>
+#include <QQueue>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include "RegisterMap.h"
+#include "SampleRing.h"
+#include "TareEstimator.h"
+#include <array>
+#include <atomic>
+#include <functional>
 
 class QModbusClient;
 class QModbusReply;
 class QTimer;
 
+// Драйвер машины. Может жить в отдельном потоке опроса (moveToThread):
+// публичные методы можно вызывать из любого потока - вызов переносится
+// в поток драйвера, а отсчеты раздаются через кольцо без блокировок.
 class MachineControl : public QObject
 {
     Q_OBJECT
@@ -27,7 +43,43 @@ public:
     void disconnectDevice();
     bool isConnected() const;
 
-    // --- БИТЫ УПРАВЛЕНИЯ (Адрес 0) ---
+    // --- КАРТА РЕГИСТРОВ ---
+    // Адреса, типы и биты берутся из профиля прошивки (по умолчанию - встроенный
+    // EvoLite v1). Менять карту следует до подключения: зеркало параметров сбрасывается.
+    void setRegisterMap(const RegisterMap &map);
+
+    // --- КАЧЕСТВО СВЯЗИ ---
+    // Сторож считает время от последнего ответа ПЛК. Повторы запросов внутри Qt
+    // отключены (они прятали таймауты): каждый таймаут виден в статистике,
+    // а повтором служит следующий опрос.
+    enum LinkQuality { LinkGood = 0, LinkDegraded, LinkLost };
+    Q_ENUM(LinkQuality)
+
+    struct LinkStats
+    {
+        quint64 requests{0};
+        quint64 replies{0};  // Ответы, в т.ч. с исключением Modbus - ПЛК на связи
+        quint64 timeouts{0};
+        quint64 errors{0};   // Обрыв, отказ отправки
+        quint64 retries{0};  // Запросы, ушедшие после неудачного
+        qint64 lastRttUs{0};
+        qint64 avgRttUs{0};  // Скользящее среднее (1/8)
+        qint64 maxRttUs{0};
+        quint64 sampleGaps{0}; // Интервалы между отсчетами длиннее двух периодов
+        qint64 maxGapUs{0};
+        qint64 lastReplyAgeMs{0};
+        LinkQuality quality{LinkLost};
+    };
+    LinkStats linkStats() const;
+
+    // heartbeatMs - без ответов дольше этого шлется легкий запрос (если опрос
+    // остановлен); degradedMs / lostMs - без ответов дольше этого связь Degraded / Lost.
+    // Degraded также после DegradedFailures неудачных запросов подряд.
+    void setWatchdog(int heartbeatMs = 250, int degradedMs = 500, int lostMs = 2000);
+    static constexpr int DegradedFailures = 2;
+
+    // --- БИТЫ УПРАВЛЕНИЯ ---
+    // Логические команды (совпадают с RegisterMap::Bit); номер бита в слове - из карты
     enum ControlBit {
         BitStartTest = 0,
         BitStop = 1,
@@ -42,9 +94,33 @@ public:
         BitTensileCompress = 10
     };
 
+    // Команды и параметры идут через планировщик записи: общая очередь в порядке вызова
+    // (скорость, записанная перед стартом, дойдет до ПЛК раньше старта) и приоритетный
+    // путь для СТОП - он отправляется сразу, не дожидаясь ответа на текущую запись,
+    // и снимает из очереди еще не отправленные команды движения.
+    // Бит меняется атомарно через Mask Write (FC22), остальные биты слова не затрагиваются.
     void sendCommand(ControlBit bit, bool state);
+    // Импульс: бит ставится и через holdMs снимается. Повторный импульс того же бита
+    // продлевает удержание, а не обрывает его по таймеру предыдущего.
+    void pulseCommand(ControlBit bit, int holdMs = 500);
     void setFullControlWord(quint16 word);
 
+    // Статистика: от постановки команды в очередь до подтверждения ПЛК
+    // (эхо управляющего слова, поле cmdEcho карты)
+    struct CommandStats
+    {
+        quint64 sent{0};
+        quint64 retried{0}; // Повторы записи после таймаута/сбоя связи
+        quint64 acknowledged{0};
+        quint64 timedOut{0};
+        qint64 lastWriteUs{0}; // До ответа Modbus на запись
+        qint64 maxWriteUs{0};
+        qint64 lastAckUs{0}; // До подтверждения в регистре эха
+        qint64 maxAckUs{0};
+        qint64 sumAckUs{0};
+    };
+    CommandStats commandStats() const;
+
     // --- НАСТРОЙКИ (Holding Registers) ---
     void setSpeedMmMin(quint16 value);
     void setMoveByX(float value);
@@ -58,37 +134,269 @@ public:
     void setTestSpeed(quint16 value);
     void setManualSpeed(quint16 value);
 
+    // --- НАБОР ПАРАМЕТРОВ (участок Holding от SpeedMmMin до ManualSpeed одним блоком) ---
+    struct Params
+    {
+        quint16 speedMmMin{0};
+        float moveByX{0.0f};
+        float moveToX{0.0f};
+        quint16 encoderPulses{0};
+        quint16 motorRevs{0};
+        quint16 screwMmRev{0};
+        float sensorRange{0.0f};
+        quint16 sensitivity{0};
+        float maxError{0.0f};
+        quint16 testSpeed{0};
+        quint16 manualSpeed{0};
+    };
+
+    // Транзакция: измененный участок блока пишется одним FC16, затем весь блок
+    // читается одним FC03 и сверяется. Значения, совпадающие с зеркалом ПЛК
+    // (последнее прочитанное), не пишутся; force - записать весь блок.
+    // Итог - сигнал paramsUploaded.
+    void uploadParams(const Params &params, bool force = false);
+    // Прочитать блок из ПЛК (обновляет зеркало), итог - сигнал paramsRead
+    void readParams();
+
     // --- ОПРОС ДАТЧИКОВ ---
     void startPolling(int intervalMs = 200);
     void stopPolling();
 
+    // --- ОТСЧЕТ ---
+    // Одно согласованное состояние машины: все поля из одного ответа ПЛК.
+    struct Sample
+    {
+        quint32 seq{0};            // Номер (снимки - счетчик опросов, FIFO - seq ПЛК)
+        float time{0.0f};          // Время испытания, с
+        float position{0.0f};      // Положение траверсы, мм
+        float load{0.0f};          // Нагрузка, кгс
+        float elongation{0.0f};    // Удлинение от старта, мм
+        float maxLoad{0.0f};       // Пиковая нагрузка, кгс
+        qint64 hostTimestampUs{0}; // Момент измерения по монотонным часам хоста, мкс
+    };
+
+    // --- БУФЕРИЗОВАННЫЙ СБОР (FIFO в ПЛК) ---
+    // ПЛК пишет отсчеты с частотой rateHz в кольцо Input-регистров (поле fifoHead карты),
+    // а опрос вычитывает накопившееся пачками. 0 - выкл (снимки по плану карты).
+    void setBufferedMode(quint16 rateHz);
+    bool isBufferedMode() const { return m_fifoRateHz.load() > 0; }
+    // Карта описывает FIFO и ПЛК не отверг его регистры (проверять перед setBufferedMode)
+    bool supportsBufferedMode() const { return m_fifoSupported.load(); }
+    // Отсчеты, потерянные из-за переполнения FIFO (с момента включения режима)
+    quint64 lostSamples() const { return m_fifoLost.load(); }
+
+    // --- РАЗДАЧА ОТСЧЕТОВ ---
+    // Все отсчеты попадают в кольцо. Каждый потребитель (анализ, график, журнал)
+    // заводит свой Reader и читает в своем темпе; отстающий теряет старые отсчеты
+    // (Reader::dropped()), но не тормозит опрос и других потребителей.
+    static constexpr int SampleRingCapacity = 16384; // ~16 с при 1 кГц
+    using SampleBuffer = SampleRing<Sample, SampleRingCapacity>;
+    SampleBuffer::Reader createSampleReader() const { return m_samples.reader(); }
+
+    // --- ТАРА (нуль силы и удлинения) ---
+    // Оценка ведется в потоке опроса по каждому отсчету (медиана или усеченное
+    // среднее за окно), пересчет - не чаще TareUpdateMs. Дрейф - отклонение оценки
+    // от нуля, зафиксированного captureTare(); проверяется, только пока машина
+    // стоит (шум окна не больше порога дрейфа).
+    struct TareState
+    {
+        double forceKgf{0.0};
+        double extMm{0.0};
+        double forceNoiseKgf{0.0}; // СКО шума в окне (по MAD)
+        double extNoiseMm{0.0};
+        bool valid{false}; // Окно набрано
+        bool idle{false};  // Сигнал спокоен: нагрузки и движения нет
+        double forceDriftKgf{0.0};
+        double extDriftMm{0.0};
+    };
+    static constexpr int TareUpdateMs = 50;
+    void setTareWindow(int windowMs, TareEstimator::Method method = TareEstimator::Median);
+    void setTareDriftLimit(double forceKgf, double extMm);
+    TareState tareState() const;
+    // Зафиксировать текущую оценку как нуль (от нее считается дрейф) и вернуть ее
+    TareState captureTare();
+
 signals:
     void errorOccurred(QString errorMsg);
     void connected();
     void disconnected();
 
-    // Данные датчиков
-    void currentPositionChanged(float val);
-    void currentLoadChanged(float val);
-    void testTimeChanged(float val);
-    void lengthChanged(float val);
-    void maxLoadChanged(float val);
+    // Данные датчиков. Уведомление раз в ответ: в кольце есть новые отсчеты,
+    // читать - через createSampleReader(); потери FIFO - lostSamples().
+    void samplesAvailable();
+
+    // Итог uploadParams: mismatches - имена параметров, не совпавших при чтении
+    void paramsUploaded(bool ok, const QStringList &mismatches);
+    void paramsRead(const MachineControl::Params &params);
+
+    // ПЛК подтвердил (или не подтвердил за AckTimeoutMs) изменение бита управления
+    void commandAcknowledged(int bit, bool state, qint64 latencyUs);
+    void commandTimedOut(int bit, bool state);
+    // СТОП так и не дошел до ПЛК: повторы шли, пока связь не признана потерянной
+    // (или ПЛК ответил отказом) - оператор должен остановить машину сам
+    void stopNotDelivered(int bit);
+
+    // Смена качества связи: по Degraded логика испытания должна остановиться,
+    // пока команды еще доходят
+    void linkQualityChanged(MachineControl::LinkQuality quality);
+
+    // Нуль ушел дальше порога, пока машина стоит (один раз до следующего captureTare)
+    void tareDriftDetected(double forceDriftKgf, double extDriftMm);
 
 private slots:
     void onStateChanged(int state);
-    void onReadReady();
     void doPoll();
+    void onWatchdog();
 
 private:
-    QModbusClient *m_modbusDevice; // Полиморфный указатель
+    QModbusClient *m_modbusDevice;        // Полиморфный указатель
+    std::atomic<bool> m_connected{false}; // Копия состояния для других потоков
     int m_serverAddress;
     QTimer *m_pollTimer;
+    QTimer *m_watchdogTimer;
     quint16 m_currentControlWord;
+    RegisterMap m_map{RegisterMap::builtin()};
+
+    // --- Планировщик записи ---
+    enum Lane { LaneStop = 0, LaneNormal, LaneCount };
+    struct PendingWrite
+    {
+        int address{0};
+        QVector<quint16> values{}; // FC06/FC16
+        bool isMask{false};        // FC22
+        quint16 andMask{0xFFFF};
+        quint16 orMask{0};
+        int bit{-1}; // Для подтверждения: какая команда (ControlBit) и в какое состояние
+        bool state{false};
+        qint64 queuedUs{0};
+        int attempt{0};
+        std::function<void(bool)> done{}; // Вызывается по ответу, до следующей записи
+    };
+    struct PendingAck
+    {
+        int bit{0};
+        bool state{false};
+        qint64 queuedUs{0};
+    };
+    static constexpr qint64 AckTimeoutMs = 1000;
+    // Qt-повторы отключены (для чтения повтор - следующий опрос), записи повторяет
+    // планировщик: потерянный кадр не должен терять команду или параметр
+    static constexpr int WriteRetries = 2;
+    static constexpr int WriteRetryDelayMs = 50;
+
+    std::array<QQueue<PendingWrite>, LaneCount> m_lanes{};
+    // Ошибка последней завершенной записи: done() по ней отличает исключение ПЛК от связи
+    QModbusDevice::Error m_lastWriteError{QModbusDevice::NoError};
+    quint32 m_writeEpoch{0}; // Растет в dropPendingWrites: отложенный повтор устарел
+    bool m_writeInFlight{false};
+    QVector<PendingAck> m_pendingAcks{};
+    std::array<quint32, RegisterMap::BitCount> m_pulseGen{}; // Поколение импульса по команде
+    mutable QMutex m_statsMutex;
+    CommandStats m_stats{};
+
+    // --- Зеркало блока параметров ---
+    QVector<quint16> m_paramMirror{};
+    quint32 m_paramKnown{0}; // Бит на регистр: значение в зеркале подтверждено чтением
+
+    // --- Сторож связи (поток драйвера; m_link - под m_statsMutex) ---
+    int m_heartbeatMs{250};
+    int m_degradedMs{500};
+    int m_lostMs{2000};
+    std::atomic<qint64> m_lastReplyUs{0}; // Читает и linkStats()
+    int m_failStreak{0};
+    int m_inFlight{0};
+    qint64 m_lastSampleUs{0};
+    LinkQuality m_quality{LinkLost};
+    LinkStats m_link{};
+
+    QElapsedTimer m_clock{}; // Монотонные часы для hostTimestampUs
+    SampleBuffer m_samples{};
+    quint32 m_snapshotSeq{0};
+
+    // Состояние вычитки FIFO
+    std::atomic<quint16> m_fifoRateHz{0};
+    std::atomic<bool> m_fifoSupported{false}; // Встроенная карта v1 - без FIFO
+    bool m_fifoSynced{false}; // Известен номер первого непрочитанного отсчета
+    bool m_fifoBusy{false};   // Идет цепочка запросов, следующий опрос ее не дублирует
+    quint32 m_fifoNextSeq{0};
+    quint32 m_fifoEndSeq{0};
+    quint16 m_fifoDepth{0};
+    quint16 m_fifoPeriodUs{0};
+    qint64 m_fifoHeadUs{0}; // Время получения заголовка (момент отсчета head)
+    float m_fifoLastTime{0.0f};
+    float m_fifoMaxLoad{0.0f}; // В слотах FIFO нет пика - ведется на хосте
+    quint32 m_fifoPendingLost{0};
+    std::atomic<quint64> m_fifoLost{0};
+    QVector<Sample> m_fifoBatch{};
+
+    // Тара: оценщики - в потоке драйвера, результат - под m_statsMutex
+    TareEstimator m_forceTare{};
+    TareEstimator m_extTare{};
+    qint64 m_tareUpdatedUs{0};
+    double m_forceDriftLimit{0.1}; // кгс
+    double m_extDriftLimit{0.01};  // мм
+    TareState m_tare{};
+    TareState m_tareZero{};
+    bool m_tareCaptured{false};
+    bool m_tareDriftReported{false};
+
+    // Вызов из чужого потока ставится в очередь потока драйвера (true - поставлен)
+    template<class F>
+    bool postToOwnThread(F &&f)
+    {
+        if (QThread::currentThread() == thread())
+            return false;
+        QMetaObject::invokeMethod(this, std::forward<F>(f), Qt::QueuedConnection);
+        return true;
+    }
 
     void initDeviceSignals(); // Хелпер для подключения сигналов
-    void writeRegister(int address, quint16 value);
-    void writeFloat(int address, float value);
+    void trackReply(QModbusReply *reply);
+    void onTrackedReply(qint64 sentUs, int error);
+    void sendHeartbeat();
+    void updateLinkQuality();
+    void setLinkQuality(LinkQuality quality);
+    void releaseDevice();
+    void resetFifo();
+    void disableBufferedMode();
+    void requestFifoHeader();
+    void onFifoHeader(const QModbusDataUnit &unit);
+    void requestFifoChunk();
+    void onFifoChunk(const QModbusDataUnit &unit, quint32 firstSeq);
+    void finishFifoDrain();
+    void onSnapshot(const QVector<QVector<quint16>> &blocks);
+    void publish(const QVector<Sample> &batch);
+    void updateTare();
+    void writeField(RegisterMap::Field field,
+                    double value,
+                    std::function<void(bool)> done = std::function<void(bool)>());
+    void enqueueWrite(Lane lane, PendingWrite w);
+    void pumpWrites();
+    void sendWrite(const PendingWrite &w, bool gated);
+    void onWriteFinished(QModbusReply *reply, const PendingWrite &w, bool gated);
+    // Повторить неудачную запись; false - повторов не будет (исчерпаны, отказ ПЛК).
+    // СТОП повторяется без счета, пока связь не потеряна; иначе - stopNotDelivered
+    bool retryWrite(const PendingWrite &w, bool gated);
+    static bool isStopWrite(const PendingWrite &w)
+    {
+        return w.isMask && w.state && (w.bit == BitStop || w.bit == BitStopMMMode);
+    }
+    static bool isMotionBit(int bit)
+    {
+        return bit == BitStartTest || bit == BitLiftTraverse || bit == BitLowerTraverse
+               || bit == BitStartMMMode || bit == BitUpMMMode || bit == BitDownMMMode;
+    }
+    void requestStatus();
+    void checkAcks(quint16 echo);
+    void dropPendingWrites();
+    void forgetParams(int address, int count);
+    void verifyParams(const QVector<quint16> &expected);
+    QVector<quint16> encodeParams(const Params &p) const;
+    Params decodeParams(const QVector<quint16> &regs) const;
     float decodeFloat(quint16 r1, quint16 r2);
 };
 
+Q_DECLARE_METATYPE(MachineControl::Sample)
+Q_DECLARE_METATYPE(MachineControl::Params)
+
 #endif // MACHINECONTROL_H
@@ -1,4 +1,7 @@
 #include "MainWindow.h"
+#include <QDebug>
+#include <QMessageBox>
+#include <QThread>
 #include "./ui_MainWindow.h"
 #include "CommandForm.h"
 #include "Iso6892Form.h"
@@ -13,7 +16,27 @@ MainWindow::MainWindow(QWidget *parent)
 
     setWindowTitle("EvoLite");
 
-    m_machine = new MachineControl(this);
+    // Опрос машины - в своем потоке, чтобы перерисовка GUI не задерживала ответы Modbus
+    m_acqThread = new QThread(this);
+    m_acqThread->setObjectName("MachineAcquisition");
+    m_machine = new MachineControl();
+    // Профиль регистров рядом с exe (registermap.json), иначе встроенный EvoLite v1
+    QString mapError;
+    m_machine->setRegisterMap(RegisterMap::loadDefault(&mapError));
+    if (!mapError.isEmpty())
+        qWarning() << "Register map:" << mapError;
+    m_machine->moveToThread(m_acqThread);
+    connect(m_acqThread, &QThread::finished, m_machine, &QObject::deleteLater);
+    m_acqThread->start(QThread::TimeCriticalPriority);
+
+    // Недошедший СТОП - с любой формы (испытание, ручное управление)
+    connect(m_machine, &MachineControl::stopNotDelivered, this, [this](int) {
+        QMessageBox::critical(this,
+                              "Машина",
+                              "Команда СТОП не дошла до ПЛК.\n"
+                              "Остановите машину аварийной кнопкой.");
+    });
+
     m_tcpConnForm = new TcpConnForm(this);
     m_tcpConnForm->setMachineControl(m_machine);
 
@@ -41,5 +64,14 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Формы обращаются к драйверу в деструкторах - удаляем их, пока поток жив
+    delete m_iso6892Form;
+    delete m_commandForm;
+    delete m_tcpConnForm;
+    m_machine->disconnectDevice();
+
+    // Драйвер удаляется в своем потоке (finished -> deleteLater)
+    m_acqThread->quit();
+    m_acqThread->wait();
     delete ui;
 }
@@ -7,6 +7,7 @@ class MainWindow;
 }
 QT_END_NAMESPACE
 
+class QThread;
 class MachineControl;
 class TcpConnForm;
 class CommandForm;
@@ -22,6 +23,7 @@ public:
 
 private:
     Ui::MainWindow *ui;
+    QThread *m_acqThread;
     MachineControl *m_machine;
     TcpConnForm *m_tcpConnForm;
     CommandForm *m_commandForm;
@@ -0,0 +1,423 @@
+#include "RegisterMap.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Имена полей в профиле (индекс = RegisterMap::Field)
+const char *const FieldNames[RegisterMap::FieldCount] = {"control",
+                                                         "speedMmMin",
+                                                         "moveByX",
+                                                         "moveToX",
+                                                         "encoderPulses",
+                                                         "motorRevs",
+                                                         "screwMmRev",
+                                                         "sensorRange",
+                                                         "sensitivity",
+                                                         "maxError",
+                                                         "testSpeed",
+                                                         "manualSpeed",
+                                                         "fifoRate",
+                                                         "position",
+                                                         "load",
+                                                         "testTime",
+                                                         "elongation",
+                                                         "maxLoad",
+                                                         "status",
+                                                         "cmdEcho",
+                                                         "fifoHead"};
+
+const char *const BitNames[RegisterMap::BitCount] = {"startTest",
+                                                     "stop",
+                                                     "liftTraverse",
+                                                     "lowerTraverse",
+                                                     "startMMMode",
+                                                     "stopMMMode",
+                                                     "upMMMode",
+                                                     "downMMMode",
+                                                     "servoAsync",
+                                                     "clamp",
+                                                     "tensileCompress"};
+
+const char *typeName(RegisterMap::Type t)
+{
+    switch (t) {
+    case RegisterMap::Type::I16:
+        return "i16";
+    case RegisterMap::Type::U32:
+        return "u32";
+    case RegisterMap::Type::F32:
+        return "f32";
+    default:
+        return "u16";
+    }
+}
+
+bool parseType(const QString &s, RegisterMap::Type *t)
+{
+    if (s == "u16")
+        *t = RegisterMap::Type::U16;
+    else if (s == "i16")
+        *t = RegisterMap::Type::I16;
+    else if (s == "u32")
+        *t = RegisterMap::Type::U32;
+    else if (s == "f32")
+        *t = RegisterMap::Type::F32;
+    else
+        return false;
+    return true;
+}
+
+bool fail(QString *error, const QString &msg)
+{
+    if (error)
+        *error = msg;
+    return false;
+}
+} // namespace
+
+RegisterMap::RegisterMap()
+{
+    m_bits.fill(-1);
+    compile();
+}
+
+// =========================================================================
+// ВСТРОЕННЫЙ ПРОФИЛЬ
+// =========================================================================
+RegisterMap RegisterMap::builtin(int version)
+{
+    RegisterMap m;
+    m.m_name = version >= 2 ? QStringLiteral("EvoLite PLC v2") : QStringLiteral("EvoLite PLC v1");
+    auto set = [&m](Field f, int address, Type type) { m.m_entries[f] = {address, type}; };
+
+    set(Control, 0, Type::U16);
+    set(SpeedMmMin, 2, Type::U16);
+    set(MoveByX, 3, Type::F32);
+    set(MoveToX, 5, Type::F32);
+    set(EncoderPulses, 7, Type::U16);
+    set(MotorRevs, 8, Type::U16);
+    set(ScrewMmRev, 9, Type::U16);
+    set(SensorRange, 10, Type::F32);
+    set(Sensitivity, 12, Type::U16);
+    set(MaxError, 13, Type::F32);
+    set(TestSpeed, 15, Type::U16);
+    set(ManualSpeed, 16, Type::U16);
+
+    set(Position, 0, Type::F32);
+    set(Load, 2, Type::F32);
+    set(TestTime, 4, Type::F32);
+    set(Elongation, 6, Type::F32);
+    set(MaxLoad, 8, Type::F32);
+
+    // В v1 этих регистров нет: снимок читается ровно 0..9, как и до карт
+    if (version >= 2) {
+        set(FifoRate, 20, Type::U16);
+        set(Status, 10, Type::U16);
+        set(CmdEcho, 11, Type::U16);
+        set(FifoHead, 100, Type::U32);
+    }
+
+    for (int b = 0; b < BitCount; ++b)
+        m.m_bits[b] = b;
+
+    m.compile();
+    return m;
+}
+
+// =========================================================================
+// JSON
+// =========================================================================
+RegisterMap RegisterMap::fromJson(const QJsonObject &json, QString *error)
+{
+    RegisterMap m;
+    m.m_name = json.value("name").toString();
+
+    const QString order = json.value("wordOrder").toString("highFirst");
+    if (order == "highFirst")
+        m.m_wordOrder = WordOrder::HighFirst;
+    else if (order == "lowFirst")
+        m.m_wordOrder = WordOrder::LowFirst;
+    else {
+        fail(error, QString("Unknown word order '%1'").arg(order));
+        return RegisterMap();
+    }
+
+    // Обе таблицы разбираются одинаково; поле из чужой таблицы - ошибка профиля
+    const char *const tables[] = {"holding", "input"};
+    for (int t = 0; t < 2; ++t) {
+        const QJsonObject obj = json.value(tables[t]).toObject();
+        for (auto it = obj.begin(); it != obj.end(); ++it) {
+            const char *const *found = std::find_if(std::begin(FieldNames),
+                                                    std::end(FieldNames),
+                                                    [&](const char *n) {
+                                                        return it.key() == QLatin1String(n);
+                                                    });
+            const Field f = Field(found - std::begin(FieldNames));
+            if (found == std::end(FieldNames) || tableOf(f) != Table(t)) {
+                fail(error, QString("Unknown %1 field '%2'").arg(tables[t], it.key()));
+                return RegisterMap();
+            }
+            const QJsonObject e = it.value().toObject();
+            Entry entry;
+            entry.address = e.value("address").toInt(-1);
+            if (!parseType(e.value("type").toString("u16"), &entry.type)) {
+                fail(error, QString("Field '%1': unknown type").arg(it.key()));
+                return RegisterMap();
+            }
+            if (entry.address < 0 || entry.address + entry.size() > 0x10000) {
+                fail(error, QString("Field '%1': bad address").arg(it.key()));
+                return RegisterMap();
+            }
+            m.m_entries[f] = entry;
+        }
+    }
+
+    const QJsonObject bits = json.value("bits").toObject();
+    for (int b = 0; b < BitCount; ++b) {
+        const int v = bits.value(BitNames[b]).toInt(-1);
+        if (v > 15) {
+            fail(error, QString("Bit '%1' out of range").arg(BitNames[b]));
+            return RegisterMap();
+        }
+        m.m_bits[b] = v;
+    }
+
+    if (!m.has(Control) || m.bit(BitStop) < 0) {
+        fail(error, QString("Profile must define the control word and the stop bit"));
+        return RegisterMap();
+    }
+
+    m.compile();
+    // Зеркало параметров в MachineControl - по биту на регистр
+    if (m.m_paramSpan.count > 32) {
+        fail(error, QString("Parameter block is wider than 32 registers"));
+        return RegisterMap();
+    }
+    // Параметры пишутся одним FC16 на весь участок: каждый его регистр должен
+    // принадлежать ровно одному параметру, иначе запись затрет чужие регистры
+    const Span ps = m.m_paramSpan;
+    std::array<int, 32> owners{};
+    for (Field f : ParamFields) {
+        const Entry &e = m.m_entries[f];
+        for (int k = 0; e.isValid() && k < e.size(); ++k)
+            ++owners[e.address - ps.start + k];
+    }
+    for (int i = 0; i < ps.count; ++i) {
+        if (owners[i] != 1) {
+            fail(error, QString("Parameter register %1 is %2")
+                            .arg(ps.start + i)
+                            .arg(owners[i] ? "shared by several fields" : "not mapped"));
+            return RegisterMap();
+        }
+    }
+    for (Field f : {Control, FifoRate}) {
+        const Entry &e = m.m_entries[f];
+        if (e.isValid() && e.address + e.size() > ps.start && e.address < ps.start + ps.count) {
+            fail(error, QString("Field '%1' overlaps the parameter block").arg(FieldNames[f]));
+            return RegisterMap();
+        }
+    }
+    return m;
+}
+
+RegisterMap RegisterMap::loadOrBuiltin(const QString &path, QString *error, int builtinVersion)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail(error, QString("Cannot open %1: %2").arg(path, file.errorString()));
+        return builtin(builtinVersion);
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        fail(error, QString("%1: %2").arg(path, parseError.errorString()));
+        return builtin(builtinVersion);
+    }
+    QString msg;
+    RegisterMap m = fromJson(doc.object(), &msg);
+    if (!msg.isEmpty()) {
+        fail(error, QString("%1: %2").arg(path, msg));
+        return builtin(builtinVersion);
+    }
+    return m;
+}
+
+RegisterMap RegisterMap::loadDefault(QString *error, int builtinVersion)
+{
+    const QString path = QDir(QCoreApplication::applicationDirPath()).filePath("registermap.json");
+    if (!QFileInfo::exists(path))
+        return builtin(builtinVersion);
+    return loadOrBuiltin(path, error, builtinVersion);
+}
+
+QJsonObject RegisterMap::toJson() const
+{
+    QJsonObject tables[2];
+    for (int f = 0; f < FieldCount; ++f) {
+        const Entry &e = m_entries[f];
+        if (!e.isValid())
+            continue;
+        QJsonObject obj;
+        obj.insert("address", e.address);
+        obj.insert("type", typeName(e.type));
+        tables[tableOf(Field(f))].insert(FieldNames[f], obj);
+    }
+    QJsonObject bits;
+    for (int b = 0; b < BitCount; ++b) {
+        if (m_bits[b] >= 0)
+            bits.insert(BitNames[b], m_bits[b]);
+    }
+
+    QJsonObject json;
+    json.insert("name", m_name);
+    json.insert("wordOrder", m_wordOrder == WordOrder::HighFirst ? "highFirst" : "lowFirst");
+    json.insert("holding", tables[Holding]);
+    json.insert("input", tables[Input]);
+    json.insert("bits", bits);
+    return json;
+}
+
+const char *RegisterMap::fieldName(Field f)
+{
+    return (f >= 0 && f < FieldCount) ? FieldNames[f] : "";
+}
+
+// =========================================================================
+// РАСКЛАДКА
+// =========================================================================
+RegisterMap::Span RegisterMap::span(const Field *fields, int count) const
+{
+    int first = -1;
+    int end = -1;
+    for (int i = 0; i < count; ++i) {
+        const Entry &e = m_entries[fields[i]];
+        if (!e.isValid())
+            continue;
+        first = first < 0 ? e.address : qMin(first, e.address);
+        end = qMax(end, e.address + e.size());
+    }
+    if (first < 0)
+        return {};
+    return {first, end - first};
+}
+
+RegisterMap::ReadPlan RegisterMap::plan(const Field *fields, int count, int maxGap, int maxRegs) const
+{
+    ReadPlan p;
+    p.block.fill(-1);
+    p.offset.fill(-1);
+    if (count <= 0)
+        return p;
+    p.table = tableOf(fields[0]);
+
+    // Поля по возрастанию адреса; соседние сливаются, пока дыра не больше maxGap
+    QVector<Field> sorted;
+    for (int i = 0; i < count; ++i) {
+        if (m_entries[fields[i]].isValid() && tableOf(fields[i]) == p.table)
+            sorted.append(fields[i]);
+    }
+    std::sort(sorted.begin(), sorted.end(), [this](Field a, Field b) {
+        return m_entries[a].address < m_entries[b].address;
+    });
+
+    for (Field f : sorted) {
+        const Entry &e = m_entries[f];
+        if (!p.blocks.isEmpty()) {
+            Span &last = p.blocks.last();
+            const int end = last.start + last.count;
+            const int newEnd = qMax(end, e.address + e.size());
+            if (e.address - end <= maxGap && newEnd - last.start <= maxRegs) {
+                last.count = newEnd - last.start;
+                p.block[f] = p.blocks.size() - 1;
+                p.offset[f] = e.address - last.start;
+                continue;
+            }
+        }
+        p.blocks.append({e.address, e.size()});
+        p.block[f] = p.blocks.size() - 1;
+        p.offset[f] = 0;
+    }
+    return p;
+}
+
+// =========================================================================
+// КОДИРОВАНИЕ
+// =========================================================================
+double RegisterMap::decode(Field f, const quint16 *regs) const
+{
+    const Type type = m_entries[f].type;
+    if (type == Type::U16)
+        return regs[0];
+    if (type == Type::I16)
+        return qint16(regs[0]);
+
+    const bool high = m_wordOrder == WordOrder::HighFirst;
+    const quint32 bits = high ? (quint32(regs[0]) << 16) | regs[1]
+                              : (quint32(regs[1]) << 16) | regs[0];
+    if (type == Type::U32)
+        return bits;
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+void RegisterMap::encode(Field f, double value, quint16 *regs) const
+{
+    const Type type = m_entries[f].type;
+    if (type == Type::U16 || type == Type::I16) {
+        regs[0] = quint16(qint32(value)); // Отрицательное для u16 - как в дополнительном коде
+        return;
+    }
+
+    quint32 bits;
+    if (type == Type::U32) {
+        bits = quint32(value);
+    } else {
+        const float v = float(value);
+        std::memcpy(&bits, &v, sizeof(float));
+    }
+    const quint16 hi = quint16(bits >> 16);
+    const quint16 lo = quint16(bits & 0xFFFF);
+    if (m_wordOrder == WordOrder::HighFirst) {
+        regs[0] = hi;
+        regs[1] = lo;
+    } else {
+        regs[0] = lo;
+        regs[1] = hi;
+    }
+}
+
+double RegisterMap::read(const ReadPlan &plan,
+                         const QVector<QVector<quint16>> &blocks,
+                         Field f,
+                         double fallback) const
+{
+    const int b = plan.block[f];
+    if (b < 0 || b >= blocks.size())
+        return fallback;
+    const int offset = plan.offset[f];
+    if (blocks.at(b).size() < offset + m_entries[f].size())
+        return fallback;
+    return decode(f, blocks.at(b).constData() + offset);
+}
+
+int RegisterMap::tableSize(Table t) const
+{
+    int size = 0;
+    for (int f = 0; f < FieldCount; ++f) {
+        if (m_entries[f].isValid() && tableOf(Field(f)) == t)
+            size = qMax(size, m_entries[f].address + m_entries[f].size());
+    }
+    return size;
+}
+
+void RegisterMap::compile()
+{
+    m_snapshotPlan = plan(SnapshotFields.data(), int(SnapshotFields.size()));
+    m_paramSpan = span(ParamFields.data(), int(ParamFields.size()));
+}
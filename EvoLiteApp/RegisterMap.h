@@ -0,0 +1,185 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <initializer_list>
+
+// Карта регистров контроллера машины (профиль прошивки).
+// Общая для EvoLiteApp (MachineControl), EmulatorApp и CommandApp: адреса, типы
+// и биты управления берутся из JSON-профиля, а не из констант в коде.
+//
+// При загрузке профиль компилируется: для набора полей строится план чтения
+// (минимум блочных запросов) и таблица декодирования (блок + смещение + тип),
+// так что разбор отсчета стоит столько же, сколько с жесткими адресами.
+//
+// Формат профиля:
+// {
+//   "name": "EvoLite PLC v1",
+//   "wordOrder": "highFirst",              // или "lowFirst" для 32-битных типов
+//   "holding": { "control": {"address": 0, "type": "u16"}, ... },
+//   "input":   { "position": {"address": 0, "type": "f32"}, ... },
+//   "bits":    { "startTest": 0, "stop": 1, ... }
+// }
+// Поле, которого нет в профиле, считается неподдерживаемым (address = -1).
+// Параметры (speedMmMin..manualSpeed) пишутся одним блоком: они должны лежать
+// сплошь, без пропусков и без control/fifoRate внутри - иначе профиль отвергается.
+class RegisterMap
+{
+public:
+    enum Table { Holding = 0, Input };
+    enum class Type { U16, I16, U32, F32 };
+    enum class WordOrder { HighFirst, LowFirst };
+
+    // Смысловые поля протокола (порядок не важен для профиля - он по именам)
+    enum Field {
+        // Holding (RW)
+        Control = 0,
+        SpeedMmMin,
+        MoveByX,
+        MoveToX,
+        EncoderPulses,
+        MotorRevs,
+        ScrewMmRev,
+        SensorRange,
+        Sensitivity,
+        MaxError,
+        TestSpeed,
+        ManualSpeed,
+        FifoRate,
+        // Input (RO)
+        Position,
+        Load,
+        TestTime,
+        Elongation,
+        MaxLoad,
+        Status,
+        CmdEcho,
+        FifoHead, // Заголовок FIFO: head (u32), depth, period; слоты следом
+        FieldCount
+    };
+
+    // Биты управляющего слова
+    enum Bit {
+        BitStartTest = 0,
+        BitStop,
+        BitLiftTraverse,
+        BitLowerTraverse,
+        BitStartMMMode,
+        BitStopMMMode,
+        BitUpMMMode,
+        BitDownMMMode,
+        BitServoAsync,
+        BitClamp,
+        BitTensileCompress,
+        BitCount
+    };
+
+    struct Entry
+    {
+        int address{-1};
+        Type type{Type::U16};
+        bool isValid() const { return address >= 0; }
+        int size() const { return (type == Type::U32 || type == Type::F32) ? 2 : 1; }
+    };
+
+    // Непрерывный участок одной таблицы
+    struct Span
+    {
+        int start{0};
+        int count{0};
+        bool isValid() const { return count > 0; }
+    };
+
+    // Скомпилированный план чтения набора полей
+    struct ReadPlan
+    {
+        Table table{Input};
+        QVector<Span> blocks{};
+        // Где лежит поле: номер блока и смещение в нем (-1 - поле не входит в план)
+        std::array<int, FieldCount> block{};
+        std::array<int, FieldCount> offset{};
+    };
+
+    RegisterMap();
+
+    // Встроенные карты прошивки EvoLite:
+    //   1 - выпускаемая прошивка (profiles/evolite_v1.json): только снимок 0..9;
+    //   2 - плюс статус, эхо команд и FIFO (profiles/evolite_v2.json, эмулятор).
+    static RegisterMap builtin(int version = 1);
+    static RegisterMap fromJson(const QJsonObject &json, QString *error = nullptr);
+    // Файл профиля; при ошибке - встроенная карта и текст ошибки
+    static RegisterMap loadOrBuiltin(const QString &path,
+                                     QString *error = nullptr,
+                                     int builtinVersion = 1);
+    // registermap.json рядом с исполняемым файлом, иначе встроенная карта
+    static RegisterMap loadDefault(QString *error = nullptr, int builtinVersion = 1);
+    QJsonObject toJson() const;
+
+    const QString &name() const { return m_name; }
+    WordOrder wordOrder() const { return m_wordOrder; }
+    const Entry &entry(Field f) const { return m_entries[f]; }
+    int address(Field f) const { return m_entries[f].address; }
+    bool has(Field f) const { return m_entries[f].isValid(); }
+    int bit(Bit b) const { return m_bits[b]; }
+    static Table tableOf(Field f) { return f < Position ? Holding : Input; }
+    static const char *fieldName(Field f);
+
+    // Один участок, покрывающий все поля (для блочной записи/чтения параметров)
+    Span span(const Field *fields, int count) const;
+    Span span(std::initializer_list<Field> fields) const
+    {
+        return span(fields.begin(), int(fields.size()));
+    }
+    // План чтения: поля одной таблицы, соседние объединяются в блоки до maxRegs
+    ReadPlan plan(const Field *fields, int count, int maxGap = 8, int maxRegs = 125) const;
+    ReadPlan plan(std::initializer_list<Field> fields) const
+    {
+        return plan(fields.begin(), int(fields.size()));
+    }
+
+    // Декодирование/кодирование значения поля; regs указывает на первый регистр поля
+    double decode(Field f, const quint16 *regs) const;
+    void encode(Field f, double value, quint16 *regs) const;
+
+    // Значение поля из блоков, прочитанных по плану
+    double read(const ReadPlan &plan, const QVector<QVector<quint16>> &blocks, Field f,
+                double fallback = 0.0) const;
+
+    // Размер таблицы, достаточный для всех полей профиля (для карты эмулятора)
+    int tableSize(Table t) const;
+
+    // --- Скомпилировано при загрузке ---
+    // Снимок датчиков (Position..CmdEcho) и блок параметров (SpeedMmMin..ManualSpeed)
+    const ReadPlan &snapshotPlan() const { return m_snapshotPlan; }
+    const Span &paramSpan() const { return m_paramSpan; }
+    static constexpr std::array<Field, 11> ParamFields{SpeedMmMin,
+                                                        MoveByX,
+                                                        MoveToX,
+                                                        EncoderPulses,
+                                                        MotorRevs,
+                                                        ScrewMmRev,
+                                                        SensorRange,
+                                                        Sensitivity,
+                                                        MaxError,
+                                                        TestSpeed,
+                                                        ManualSpeed};
+    static constexpr std::array<Field, 7> SnapshotFields{Position,
+                                                          Load,
+                                                          TestTime,
+                                                          Elongation,
+                                                          MaxLoad,
+                                                          Status,
+                                                          CmdEcho};
+
+private:
+    QString m_name{};
+    WordOrder m_wordOrder{WordOrder::HighFirst};
+    std::array<Entry, FieldCount> m_entries{};
+    std::array<int, BitCount> m_bits{};
+    ReadPlan m_snapshotPlan{};
+    Span m_paramSpan{};
+
+    void compile();
+};
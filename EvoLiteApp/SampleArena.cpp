@@ -0,0 +1,41 @@
+#include "SampleArena.h"
+
+SampleArena::View SampleArena::View::affine(double scale, double offset) const
+{
+    View v = *this;
+    v.m_scale = m_scale * scale;
+    v.m_offset = m_offset * scale + offset;
+    v.m_floor = m_floor * scale + offset;
+    return v;
+}
+
+SampleArena::View SampleArena::View::clampedBelow(double floor) const
+{
+    View v = *this;
+    v.m_floor = qMax(m_floor, floor);
+    return v;
+}
+
+void SampleArena::reserve(qint64 count)
+{
+    const qint64 chunks = (count + ChunkSize - 1) >> ChunkShift;
+    m_chunks.reserve(size_t(chunks));
+    while (qint64(m_chunks.size()) < chunks)
+        m_chunks.emplace_back(new Chunk);
+}
+
+void SampleArena::release()
+{
+    m_chunks.clear();
+    m_chunks.shrink_to_fit();
+    m_size = 0;
+}
+
+SampleArena::View SampleArena::column(Column c) const
+{
+    View v;
+    v.m_arena = this;
+    v.m_column = c;
+    v.m_size = m_size;
+    return v;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QtGlobal>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Хранилище точек испытания по столбцам (сила, удлинение, отфильтрованная сила),
+// кусками по ChunkSize.
+// Куски не переезжают при росте, поэтому нет пиковых копий, как у растущего
+// QVector, а виды (View) читают данные на месте без копирования.
+// Напряжение и деформация - не отдельные массивы, а виды с линейным
+// преобразованием над сырыми столбцами: value = raw * scale + offset (не ниже floor).
+//
+// Память выделяется без обнуления: страницы занимаются по мере записи.
+// clear() оставляет куски для следующего испытания.
+class SampleArena
+{
+public:
+    // ForceFiltered - сила после SignalFilter; до фильтрации равна Force
+    enum Column { Force = 0, Extension, ForceFiltered, ColumnCount };
+
+    static constexpr int ChunkShift = 16;
+    static constexpr qint64 ChunkSize = qint64(1) << ChunkShift; // 64K точек, 1.5 МБ на кусок
+
+    // Вид на столбец только для чтения. Действителен, пока жива арена и не вызван
+    // clear(); длина фиксируется при создании (точки, добавленные позже, не видны).
+    class View
+    {
+    public:
+        View() = default;
+
+        qint64 size() const { return m_size; }
+        bool isEmpty() const { return m_size == 0; }
+        double operator[](qint64 i) const { return map(m_arena->raw(m_column, i)); }
+        double last() const { return (*this)[m_size - 1]; }
+        double map(double raw) const { return qMax(m_floor, raw * m_scale + m_offset); }
+
+        // Новое преобразование поверх текущего: v' = v * scale + offset (scale > 0)
+        View affine(double scale, double offset) const;
+        View clampedBelow(double floor) const;
+
+        // Обход непрерывными кусками сырых значений: f(const double *raw, int n, qint64 first).
+        // Значения через map() - так обходится без проверки индекса на каждой точке.
+        template<class F>
+        void forEachChunk(F &&f) const
+        {
+            for (qint64 first = 0; first < m_size; first += ChunkSize) {
+                const int n = int(qMin(ChunkSize, m_size - first));
+                f(m_arena->chunkData(m_column, first >> ChunkShift), n, first);
+            }
+        }
+
+    private:
+        friend class SampleArena;
+        const SampleArena *m_arena{nullptr};
+        int m_column{0};
+        qint64 m_size{0};
+        double m_scale{1.0};
+        double m_offset{0.0};
+        double m_floor{-std::numeric_limits<double>::infinity()};
+    };
+
+    SampleArena() = default;
+    SampleArena(const SampleArena &) = delete;
+    SampleArena &operator=(const SampleArena &) = delete;
+
+    // Выделить куски заранее под ожидаемую длину испытания
+    void reserve(qint64 count);
+    void clear() { m_size = 0; }
+    // Отдать память (clear() ее сохраняет)
+    void release();
+
+    void append(double force, double extension)
+    {
+        const qint64 chunk = m_size >> ChunkShift;
+        if (chunk == qint64(m_chunks.size()))
+            m_chunks.emplace_back(new Chunk);
+        Chunk &c = *m_chunks[chunk];
+        const qint64 i = m_size & (ChunkSize - 1);
+        c.values[Force][i] = force;
+        c.values[Extension][i] = extension;
+        c.values[ForceFiltered][i] = force;
+        ++m_size;
+    }
+
+    // Доступ к уже добавленной точке (i < size())
+    double value(Column c, qint64 i) const { return raw(c, i); }
+    void set(Column c, qint64 i, double v)
+    {
+        m_chunks[i >> ChunkShift]->values[c][i & (ChunkSize - 1)] = v;
+    }
+
+    qint64 size() const { return m_size; }
+    View column(Column c) const;
+    // Выделено под точки, байт
+    qint64 memoryBytes() const { return qint64(m_chunks.size()) * qint64(sizeof(Chunk)); }
+
+private:
+    struct Chunk
+    {
+        double values[ColumnCount][ChunkSize];
+    };
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    qint64 m_size{0};
+
+    double raw(int column, qint64 i) const
+    {
+        return m_chunks[i >> ChunkShift]->values[column][i & (ChunkSize - 1)];
+    }
+    const double *chunkData(int column, qint64 chunk) const
+    {
+        return m_chunks[chunk]->values[column];
+    }
+};
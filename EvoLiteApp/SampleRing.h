@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// Кольцо отсчетов: один писатель (поток опроса), сколько угодно читателей.
+// Писатель никогда не ждет: медленный читатель теряет самые старые отсчеты
+// и узнает об этом по своему счетчику dropped(), остальные читатели не страдают.
+//
+// Каждый слот защищен версией (seqlock): 2p+1 - идет запись отсчета p, 2p+2 - готов.
+// Читатель копирует слот и сверяет версию до и после копирования.
+template<class T, int Capacity>
+class SampleRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SampleRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "SampleRing stores plain data only");
+
+public:
+    SampleRing()
+        : m_slots(new Slot[Capacity])
+    {}
+    SampleRing(const SampleRing &) = delete;
+    SampleRing &operator=(const SampleRing &) = delete;
+
+    // Только из потока-писателя
+    void push(const T &value)
+    {
+        const quint64 pos = m_head.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[pos & Mask];
+        slot.version.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.value, &value, sizeof(T));
+        slot.version.store(2 * pos + 2, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_release);
+    }
+
+    // Сколько отсчетов записано за все время
+    quint64 head() const { return m_head.load(std::memory_order_acquire); }
+    static constexpr int capacity() { return Capacity; }
+
+    // Курсор одного потребителя. Принадлежит потоку, который из него читает.
+    class Reader
+    {
+    public:
+        Reader() = default;
+
+        bool isValid() const { return m_ring != nullptr; }
+        quint64 dropped() const { return m_dropped; }
+        quint64 available() const { return m_ring ? m_ring->head() - m_pos : 0; }
+
+        // Пропустить все накопленное (например, перед стартом испытания)
+        void skipToHead()
+        {
+            if (m_ring)
+                m_pos = m_ring->head();
+        }
+
+        // Забрать до maxCount отсчетов по порядку, вернуть сколько прочитано
+        int read(T *out, int maxCount)
+        {
+            if (!m_ring)
+                return 0;
+            int n = 0;
+            quint64 head = m_ring->head();
+            while (n < maxCount && m_pos < head) {
+                // Отстали больше, чем на кольцо: старое уже перезаписано
+                if (head - m_pos > quint64(Capacity)) {
+                    m_dropped += head - Capacity - m_pos;
+                    m_pos = head - Capacity;
+                }
+                const Slot &slot = m_ring->m_slots[m_pos & Mask];
+                const quint64 expected = 2 * m_pos + 2;
+                if (slot.version.load(std::memory_order_acquire) == expected) {
+                    std::memcpy(&out[n], &slot.value, sizeof(T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.version.load(std::memory_order_relaxed) == expected) {
+                        ++n;
+                        ++m_pos;
+                        continue;
+                    }
+                }
+                // Писатель обогнал нас во время чтения
+                ++m_dropped;
+                ++m_pos;
+                head = m_ring->head();
+            }
+            return n;
+        }
+
+    private:
+        friend class SampleRing;
+        explicit Reader(const SampleRing *ring)
+            : m_ring(ring)
+            , m_pos(ring->head())
+        {}
+
+        const SampleRing *m_ring{nullptr};
+        quint64 m_pos{0};
+        quint64 m_dropped{0};
+    };
+
+    // Новый читатель видит только отсчеты, записанные после его создания
+    Reader reader() const { return Reader(this); }
+
+private:
+    static constexpr quint64 Mask = Capacity - 1;
+
+    struct Slot
+    {
+        std::atomic<quint64> version{0};
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<quint64> m_head{0};
+};
@@ -0,0 +1,404 @@
+#include "SignalFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Размер блока для свертки: блок выхода и сдвинутый вход остаются в L1
+constexpr qint64 BlockSize = 1024;
+
+// Медиана первых n значений buf (n > 0); для четного n - среднее двух средних
+double medianOf(double *buf, int n)
+{
+    const int m = n / 2;
+    std::nth_element(buf, buf + m, buf + n);
+    if (n & 1)
+        return buf[m];
+    const double hi = buf[m];
+    const double lo = *std::max_element(buf, buf + m);
+    return 0.5 * (lo + hi);
+}
+
+// Отражение индекса от краев: -1 -> 1, n -> n-2
+qint64 reflect(qint64 j, qint64 n)
+{
+    if (j < 0)
+        j = -j;
+    if (j > n - 1)
+        j = 2 * (n - 1) - j;
+    return qBound(qint64(0), j, n - 1);
+}
+
+// Коэффициенты сглаживания Савицкого-Голея в центре окна: первая строка
+// (AᵀA)⁻¹Aᵀ, A[k][j] = k^j. Решаем (AᵀA) v = e0, тогда c_k = Σ v_j k^j.
+std::vector<double> savitzkyGolay(int half, int order)
+{
+    const int p = order + 1;
+    std::vector<double> m(size_t(p * (p + 1)), 0.0); // [AᵀA | e0]
+    for (int r = 0; r < p; ++r) {
+        for (int c = 0; c < p; ++c) {
+            double s = 0;
+            for (int k = -half; k <= half; ++k)
+                s += std::pow(double(k), r + c);
+            m[size_t(r * (p + 1) + c)] = s;
+        }
+        m[size_t(r * (p + 1) + p)] = (r == 0) ? 1.0 : 0.0;
+    }
+    // Гаусс с выбором главного элемента (p <= window, матрица маленькая)
+    for (int col = 0; col < p; ++col) {
+        int piv = col;
+        for (int r = col + 1; r < p; ++r)
+            if (std::fabs(m[size_t(r * (p + 1) + col)]) > std::fabs(m[size_t(piv * (p + 1) + col)]))
+                piv = r;
+        for (int c = 0; c <= p; ++c)
+            std::swap(m[size_t(col * (p + 1) + c)], m[size_t(piv * (p + 1) + c)]);
+        const double d = m[size_t(col * (p + 1) + col)];
+        for (int r = 0; r < p; ++r) {
+            if (r == col)
+                continue;
+            const double f = m[size_t(r * (p + 1) + col)] / d;
+            for (int c = col; c <= p; ++c)
+                m[size_t(r * (p + 1) + c)] -= f * m[size_t(col * (p + 1) + c)];
+        }
+    }
+    std::vector<double> coeffs(size_t(2 * half + 1), 0.0);
+    for (int k = -half; k <= half; ++k) {
+        double s = 0;
+        for (int j = 0; j < p; ++j)
+            s += m[size_t(j * (p + 1) + p)] / m[size_t(j * (p + 1) + j)] * std::pow(double(k), j);
+        coeffs[size_t(k + half)] = s;
+    }
+    return coeffs;
+}
+
+// Биквад (транспонированная форма II), состояние - установившееся для первой точки,
+// чтобы не было переходного процесса от нуля
+struct Biquad
+{
+    double b0, b1, b2, a1, a2;
+    double z1{0.0}, z2{0.0};
+
+    explicit Biquad(const std::vector<double> &c)
+        : b0(c[0]), b1(c[1]), b2(c[2]), a1(c[3]), a2(c[4])
+    {}
+    void init(double x0)
+    {
+        z1 = (1.0 - b0) * x0;
+        z2 = (b2 - a2) * x0;
+    }
+    double step(double x)
+    {
+        const double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+};
+
+} // namespace
+
+// =========================================================================
+// НАСТРОЙКА
+// =========================================================================
+void SignalFilter::addStage(const Stage &stage)
+{
+    m_stages.append(compile(stage));
+}
+
+QVector<SignalFilter::Stage> SignalFilter::stages() const
+{
+    QVector<Stage> res;
+    res.reserve(m_stages.size());
+    for (const Compiled &c : m_stages)
+        res.append(c.stage);
+    return res;
+}
+
+bool SignalFilter::needsBatch() const
+{
+    for (const Compiled &c : m_stages)
+        if (c.stage.type == LowPass)
+            return true;
+    return false;
+}
+
+SignalFilter::Compiled SignalFilter::compile(const Stage &stage)
+{
+    Compiled c;
+    c.stage = stage;
+    if (stage.type == LowPass) {
+        c.stage.cutoff = qBound(1e-6, stage.cutoff, 0.49);
+        // Баттерворт 2-го порядка через билинейное преобразование
+        const double K = std::tan(M_PI * c.stage.cutoff);
+        const double sqrt2 = std::sqrt(2.0);
+        const double norm = 1.0 / (1.0 + sqrt2 * K + K * K);
+        const double b0 = K * K * norm;
+        c.coeffs = {b0, 2.0 * b0, b0, 2.0 * (K * K - 1.0) * norm, (1.0 - sqrt2 * K + K * K) * norm};
+        return c;
+    }
+
+    // Окно - нечетное, не меньше 3
+    c.stage.window = qMax(3, stage.window | 1);
+    c.half = c.stage.window / 2;
+    if (stage.type == SavitzkyGolay) {
+        c.stage.order = qBound(0, stage.order, c.stage.window - 1);
+        c.coeffs = savitzkyGolay(c.half, c.stage.order);
+    }
+    return c;
+}
+
+template<class Get>
+double SignalFilter::evalAt(const Compiled &c, Get &&get, qint64 n, qint64 i,
+                            std::vector<double> &scratch)
+{
+    const qint64 h = c.half;
+    if (c.stage.type == SavitzkyGolay) {
+        double acc = 0.0;
+        for (qint64 k = -h; k <= h; ++k)
+            acc += c.coeffs[size_t(k + h)] * get(reflect(i + k, n));
+        return acc;
+    }
+
+    // Median / Hampel: окно у краев укорачивается
+    const qint64 lo = qMax(qint64(0), i - h);
+    const qint64 hi = qMin(n - 1, i + h);
+    const int cnt = int(hi - lo + 1);
+    scratch.resize(size_t(2 * cnt));
+    double *w = scratch.data();
+    for (int k = 0; k < cnt; ++k)
+        w[k] = get(lo + k);
+    const double med = medianOf(w, cnt);
+    if (c.stage.type == Median)
+        return med;
+
+    const double x = get(i);
+    double *dev = w + cnt;
+    for (int k = 0; k < cnt; ++k)
+        dev[k] = std::fabs(get(lo + k) - med);
+    const double sigma = 1.4826 * medianOf(dev, cnt);
+    return (std::fabs(x - med) > c.stage.threshold * sigma) ? med : x;
+}
+
+// =========================================================================
+// ПАКЕТ
+// =========================================================================
+void SignalFilter::apply(const double *in, double *out, qint64 n) const
+{
+    if (n <= 0)
+        return;
+    if (m_stages.isEmpty()) {
+        if (in != out)
+            std::memcpy(out, in, size_t(n) * sizeof(double));
+        return;
+    }
+
+    // Ступени пишут поочередно в out и scratch так, чтобы последняя попала в out;
+    // вход и выход ступени всегда разные
+    const int count = m_stages.size();
+    std::vector<double> scratch;
+    if (count > 1 || in == out)
+        scratch.resize(size_t(n));
+    const double *src = in;
+    if (in == out && (count & 1)) {
+        std::memcpy(scratch.data(), in, size_t(n) * sizeof(double));
+        src = scratch.data();
+    }
+    for (int s = 0; s < count; ++s) {
+        double *dst = ((count - 1 - s) & 1) ? scratch.data() : out;
+        applyStage(m_stages[s], src, dst, n);
+        src = dst;
+    }
+}
+
+void SignalFilter::applyStage(const Compiled &c, const double *in, double *out, qint64 n)
+{
+    const qint64 h = c.half;
+    const auto get = [in](qint64 j) { return in[j]; };
+    std::vector<double> tmp;
+
+    if (c.stage.type == LowPass) {
+        // Вперед, затем назад по результату: фазы взаимно компенсируются
+        Biquad f(c.coeffs);
+        f.init(in[0]);
+        for (qint64 i = 0; i < n; ++i)
+            out[i] = f.step(in[i]);
+        Biquad b(c.coeffs);
+        b.init(out[n - 1]);
+        for (qint64 i = n - 1; i >= 0; --i)
+            out[i] = b.step(out[i]);
+        return;
+    }
+
+    // Короткий сигнал или края - общим правилом (как в потоке)
+    const qint64 edge = qMin(h, n);
+    for (qint64 i = 0; i < edge; ++i)
+        out[i] = evalAt(c, get, n, i, tmp);
+    for (qint64 i = qMax(edge, n - h); i < n; ++i)
+        out[i] = evalAt(c, get, n, i, tmp);
+    if (n <= 2 * h)
+        return;
+
+    if (c.stage.type == SavitzkyGolay) {
+        // Свертка блоками: цикл по отводам снаружи, по точкам внутри -
+        // внутренний цикл без зависимостей, компилятор разворачивает его в SIMD.
+        // Порядок сложения тот же, что в evalAt, поэтому результат совпадает с потоком.
+        const int taps = int(2 * h + 1);
+        const double *coeffs = c.coeffs.data();
+        // Накопитель - локальный блок: компилятор знает, что он не пересекается со входом.
+        // Длина блока - константа (векторизуется и при -O2); неполный хвост - через evalAt.
+        double acc[BlockSize];
+        qint64 b = h;
+        for (; b + BlockSize <= n - h; b += BlockSize) {
+            std::fill(acc, acc + BlockSize, 0.0);
+            for (int t = 0; t < taps; ++t) {
+                const double ct = coeffs[t];
+                const double *src = in + b - h + t;
+                for (qint64 j = 0; j < BlockSize; ++j)
+                    acc[j] += ct * src[j];
+            }
+            std::memcpy(out + b, acc, sizeof(acc));
+        }
+        for (; b < n - h; ++b)
+            out[b] = evalAt(c, get, n, b, tmp);
+        return;
+    }
+
+    // Median / Hampel: отсортированное окно сдвигается на точку (удалить + вставить),
+    // медиана - его центр. MAD - слиянием отклонений от центра к краям окна:
+    // слева и справа они уже упорядочены, h-е по величине находится за h шагов.
+    std::vector<double> win(in, in + 2 * h + 1);
+    std::sort(win.begin(), win.end());
+    for (qint64 i = h; i < n - h; ++i) {
+        const double med = win[size_t(h)];
+        if (c.stage.type == Median) {
+            out[i] = med;
+        } else {
+            qint64 l = h - 1, r = h + 1;
+            double mad = 0.0; // Отклонение самого центра
+            for (qint64 k = 0; k < h; ++k) {
+                const double dl = (l >= 0) ? med - win[size_t(l)] : INFINITY;
+                const double dr = (r <= 2 * h) ? win[size_t(r)] - med : INFINITY;
+                if (dl <= dr) {
+                    mad = dl;
+                    --l;
+                } else {
+                    mad = dr;
+                    ++r;
+                }
+            }
+            const double sigma = 1.4826 * mad;
+            out[i] = (std::fabs(in[i] - med) > c.stage.threshold * sigma) ? med : in[i];
+        }
+        if (i + h + 1 < n) {
+            // Уходящую точку заменяем новой и сдвигаем на место одним проходом
+            const double nw = in[i + h + 1];
+            double *w = win.data();
+            qint64 p = std::lower_bound(win.begin(), win.end(), in[i - h]) - win.begin();
+            if (nw > w[p]) {
+                for (; p < 2 * h && w[p + 1] < nw; ++p)
+                    w[p] = w[p + 1];
+            } else {
+                for (; p > 0 && w[p - 1] > nw; --p)
+                    w[p] = w[p - 1];
+            }
+            w[p] = nw;
+        }
+    }
+}
+
+// =========================================================================
+// ПОТОК
+// =========================================================================
+SignalFilter::Stream::Stream(const SignalFilter &filter)
+    : m_stages(filter.m_stages)
+    , m_states(size_t(filter.m_stages.size()))
+{
+    for (int k = 0; k < m_stages.size(); ++k)
+        m_states[size_t(k)].ring.resize(size_t(2 * m_stages[k].half + 1));
+}
+
+int SignalFilter::Stream::latency() const
+{
+    int res = 0;
+    for (const Compiled &c : m_stages)
+        res += c.half;
+    return res;
+}
+
+void SignalFilter::Stream::push(double x, QVector<double> *out)
+{
+    m_a.clear();
+    m_a.append(x);
+    for (int k = 0; k < m_stages.size() && !m_a.isEmpty(); ++k) {
+        m_b.clear();
+        for (const double v : std::as_const(m_a))
+            pushStage(k, v, &m_b);
+        std::swap(m_a, m_b);
+    }
+    out->append(m_a);
+}
+
+void SignalFilter::Stream::finish(QVector<double> *out)
+{
+    m_a.clear();
+    for (int k = 0; k < m_stages.size(); ++k) {
+        m_b.clear();
+        for (const double v : std::as_const(m_a))
+            pushStage(k, v, &m_b);
+        flushStage(k, &m_b);
+        std::swap(m_a, m_b);
+    }
+    out->append(m_a);
+}
+
+void SignalFilter::Stream::pushStage(int k, double x, QVector<double> *out)
+{
+    const Compiled &c = m_stages[k];
+    State &st = m_states[size_t(k)];
+
+    if (c.stage.type == LowPass) {
+        // В потоке - только прямой проход (причинный фильтр)
+        Biquad f(c.coeffs);
+        if (st.started) {
+            f.z1 = st.z1;
+            f.z2 = st.z2;
+        } else {
+            f.init(x);
+            st.started = true;
+        }
+        out->append(f.step(x));
+        st.z1 = f.z1;
+        st.z2 = f.z2;
+        return;
+    }
+
+    const qint64 size = qint64(st.ring.size());
+    st.ring[size_t(st.received % size)] = x;
+    ++st.received;
+    const auto get = [&st, size](qint64 j) { return st.ring[size_t(j % size)]; };
+    while (st.emitted + c.half < st.received) {
+        out->append(evalAt(c, get, st.received, st.emitted, m_scratch));
+        ++st.emitted;
+    }
+}
+
+void SignalFilter::Stream::flushStage(int k, QVector<double> *out)
+{
+    const Compiled &c = m_stages[k];
+    State &st = m_states[size_t(k)];
+    if (c.stage.type == LowPass)
+        return;
+
+    const qint64 size = qint64(st.ring.size());
+    const auto get = [&st, size](qint64 j) { return st.ring[size_t(j % size)]; };
+    while (st.emitted < st.received) {
+        out->append(evalAt(c, get, st.received, st.emitted, m_scratch));
+        ++st.emitted;
+    }
+}
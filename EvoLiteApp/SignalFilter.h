@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+// Цепочка фильтров сигнала (сила с тензодатчика) перед анализом.
+// Ступени выполняются по порядку:
+//   Hampel        - выбросы: точка дальше threshold * СКО (по MAD) от медианы окна
+//                   заменяется медианой;
+//   Median        - скользящая медиана окна window;
+//   SavitzkyGolay - полином степени order по окну window (сохраняет пики лучше среднего);
+//   LowPass       - Баттерворт 2-го порядка, cutoff - доля частоты отсчетов (< 0.5);
+//                   в пакете - вперед и назад (нулевая фаза).
+//
+// Два режима:
+//   apply()  - пакет по всему массиву: внутренняя часть - блочными циклами,
+//              которые компилятор векторизует, края - по тем же правилам, что поток;
+//   Stream   - по точке, выход задержан на latency() точек. Для Hampel, Median и
+//              SavitzkyGolay результат совпадает с пакетом; LowPass в потоке идет
+//              только вперед (нулевая фаза требует всего массива), поэтому с ним
+//              поток - предварительный, а окончательное - пакет.
+class SignalFilter
+{
+public:
+    enum StageType { Hampel = 0, Median, SavitzkyGolay, LowPass };
+
+    struct Stage
+    {
+        StageType type{Median};
+        int window{5};          // Нечетное, точек (Hampel, Median, SavitzkyGolay)
+        int order{2};           // Степень полинома (SavitzkyGolay)
+        double threshold{3.0};  // В СКО (Hampel)
+        double cutoff{0.05};    // Доля частоты отсчетов (LowPass)
+    };
+
+    void addStage(const Stage &stage);
+    void clear() { m_stages.clear(); }
+    bool isEmpty() const { return m_stages.isEmpty(); }
+    QVector<Stage> stages() const;
+    // Есть ступень, у которой поток не совпадает с пакетом
+    bool needsBatch() const;
+
+    // in и out могут совпадать
+    void apply(const double *in, double *out, qint64 n) const;
+
+private:
+    // Ступень с заранее посчитанными коэффициентами
+    struct Compiled
+    {
+        Stage stage;
+        int half{0};
+        std::vector<double> coeffs; // SavitzkyGolay: 2*half+1; LowPass: b0 b1 b2 a1 a2
+    };
+
+public:
+    class Stream
+    {
+    public:
+        Stream() = default;
+        explicit Stream(const SignalFilter &filter);
+
+        // Новая точка; готовые (задержанные) точки дописываются в out
+        void push(double x, QVector<double> *out);
+        // Конец данных: выдать задержанный хвост
+        void finish(QVector<double> *out);
+        int latency() const;
+
+    private:
+        // Окно последних точек ступени (кольцо) и состояние биквада
+        struct State
+        {
+            std::vector<double> ring;
+            qint64 received{0};
+            qint64 emitted{0};
+            double z1{0.0};
+            double z2{0.0};
+            bool started{false};
+        };
+        QVector<Compiled> m_stages;
+        std::vector<State> m_states;
+        QVector<double> m_a; // Выход ступени - вход следующей
+        QVector<double> m_b;
+
+        std::vector<double> m_scratch;
+
+        void pushStage(int k, double x, QVector<double> *out);
+        void flushStage(int k, QVector<double> *out);
+    };
+
+private:
+    QVector<Compiled> m_stages;
+
+    static Compiled compile(const Stage &stage);
+    static void applyStage(const Compiled &c, const double *in, double *out, qint64 n);
+    // Значение FIR-ступени в точке i по отсчетам get(j), j - в пределах [0, n)
+    // и окна ступени; края - по правилам ступени. Общая для пакета (края) и потока.
+    template<class Get>
+    static double evalAt(const Compiled &c, Get &&get, qint64 n, qint64 i,
+                         std::vector<double> &scratch);
+
+    friend class Stream;
+};
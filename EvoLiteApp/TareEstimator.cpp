@@ -0,0 +1,78 @@
+#include "TareEstimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Медиана на месте (порядок элементов портится)
+double medianInPlace(double *first, int n)
+{
+    double *mid = first + n / 2;
+    std::nth_element(first, mid, first + n);
+    if (n % 2 != 0)
+        return *mid;
+    // Четное окно: среднее двух центральных, второй - максимум левой половины
+    return 0.5 * (*mid + *std::max_element(first, mid));
+}
+} // namespace
+
+void TareEstimator::configure(int windowMs, Method method, double trim)
+{
+    m_windowUs = qMax<qint64>(1, windowMs) * 1000;
+    m_method = method;
+    m_trim = qBound(0.0, trim, 0.45);
+}
+
+void TareEstimator::add(double value, qint64 timestampUs)
+{
+    m_values[m_head] = value;
+    m_times[m_head] = timestampUs;
+    m_head = (m_head + 1) % Capacity;
+    if (m_size < Capacity)
+        ++m_size;
+}
+
+void TareEstimator::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+TareEstimator::Estimate TareEstimator::estimate() const
+{
+    Estimate e;
+    if (m_size == 0)
+        return e;
+
+    // Отсчеты окна - от новых к старым, пока не вышли за windowMs
+    std::array<double, Capacity> work;
+    const int newest = (m_head + Capacity - 1) % Capacity;
+    const qint64 since = m_times[newest] - m_windowUs;
+    qint64 oldestUs = m_times[newest];
+    int n = 0;
+    for (int i = 0; i < m_size; ++i) {
+        const int idx = (newest + Capacity - i) % Capacity;
+        if (m_times[idx] < since)
+            break;
+        work[n++] = m_values[idx];
+        oldestUs = m_times[idx];
+    }
+    e.count = n;
+    e.valid = n >= 3 && (m_times[newest] - oldestUs) * 2 >= m_windowUs;
+
+    if (m_method == TrimmedMean) {
+        std::sort(work.begin(), work.begin() + n);
+        const int cut = int(n * m_trim);
+        double sum = 0.0;
+        for (int i = cut; i < n - cut; ++i)
+            sum += work[i];
+        e.value = sum / (n - 2 * cut);
+    } else {
+        e.value = medianInPlace(work.data(), n);
+    }
+
+    // Шум: медиана абсолютных отклонений от оценки
+    for (int i = 0; i < n; ++i)
+        work[i] = std::abs(work[i] - e.value);
+    e.noise = 1.4826 * medianInPlace(work.data(), n);
+    return e;
+}
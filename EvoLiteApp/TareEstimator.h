@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QtGlobal>
+#include <array>
+
+// Робастная оценка нуля канала по скользящему окну времени.
+// Один отсчет датчика шумит и ловит выбросы (удар, наводка), поэтому тара
+// берется как медиана или усеченное среднее окна, а шум - как MAD.
+// add() - O(1) без выделения памяти, estimate() - O(n) по окну (n <= Capacity);
+// подходит для непрерывной работы в потоке опроса.
+class TareEstimator
+{
+public:
+    enum Method { Median = 0, TrimmedMean };
+
+    struct Estimate
+    {
+        double value{0.0};
+        double noise{0.0}; // СКО по MAD (1.4826 * MAD) - устойчиво к выбросам
+        int count{0};      // Отсчетов в окне
+        bool valid{false}; // Окно заполнено хотя бы наполовину
+    };
+
+    static constexpr int Capacity = 1024; // Предел окна в отсчетах (1 с при 1 кГц)
+
+    // windowMs - длина окна по времени (частота отсчетов может меняться);
+    // trim - доля, отбрасываемая с каждого края для TrimmedMean
+    void configure(int windowMs, Method method = Median, double trim = 0.2);
+    int windowMs() const { return int(m_windowUs / 1000); }
+    Method method() const { return m_method; }
+
+    void add(double value, qint64 timestampUs);
+    void clear();
+
+    // Оценка по отсчетам не старше windowMs от последнего
+    Estimate estimate() const;
+
+private:
+    std::array<double, Capacity> m_values{};
+    std::array<qint64, Capacity> m_times{};
+    int m_head{0}; // Следующий слот записи
+    int m_size{0};
+    qint64 m_windowUs{500000};
+    Method m_method{Median};
+    double m_trim{0.2};
+};
@@ -79,17 +79,47 @@ void TensilePlotWidget::addLivePoint(double forceN, double extensionMm)
     this->replot();
 }
 
+void TensilePlotWidget::addLivePoints(const QVector<QPointF> &forceExtension)
+{
+    if (forceExtension.isEmpty())
+        return;
+
+    QVector<double> keys;
+    QVector<double> values;
+    keys.reserve(forceExtension.size());
+    values.reserve(forceExtension.size());
+    for (const QPointF &pt : forceExtension) {
+        keys.append((pt.y() / m_L0) * 100.0);
+        values.append(pt.x() / m_S0);
+    }
+    m_mainCurve->addData(keys, values);
+    m_mainCurve->rescaleAxes(true);
+
+    // Одна перерисовка на пачку, в ближайшем цикле событий
+    this->replot(QCustomPlot::rpQueuedReplot);
+}
+
 void TensilePlotWidget::plotFinalAnalysis(const Iso6892Results &results,
-                                          const QVector<QPointF> &correctedCurve)
+                                          const SampleArena::View &strain,
+                                          const SampleArena::View &stress)
 {
     if (!results.isValid)
         return;
 
-    // 1. Заменяем "сырой" график на "скорректированный" (красивый, из нуля)
-    m_mainCurve->data()->clear();
-    for (const QPointF &pt : correctedCurve) {
-        m_mainCurve->addData(pt.x(), pt.y());
+    // 1. Заменяем "сырой" график на "скорректированный" (красивый, из нуля).
+    // Один проход по видам сразу в формат графика; вектор отдается контейнеру
+    // графика без копии (неявное разделение), поэтому сортируем его заранее
+    const int count = int(qMin(strain.size(), stress.size()));
+    QVector<QCPGraphData> data(count);
+    bool sorted = true;
+    for (int i = 0; i < count; ++i) {
+        data[i] = QCPGraphData(strain[i], stress[i]);
+        if (i > 0 && data[i].key < data[i - 1].key)
+            sorted = false;
     }
+    if (!sorted)
+        std::sort(data.begin(), data.end(), qcpLessThanSortKey<QCPGraphData>);
+    m_mainCurve->data()->set(data, true);
 
     // 2. Рисуем линию Модуля Упругости (Визуализация E)
     // Строим прямую y = E*x от 0 до, скажем, 0.5% деформации
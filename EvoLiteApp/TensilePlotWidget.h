@@ -22,10 +22,16 @@ public:
     // --- Метод для REAL-TIME отрисовки ---
     // Вызывайте его в цикле опроса датчиков
     void addLivePoint(double forceN, double extensionMm);
+    // Пачка точек (x - сила, Н; y - удлинение, мм) с одной перерисовкой:
+    // при сборе 1 кГц точки копятся между тиками GUI и добавляются разом
+    void addLivePoints(const QVector<QPointF> &forceExtension);
 
     // --- Метод для ПОСТ-АНАЛИЗА ---
     // Вызывайте его после окончания теста, когда Analyzer посчитал результаты
-    void plotFinalAnalysis(const Iso6892Results &results, const QVector<QPointF> &correctedCurve);
+    // strain (%) и stress (MPa) - виды анализатора; точки читаются прямо из арены
+    void plotFinalAnalysis(const Iso6892Results &results,
+                           const SampleArena::View &strain,
+                           const SampleArena::View &stress);
 
 private:
     // Параметры для конвертации на лету
@@ -0,0 +1,424 @@
+#include "TestJournal.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+enum FrameType : quint16 { FrameBegin = 1, FrameSamples = 2, FrameGap = 3, FrameEnd = 4 };
+
+const char Magic[4] = {'E', 'V', 'O', 'J'};
+const quint16 Version = 1;
+const int FileHeaderBytes = 8;
+const int FrameHeaderBytes = 8;
+const int SampleBytes = 32;
+const int MaxSamplesPerFrame = 1024;
+const quint32 MaxFrameBytes = 64 * 1024 * 1024; // Больше - заведомо мусор в длине
+
+quint32 crc32(const char *data, int size)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    quint32 crc = 0xFFFFFFFFu;
+    for (int i = 0; i < size; ++i)
+        crc = table[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template<class T>
+void put(QByteArray &buf, T value)
+{
+    value = qToLittleEndian(value);
+    buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void putFloat(QByteArray &buf, float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(buf, bits);
+}
+
+void putDouble(QByteArray &buf, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(buf, bits);
+}
+
+// Последовательное чтение полей кадра (границы проверены по длине кадра заранее)
+class Cursor
+{
+public:
+    explicit Cursor(const char *data)
+        : m_p(data)
+    {}
+
+    template<class T>
+    T get()
+    {
+        T value;
+        std::memcpy(&value, m_p, sizeof(T));
+        m_p += sizeof(T);
+        return qFromLittleEndian(value);
+    }
+    float getFloat()
+    {
+        const quint32 bits = get<quint32>();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    double getDouble()
+    {
+        const quint64 bits = get<quint64>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+private:
+    const char *m_p;
+};
+
+void appendFrame(QByteArray &out, FrameType type, const QByteArray &payload)
+{
+    const int start = out.size();
+    put<quint16>(out, type);
+    put<quint16>(out, 0);
+    put<quint32>(out, quint32(payload.size()));
+    out.append(payload);
+    put<quint32>(out, crc32(out.constData() + start, out.size() - start));
+}
+
+bool syncToDisk(QFile &file)
+{
+    if (!file.flush())
+        return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+// Разбор содержимого файла; validBytes - длина целой части (до первого битого кадра)
+bool parseJournal(const QByteArray &data,
+                  TestJournal::Recovered *out,
+                  qint64 *validBytes,
+                  QString *error)
+{
+    if (data.size() < FileHeaderBytes || std::memcmp(data.constData(), Magic, 4) != 0) {
+        if (error)
+            *error = QString("Not a test journal");
+        return false;
+    }
+    if (Cursor(data.constData() + 4).get<quint16>() != Version) {
+        if (error)
+            *error = QString("Unsupported journal version");
+        return false;
+    }
+
+    *out = TestJournal::Recovered();
+    qint64 pos = FileHeaderBytes;
+    while (pos < data.size()) {
+        if (data.size() - pos < FrameHeaderBytes) {
+            out->truncated = true;
+            break;
+        }
+        Cursor head(data.constData() + pos);
+        const quint16 type = head.get<quint16>();
+        head.get<quint16>();
+        const quint32 length = head.get<quint32>();
+        const qint64 frameBytes = FrameHeaderBytes + qint64(length) + 4;
+        if (length > MaxFrameBytes || data.size() - pos < frameBytes) {
+            out->truncated = true;
+            break;
+        }
+        const quint32 stored = Cursor(data.constData() + pos + frameBytes - 4).get<quint32>();
+        if (crc32(data.constData() + pos, int(frameBytes - 4)) != stored) {
+            out->truncated = true;
+            break;
+        }
+
+        Cursor c(data.constData() + pos + FrameHeaderBytes);
+        if (type == FrameBegin && length >= 8 * 5 + 2) {
+            out->header.areaS0 = c.getDouble();
+            out->header.gaugeLengthL0 = c.getDouble();
+            out->header.forceOffsetKgf = c.getDouble();
+            out->header.extOffsetMm = c.getDouble();
+            out->header.startedMsecs = c.get<qint64>();
+            out->header.rateHz = c.get<quint16>();
+        } else if (type == FrameSamples && length >= 4) {
+            const quint32 count = qMin<quint32>(c.get<quint32>(), (length - 4) / SampleBytes);
+            out->samples.reserve(out->samples.size() + int(count));
+            for (quint32 i = 0; i < count; ++i) {
+                MachineControl::Sample s;
+                s.seq = c.get<quint32>();
+                s.time = c.getFloat();
+                s.position = c.getFloat();
+                s.load = c.getFloat();
+                s.elongation = c.getFloat();
+                s.maxLoad = c.getFloat();
+                s.hostTimestampUs = c.get<qint64>();
+                out->samples.append(s);
+            }
+        } else if (type == FrameGap && length >= 8) {
+            out->lostSamples += c.get<quint64>();
+        } else if (type == FrameEnd && length >= 1) {
+            out->closed = true;
+            out->completed = c.get<quint8>() != 0;
+        }
+        pos += frameBytes;
+    }
+    *validBytes = pos > data.size() ? data.size() : pos;
+    return true;
+}
+} // namespace
+
+// =========================================================================
+// ПИСАТЕЛЬ (поток журнала)
+// =========================================================================
+class TestJournal::Writer : public QObject
+{
+public:
+    Writer(TestJournal *owner, MachineControl::SampleBuffer::Reader reader)
+        : m_owner(owner)
+        , m_reader(reader)
+    {
+        m_buffer.resize(MaxSamplesPerFrame);
+    }
+
+    bool open(const QString &path, const Header &h)
+    {
+        m_failed = false;
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            fail(QString("Cannot create journal %1: %2").arg(path, m_file.errorString()));
+            return false;
+        }
+        m_pending.clear();
+        m_pending.append(Magic, 4);
+        put<quint16>(m_pending, Version);
+        put<quint16>(m_pending, 0);
+
+        QByteArray payload;
+        putDouble(payload, h.areaS0);
+        putDouble(payload, h.gaugeLengthL0);
+        putDouble(payload, h.forceOffsetKgf);
+        putDouble(payload, h.extOffsetMm);
+        put<qint64>(payload, h.startedMsecs);
+        put<quint16>(payload, h.rateHz);
+        appendFrame(m_pending, FrameBegin, payload);
+
+        // Отсчеты - с момента старта, как и у анализа
+        m_reader.skipToHead();
+        m_dropped = m_reader.dropped();
+        commit();
+
+        if (!m_timer) {
+            m_timer = new QTimer(this);
+            connect(m_timer, &QTimer::timeout, this, [this]() {
+                drain();
+                commit();
+            });
+        }
+        m_timer->start(GroupCommitMs);
+        return !m_failed;
+    }
+
+    void close(bool completed)
+    {
+        if (!m_file.isOpen())
+            return;
+        m_timer->stop();
+        drain();
+        QByteArray payload;
+        put<quint8>(payload, completed ? 1 : 0);
+        appendFrame(m_pending, FrameEnd, payload);
+        commit();
+        m_file.close();
+    }
+
+private:
+    TestJournal *m_owner;
+    MachineControl::SampleBuffer::Reader m_reader;
+    QVector<MachineControl::Sample> m_buffer{};
+    QFile m_file{};
+    QTimer *m_timer{nullptr};
+    QByteArray m_pending{}; // Кадры, еще не сброшенные на диск
+    quint64 m_dropped{0};
+    bool m_failed{false};
+
+    // Все накопленное в кольце -> кадры в памяти (без обращения к диску)
+    void drain()
+    {
+        int n = 0;
+        while ((n = m_reader.read(m_buffer.data(), m_buffer.size())) > 0) {
+            if (m_reader.dropped() != m_dropped) {
+                QByteArray gap;
+                put<quint64>(gap, m_reader.dropped() - m_dropped);
+                appendFrame(m_pending, FrameGap, gap);
+                m_dropped = m_reader.dropped();
+            }
+            QByteArray payload;
+            payload.reserve(4 + n * SampleBytes);
+            put<quint32>(payload, quint32(n));
+            for (int i = 0; i < n; ++i) {
+                const MachineControl::Sample &s = m_buffer.at(i);
+                put<quint32>(payload, s.seq);
+                putFloat(payload, s.time);
+                putFloat(payload, s.position);
+                putFloat(payload, s.load);
+                putFloat(payload, s.elongation);
+                putFloat(payload, s.maxLoad);
+                put<qint64>(payload, s.hostTimestampUs);
+            }
+            appendFrame(m_pending, FrameSamples, payload);
+        }
+    }
+
+    // Групповая фиксация: одна запись и один fsync на все кадры за интервал
+    void commit()
+    {
+        if (m_pending.isEmpty() || !m_file.isOpen())
+            return;
+        if (m_file.write(m_pending) != m_pending.size() || !syncToDisk(m_file))
+            fail(QString("Journal write failed: %1").arg(m_file.errorString()));
+        m_pending.clear();
+    }
+
+    void fail(const QString &message)
+    {
+        if (m_failed)
+            return;
+        m_failed = true;
+        QMetaObject::invokeMethod(
+            m_owner, [owner = m_owner, message]() { emit owner->journalError(message); },
+            Qt::QueuedConnection);
+    }
+};
+
+// =========================================================================
+// ЖУРНАЛ
+// =========================================================================
+TestJournal::TestJournal(MachineControl *machine, QObject *parent)
+    : QObject(parent)
+{
+    m_thread = new QThread(this);
+    m_thread->setObjectName("TestJournal");
+    m_writer = new Writer(this, machine->createSampleReader());
+    m_writer->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+}
+
+TestJournal::~TestJournal()
+{
+    if (m_active)
+        end(false);
+    m_thread->quit();
+    m_thread->wait();
+}
+
+bool TestJournal::begin(const QString &path, const Header &header)
+{
+    if (m_active)
+        end(false);
+    bool ok = false;
+    QMetaObject::invokeMethod(
+        m_writer, [&]() { ok = m_writer->open(path, header); }, Qt::BlockingQueuedConnection);
+    m_active = ok;
+    m_path = path;
+    return ok;
+}
+
+void TestJournal::end(bool completed)
+{
+    if (!m_active)
+        return;
+    // Синхронно: после возврата журнал закрыт и на диске
+    QMetaObject::invokeMethod(
+        m_writer, [&]() { m_writer->close(completed); }, Qt::BlockingQueuedConnection);
+    m_active = false;
+}
+
+QString TestJournal::defaultDirectory()
+{
+    const QString dir = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+                            .filePath("journal");
+    QDir().mkpath(dir);
+    return dir;
+}
+
+QString TestJournal::newJournalPath()
+{
+    return QDir(defaultDirectory())
+        .filePath(QString("test_%1.evj")
+                      .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss_zzz")));
+}
+
+bool TestJournal::read(const QString &path, Recovered *out, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    qint64 validBytes = 0;
+    return parseJournal(file.readAll(), out, &validBytes, error);
+}
+
+QString TestJournal::findUnfinished()
+{
+    // Сбой прерывает только последнее испытание - смотрим самый свежий журнал
+    const QFileInfoList files = QDir(defaultDirectory())
+                                    .entryInfoList({"*.evj"}, QDir::Files, QDir::Time);
+    if (files.isEmpty())
+        return {};
+    Recovered rec;
+    const QString path = files.first().absoluteFilePath();
+    if (read(path, &rec) && !rec.closed)
+        return path;
+    return {};
+}
+
+bool TestJournal::seal(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+    Recovered rec;
+    qint64 validBytes = 0;
+    if (!parseJournal(file.readAll(), &rec, &validBytes, nullptr))
+        return false;
+    if (rec.closed)
+        return true;
+
+    QByteArray tail;
+    QByteArray payload;
+    put<quint8>(payload, 0);
+    appendFrame(tail, FrameEnd, payload);
+    return file.resize(validBytes) && file.seek(validBytes) && file.write(tail) == tail.size()
+           && syncToDisk(file);
+}
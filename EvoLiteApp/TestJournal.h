@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "MachineControl.h"
+
+class QThread;
+
+// Журнал испытания: append-only файл с кадрами под CRC32, пишется в своем потоке.
+// Отсчеты берутся из кольца драйвера собственным курсором, поэтому диск
+// не тормозит ни опрос, ни анализ. Кадры копятся и сбрасываются на диск
+// группой (flush + fsync) раз в GroupCommitMs - после сбоя теряется не больше.
+//
+// Файл: "EVOJ" u16 версия, u16 0, затем кадры
+//   u16 тип, u16 0, u32 длина, данные, u32 CRC32(тип..данные)
+// Все числа little-endian. Оборванный хвост (запись при сбое) отсекается по CRC.
+class TestJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Все, что нужно для повторного расчета без формы
+    struct Header
+    {
+        double areaS0{0.0};       // мм²
+        double gaugeLengthL0{0.0}; // мм
+        double forceOffsetKgf{0.0}; // Тара на момент старта
+        double extOffsetMm{0.0};
+        qint64 startedMsecs{0}; // UTC, мс от эпохи
+        quint16 rateHz{0};      // Частота FIFO (0 - снимки)
+    };
+
+    struct Recovered
+    {
+        Header header{};
+        QVector<MachineControl::Sample> samples{};
+        quint64 lostSamples{0}; // Журнал отстал от кольца (кадры Gap)
+        bool completed{false};  // Есть кадр End с нормальным завершением
+        bool closed{false};     // Есть кадр End (любой)
+        bool truncated{false};  // Хвост оборван - отсечен по CRC
+    };
+
+    static constexpr int GroupCommitMs = 250;
+
+    explicit TestJournal(MachineControl *machine, QObject *parent = nullptr);
+    ~TestJournal();
+
+    // Начать журнал (пишет заголовок и сразу фиксирует его на диске)
+    bool begin(const QString &path, const Header &header);
+    // Дописать накопленное, кадр End и закрыть файл
+    void end(bool completed);
+    bool isActive() const { return m_active; }
+    QString path() const { return m_path; }
+
+    // Каталог журналов и имя файла для нового испытания
+    static QString defaultDirectory();
+    static QString newJournalPath();
+
+    // Чтение журнала; false - файл не открывается или это не журнал
+    static bool read(const QString &path, Recovered *out, QString *error = nullptr);
+    // Последний журнал без кадра End (испытание прервано сбоем), иначе пусто
+    static QString findUnfinished();
+    // Закрыть прерванный журнал: отсечь оборванный хвост и дописать End
+    static bool seal(const QString &path);
+
+signals:
+    void journalError(const QString &message);
+
+private:
+    class Writer;
+
+    QThread *m_thread{nullptr};
+    Writer *m_writer{nullptr};
+    bool m_active{false};
+    QString m_path{};
+};
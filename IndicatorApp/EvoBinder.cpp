@@ -0,0 +1,119 @@
+#include "EvoBinder.h"
+
+namespace EvoModbus {
+
+// =========================================================
+// BINDER IMPLEMENTATION
+// =========================================================
+
+Binder::Binder(Controller *c, QObject *p)
+    : QObject(p)
+    , m_controller(c)
+{
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    connect(m_frameTimer, &QTimer::timeout, this, &Binder::syncUI);
+    connect(m_controller, &Controller::channelsUpdated, this, &Binder::onChannelsUpdated);
+}
+void Binder::bindLabel(QLabel *w, const std::string &id)
+{
+    if (w)
+        addBinding({w, id, 0, 1.0, nullptr});
+}
+void Binder::bindLCD(QLCDNumber *w, const std::string &id, double s)
+{
+    if (w)
+        addBinding({w, id, 1, s, nullptr});
+}
+void Binder::bindProgressBar(QProgressBar *w, const std::string &id)
+{
+    if (w)
+        addBinding({w, id, 2, 1.0, nullptr});
+}
+void Binder::bindCustom(const std::string &id, Callback cb)
+{
+    addBinding({nullptr, id, 3, 1.0, cb});
+}
+
+void Binder::addBinding(const BindItem &item)
+{
+    m_bindings.append(item);
+    auto &g = m_groups[QString::fromStdString(item.id)];
+    g.items.append(m_bindings.size() - 1);
+    g.seenRevision = 0; // новая привязка должна получить текущее значение
+    onChannelsUpdated();
+}
+
+void Binder::setMaxFps(int fps)
+{
+    m_maxFps = qMax(0, fps);
+}
+
+void Binder::onChannelsUpdated()
+{
+    // Кадр уже запланирован - это обновление войдет в него
+    if (m_frameTimer->isActive())
+        return;
+    if (m_maxFps <= 0 || !m_lastFrame.isValid()) {
+        syncUI();
+        return;
+    }
+    const qint64 frameMs = 1000 / m_maxFps;
+    const qint64 wait = frameMs - m_lastFrame.elapsed();
+    if (wait <= 0)
+        syncUI();
+    else
+        m_frameTimer->start(static_cast<int>(wait));
+}
+
+void Binder::syncUI()
+{
+    m_lastFrame.start();
+    const auto &channels = m_controller->channels();
+    for (auto g = m_groups.begin(); g != m_groups.end(); ++g) {
+        auto it = channels.constFind(g.key());
+        if (it == channels.constEnd() || it->revision == g->seenRevision)
+            continue;
+        g->seenRevision = it->revision;
+        for (int idx : qAsConst(g->items))
+            applyItem(m_bindings[idx], *it);
+    }
+}
+
+void Binder::applyItem(BindItem &b, const ChannelData &d)
+{
+    if (b.type == 3) {
+        if (b.customCb)
+            b.customCb(d);
+        return;
+    }
+    if (b.widget.isNull())
+        return;
+
+    const double v = d.value.toDouble() * b.scale;
+    if (b.type == 0) {
+        // Виджет трогаем, только если изменился сам текст (округление до 2 знаков)
+        b.formatter.setUnit(d.unit);
+        const QStringView text = b.formatter.view(v);
+        if (b.hasShown && text == QStringView(b.text))
+            return;
+        b.text = text.toString();
+        static_cast<QLabel *>(b.widget.data())->setText(b.text);
+    } else if (b.type == 1) {
+        if (b.hasShown && v == b.shown)
+            return;
+        static_cast<QLCDNumber *>(b.widget.data())->display(v);
+    } else if (b.type == 2) {
+        const double pos = static_cast<int>(d.value.toDouble());
+        if (b.hasShown && pos == b.shown)
+            return;
+        b.shown = pos;
+        b.hasShown = true;
+        static_cast<QProgressBar *>(b.widget.data())->setValue(static_cast<int>(pos));
+        return;
+    }
+    b.shown = v;
+    b.hasShown = true;
+}
+
+} // namespace EvoModbus
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLCDNumber>
+#include <QLabel>
+#include <QPointer>
+#include <QProgressBar>
+#include <QTimer>
+#include <functional>
+#include "EvoModbus.h"
+
+namespace EvoModbus {
+
+// =========================================================
+// BINDER (Presentation Helper)
+// =========================================================
+class Binder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Binder(Controller *controller, QObject *parent = nullptr);
+
+    void bindLabel(QLabel *label, const std::string &channelId);
+    void bindLCD(QLCDNumber *lcd, const std::string &channelId, double scale = 1.0);
+    void bindProgressBar(QProgressBar *bar, const std::string &channelId);
+
+    using Callback = std::function<void(const ChannelData &)>;
+    void bindCustom(const std::string &channelId, Callback callback);
+
+    // Ограничение частоты обновления виджетов (кадров в секунду).
+    // Все обновления контроллера между кадрами сливаются в одну перерисовку.
+    // 0 - без ограничения (обновление на каждый channelsUpdated).
+    void setMaxFps(int fps);
+    int maxFps() const { return m_maxFps; }
+
+private slots:
+    void onChannelsUpdated();
+    void syncUI();
+
+private:
+    Controller *m_controller{nullptr};
+    struct BindItem
+    {
+        QPointer<QWidget> widget;
+        std::string id{};
+        int type{0};
+        double scale{1.0};
+        Callback customCb{nullptr};
+
+        // Кэш последнего отображенного состояния
+        EvoUnit::Formatter formatter{};
+        QString text{};
+        double shown{0.0};
+        bool hasShown{false};
+    };
+    // Привязки, сгруппированные по каналу: одна проверка ревизии на канал
+    struct ChannelGroup
+    {
+        QVector<int> items{};
+        quint64 seenRevision{0};
+    };
+    QVector<BindItem> m_bindings{};
+    QHash<QString, ChannelGroup> m_groups{};
+
+    QTimer *m_frameTimer{nullptr};
+    QElapsedTimer m_lastFrame{};
+    int m_maxFps{30};
+
+    void addBinding(const BindItem &item);
+    void applyItem(BindItem &b, const ChannelData &d);
+};
+
+} // namespace EvoModbus
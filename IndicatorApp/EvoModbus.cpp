@@ -1,4 +1,5 @@
 #include "EvoModbus.h"
+#include <QDateTime>
 #include <QDebug>
 #include <QMetaEnum>
 #include <QtGlobal>
@@ -85,6 +86,8 @@ void Manager::stopPolling()
 
 void Manager::onStateChanged(QModbusDevice::State state)
 {
+    if (state == QModbusDevice::UnconnectedState)
+        m_pendingReplies = 0;
     emit connectionStateChanged(static_cast<int>(state));
     if (state == QModbusDevice::ConnectedState)
         qDebug() << "[EvoModbus] Connected";
@@ -196,13 +199,21 @@ void Manager::onPollTimer()
 {
     if (m_modbus->state() != QModbusDevice::ConnectedState)
         return;
+    // Устройство не успевает отвечать: пропускаем цикл, а не копим запросы
+    if (m_pendingReplies > 0) {
+        ++m_skippedPolls;
+        return;
+    }
+    m_pollClock.start();
     for (const auto &b : qAsConst(m_blocks)) {
         QModbusDataUnit unit(b.regType, b.startAddress, b.count);
         if (auto *r = m_modbus->sendReadRequest(unit, b.serverAddress)) {
-            if (!r->isFinished())
+            if (!r->isFinished()) {
+                ++m_pendingReplies;
                 connect(r, &QModbusReply::finished, this, &Manager::onReadReady);
-            else
+            } else {
                 delete r;
+            }
         }
     }
 }
@@ -211,35 +222,62 @@ void Manager::onReadReady()
     auto r = qobject_cast<QModbusReply *>(sender());
     if (!r)
         return;
+    m_pendingReplies = qMax(0, m_pendingReplies - 1);
     if (r->error() == QModbusDevice::NoError) {
-        auto unit = r->result();
-        bool chg = false;
-        for (const auto &s : qAsConst(m_sources)) {
-            if (s.serverAddress != r->serverAddress() || s.regType != unit.registerType())
-                continue;
-            int len = getRegisterCount(s.valueType);
-            if (s.valueAddress >= unit.startAddress()
-                && (s.valueAddress + len) <= (unit.startAddress() + unit.valueCount())) {
-                int off = s.valueAddress - unit.startAddress();
-                QVector<quint16> d;
-                if (s.isBitType())
-                    d.append(unit.value(off));
-                else
-                    for (int k = 0; k < len; ++k)
-                        d.append(unit.value(off + k));
-                QVariant v = parseValue(s, d);
-                QString k = QString::fromStdString(s.id);
-                if (m_rawData.value(k) != v) {
-                    m_rawData[k] = v;
-                    chg = true;
-                }
-            }
-        }
-        if (chg)
+        m_lastRoundTripUs = m_pollClock.nsecsElapsed() / 1000;
+        const QModbusDataUnit unit = r->result();
+        if (m_journal.isOpen())
+            m_journal.append(r->serverAddress(), unit);
+        if (decodeUnit(r->serverAddress(), unit))
             emit rawDataUpdated();
     }
     r->deleteLater();
 }
+void Manager::injectData(int serverAddress, const QModbusDataUnit &unit)
+{
+    if (decodeUnit(serverAddress, unit))
+        emit rawDataUpdated();
+}
+bool Manager::decodeUnit(int serverAddress, const QModbusDataUnit &unit)
+{
+    bool chg = false;
+    for (const auto &s : qAsConst(m_sources)) {
+        if (s.serverAddress != serverAddress || s.regType != unit.registerType())
+            continue;
+        int len = getRegisterCount(s.valueType);
+        if (s.valueAddress >= unit.startAddress()
+            && (s.valueAddress + len) <= (unit.startAddress() + unit.valueCount())) {
+            int off = s.valueAddress - unit.startAddress();
+            QVector<quint16> d;
+            if (s.isBitType())
+                d.append(unit.value(off));
+            else
+                for (int k = 0; k < len; ++k)
+                    d.append(unit.value(off + k));
+            QVariant v = parseValue(s, d);
+            QString k = QString::fromStdString(s.id);
+            if (m_rawData.value(k) != v) {
+                m_rawData[k] = v;
+                chg = true;
+            }
+        }
+    }
+    return chg;
+}
+
+// Journal
+bool Manager::startRecording(const QString &filename)
+{
+    if (!m_journal.open(filename)) {
+        emit errorOccurred("Journal open failed: " + filename);
+        return false;
+    }
+    return true;
+}
+void Manager::stopRecording()
+{
+    m_journal.close();
+}
 
 // Helpers
 int Manager::getRegisterCount(int t)
@@ -326,6 +364,199 @@ QVector<quint16> Manager::decomposeFloat(float val, int order)
     return decomposeUInt32(i, order);
 }
 
+// =========================================================
+// JOURNAL IMPLEMENTATION
+// =========================================================
+
+static const quint32 JOURNAL_MAGIC{0x45564F4A}; // 'EVOJ'
+static const quint16 JOURNAL_VERSION{1};
+
+bool JournalWriter::open(const QString &filename)
+{
+    close();
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    m_stream.setDevice(&m_file);
+    m_stream << JOURNAL_MAGIC << JOURNAL_VERSION << QDateTime::currentMSecsSinceEpoch();
+    m_file.flush();
+    m_clock.start();
+    m_lastFlushUs = 0;
+    m_unflushed = 0;
+    return true;
+}
+void JournalWriter::close()
+{
+    if (!m_file.isOpen())
+        return;
+    m_stream.setDevice(nullptr);
+    m_file.close();
+}
+void JournalWriter::append(int serverAddress, const QModbusDataUnit &unit)
+{
+    if (!m_file.isOpen())
+        return;
+    const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    m_stream << nowUs
+             << static_cast<quint8>(serverAddress) << static_cast<quint8>(unit.registerType())
+             << static_cast<quint16>(unit.startAddress())
+             << static_cast<quint16>(unit.valueCount());
+    for (int i = 0; i < static_cast<int>(unit.valueCount()); ++i)
+        m_stream << unit.value(i);
+    if (++m_unflushed >= FlushRecords || nowUs - m_lastFlushUs >= FlushIntervalUs) {
+        m_file.flush();
+        m_lastFlushUs = nowUs;
+        m_unflushed = 0;
+    }
+}
+
+bool JournalReader::open(const QString &filename)
+{
+    close();
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+    m_stream.setDevice(&m_file);
+    m_stream.resetStatus(); // Статус прошлого файла (ReadPastEnd) не должен переехать сюда
+    quint32 magic = 0;
+    quint16 version = 0;
+    m_stream >> magic >> version >> m_startEpochMs;
+    if (magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+        close();
+        return false;
+    }
+    return true;
+}
+void JournalReader::close()
+{
+    m_stream.setDevice(nullptr);
+    m_file.close();
+}
+bool JournalReader::readNext(JournalRecord &rec)
+{
+    if (!m_file.isOpen() || m_stream.atEnd())
+        return false;
+    quint8 server = 0, reg = 0;
+    quint16 start = 0, count = 0;
+    m_stream >> rec.timestampUs >> server >> reg >> start >> count;
+    rec.values.resize(count);
+    for (int i = 0; i < count; ++i)
+        m_stream >> rec.values[i];
+    // Обрезанная последняя запись (запись прервана) - конец журнала
+    if (m_stream.status() != QDataStream::Ok)
+        return false;
+    rec.serverAddress = server;
+    rec.regType = static_cast<QModbusDataUnit::RegisterType>(reg);
+    rec.startAddress = start;
+    return true;
+}
+
+// =========================================================
+// REPLAY IMPLEMENTATION
+// =========================================================
+
+ReplaySource::ReplaySource(Manager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ReplaySource::onTick);
+}
+
+bool ReplaySource::open(const QString &filename)
+{
+    stop();
+    m_hasPending = false;
+    return m_reader.open(filename);
+}
+void ReplaySource::close()
+{
+    stop();
+    m_reader.close();
+}
+
+void ReplaySource::start(double speed)
+{
+    m_speed = speed;
+    m_hasPending = m_reader.readNext(m_pending);
+    if (!m_hasPending) {
+        finish();
+        return;
+    }
+    m_firstUs = m_pending.timestampUs;
+    m_running = true;
+    m_clock.start();
+    m_timer->start(0);
+}
+void ReplaySource::stop()
+{
+    m_running = false;
+    m_timer->stop();
+}
+
+int ReplaySource::runToEnd()
+{
+    stop();
+    int n = 0;
+    if (m_hasPending) {
+        feed(m_pending);
+        m_hasPending = false;
+        ++n;
+    }
+    JournalRecord rec;
+    while (m_reader.readNext(rec)) {
+        feed(rec);
+        ++n;
+    }
+    emit finished();
+    return n;
+}
+
+void ReplaySource::onTick()
+{
+    if (!m_running)
+        return;
+
+    // Без пауз: порциями, чтобы не блокировать цикл событий
+    static const int BATCH{256};
+    if (m_speed <= 0.0) {
+        for (int i = 0; i < BATCH && m_hasPending; ++i) {
+            feed(m_pending);
+            m_hasPending = m_reader.readNext(m_pending);
+        }
+        if (m_hasPending)
+            m_timer->start(0);
+        else
+            finish();
+        return;
+    }
+
+    // В темпе записи: отдаем всё, что "наступило", и ждем следующую запись
+    qint64 nowUs = static_cast<qint64>((m_clock.nsecsElapsed() / 1000) * m_speed);
+    while (m_hasPending && (m_pending.timestampUs - m_firstUs) <= nowUs) {
+        feed(m_pending);
+        m_hasPending = m_reader.readNext(m_pending);
+    }
+    if (!m_hasPending) {
+        finish();
+        return;
+    }
+    qint64 waitUs = static_cast<qint64>((m_pending.timestampUs - m_firstUs - nowUs) / m_speed);
+    m_timer->start(static_cast<int>(qMax<qint64>(0, waitUs / 1000)));
+}
+
+void ReplaySource::feed(const JournalRecord &rec)
+{
+    QModbusDataUnit unit(rec.regType, rec.startAddress, rec.values);
+    m_manager->injectData(rec.serverAddress, unit);
+}
+void ReplaySource::finish()
+{
+    m_running = false;
+    emit finished();
+}
+
 // =========================================================
 // CONTROLLER IMPLEMENTATION
 // =========================================================
@@ -335,6 +566,7 @@ Controller::Controller(QObject *parent)
     : QObject(parent)
 {
     m_manager = new Manager(this);
+    m_replay = new ReplaySource(m_manager, this);
     m_unitGateway = new EvoUnit::JsGateway(this);
 
     // JS Setup: пробрасываем объекты для доступа из скрипта
@@ -360,6 +592,7 @@ Controller::Controller(QObject *parent)
             &Manager::connectionStateChanged,
             this,
             &Controller::onManagerConnectionState);
+    connect(m_replay, &ReplaySource::finished, this, &Controller::replayFinished);
 }
 
 // --- Config Management ---
@@ -367,11 +600,13 @@ Controller::Controller(QObject *parent)
 void Controller::addModbusSource(const Source &s)
 {
     m_manager->addSource(s);
+    m_sourceUnits.insert(QString::fromStdString(s.id), s.defaultUnit);
 }
 
 void Controller::clearSources()
 {
     m_manager->clearSources();
+    m_sourceUnits.clear();
 }
 
 QVector<Source> Controller::getSources() const
@@ -437,7 +672,7 @@ void Controller::addSource(const QVariantMap &c)
     if (c.contains("unit")) {
         s.defaultUnit = static_cast<EvoUnit::MeasUnit>(c["unit"].toInt());
     }
-    m_manager->addSource(s);
+    addModbusSource(s);
 }
 
 // --- Scripting ---
@@ -497,11 +732,53 @@ void Controller::stop()
     m_manager->stopPolling();
 }
 
+// --- Record / Replay ---
+
+bool Controller::startRecording(const QString &filename)
+{
+    return m_manager->startRecording(filename);
+}
+
+void Controller::stopRecording()
+{
+    m_manager->stopRecording();
+}
+
+bool Controller::startReplay(const QString &filename, double speed)
+{
+    // Живой опрос и воспроизведение одновременно смешали бы данные
+    stop();
+    if (!m_replay->open(filename)) {
+        emit error("Replay open failed: " + filename);
+        return false;
+    }
+    m_replay->start(speed);
+    return true;
+}
+
+void Controller::stopReplay()
+{
+    m_replay->close();
+}
+
+int Controller::replayToEnd(const QString &filename)
+{
+    stop();
+    if (!m_replay->open(filename)) {
+        emit error("Replay open failed: " + filename);
+        return -1;
+    }
+    int n = m_replay->runToEnd();
+    m_replay->close();
+    return n;
+}
+
 QVariant Controller::val(const QString &id)
 {
     // Используется внутри JS для получения значения другого канала
-    if (m_channels.contains(id))
-        return m_channels[id].value;
+    auto it = m_channels.constFind(id);
+    if (it != m_channels.constEnd())
+        return it->value;
     return 0.0;
 }
 
@@ -510,10 +787,26 @@ void Controller::set(const QString &id, const QVariant &val, int unit)
     // Используется внутри JS для записи результата вычисления
     EvoUnit::MeasUnit u = (EvoUnit::MeasUnit) unit;
     // Если юнит не задан, пытаемся сохранить старый
-    if (u == EvoUnit::MeasUnit::Unknown && m_channels.contains(id)) {
-        u = m_channels[id].unit;
+    if (u == EvoUnit::MeasUnit::Unknown) {
+        auto it = m_channels.constFind(id);
+        if (it != m_channels.constEnd())
+            u = it->unit;
+    }
+    storeChannel(id, val, u);
+}
+
+void Controller::storeChannel(const QString &id, const QVariant &val, EvoUnit::MeasUnit unit)
+{
+    auto it = m_channels.find(id);
+    if (it == m_channels.end()) {
+        m_channels.insert(id, {val, unit, ++m_revision});
+        return;
+    }
+    if (it->value != val || it->unit != unit) {
+        it->value = val;
+        it->unit = unit;
+        it->revision = ++m_revision;
     }
-    m_channels[id] = {val, u};
 }
 
 void Controller::write(const QString &id, const QVariant &val)
@@ -542,13 +835,15 @@ void Controller::onManagerConnectionState(int state)
 
 void Controller::onRawDataReceived()
 {
-    QVariantMap raw = m_manager->getRawData();
+    QElapsedTimer evalClock;
+    evalClock.start();
+
+    const QVariantMap raw = m_manager->getRawData();
 
     // 1. Обновляем первичные каналы из rawData
-    for (auto i = raw.begin(); i != raw.end(); ++i) {
-        QString id = i.key();
+    for (auto i = raw.constBegin(); i != raw.constEnd(); ++i) {
         // Берем дефолтный юнит из конфига источника
-        m_channels[id] = {i.value(), m_manager->getSourceConfig(id).defaultUnit};
+        storeChannel(i.key(), i.value(), m_sourceUnits.value(i.key()));
     }
 
     // 2. Выполняем скрипт (расчет вторичных каналов)
@@ -560,6 +855,8 @@ void Controller::onRawDataReceived()
         }
     }
 
+    m_lastEvalUs = evalClock.nsecsElapsed() / 1000;
+
     // 3. Уведомляем UI
     emit channelsUpdated();
 }
@@ -659,65 +956,4 @@ bool Controller::loadConfig(const QString &filename)
     buildAndApplyScript();
     return true;
 }
-// =========================================================
-// BINDER IMPLEMENTATION
-// =========================================================
-
-Binder::Binder(Controller *c, QObject *p)
-    : QObject(p)
-    , m_controller(c)
-{
-    connect(m_controller, &Controller::channelsUpdated, this, &Binder::syncUI);
-}
-void Binder::bindLabel(QLabel *w, const std::string &id)
-{
-    if (w) {
-        m_bindings.append({w, id, 0, 1.0, nullptr});
-        syncUI();
-    }
-}
-void Binder::bindLCD(QLCDNumber *w, const std::string &id, double s)
-{
-    if (w) {
-        m_bindings.append({w, id, 1, s, nullptr});
-        syncUI();
-    }
-}
-void Binder::bindProgressBar(QProgressBar *w, const std::string &id)
-{
-    if (w) {
-        m_bindings.append({w, id, 2, 1.0, nullptr});
-        syncUI();
-    }
-}
-void Binder::bindCustom(const std::string &id, Callback cb)
-{
-    m_bindings.append({nullptr, id, 3, 1.0, cb});
-    syncUI();
-}
-
-void Binder::syncUI()
-{
-    auto ch = m_controller->getChannels();
-    for (const auto &b : qAsConst(m_bindings)) {
-        QString key = QString::fromStdString(b.id);
-        if (!ch.contains(key))
-            continue;
-        ChannelData d = ch[key];
-        double v = d.value.toDouble();
-        if (b.type == 3 && b.customCb) {
-            b.customCb(d);
-            continue;
-        }
-        if (b.widget.isNull())
-            continue;
-        if (b.type == 0)
-            static_cast<QLabel *>(b.widget.data())->setText(EvoUnit::format(v * b.scale, d.unit, 2));
-        else if (b.type == 1)
-            static_cast<QLCDNumber *>(b.widget.data())->display(v * b.scale);
-        else if (b.type == 2)
-            static_cast<QProgressBar *>(b.widget.data())->setValue((int) v);
-    }
-}
-
 } // namespace EvoModbus
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <QDataStream>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QHash>
 #include <QJSEngine>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -20,10 +23,6 @@
 // Подключаем EvoUnit
 #include "EvoUnit.h"
 
-#include <QLCDNumber>
-#include <QLabel>
-#include <QProgressBar>
-
 namespace EvoModbus {
 
 // =========================================================
@@ -38,6 +37,9 @@ struct ChannelData
 {
     QVariant value{};
     EvoUnit::MeasUnit unit{EvoUnit::MeasUnit::Unknown};
+    // Номер изменения: растет только когда меняется значение или единица.
+    // Потребители сравнивают его с последним увиденным, чтобы не перерисовывать лишнее.
+    quint64 revision{0};
 };
 
 struct Source
@@ -63,6 +65,55 @@ struct ComputedChannel
     EvoUnit::MeasUnit unit{EvoUnit::MeasUnit::Unknown};
 };
 
+// Одна запись журнала: декодированный ответ Modbus (блок регистров)
+struct JournalRecord
+{
+    qint64 timestampUs{0}; // от начала записи
+    int serverAddress{1};
+    QModbusDataUnit::RegisterType regType{QModbusDataUnit::HoldingRegisters};
+    int startAddress{0};
+    QVector<quint16> values{};
+};
+
+// =========================================================
+// 1a. JOURNAL (Бинарный журнал трафика)
+// =========================================================
+// Формат: заголовок [magic 'EVOJ', version, startEpochMs],
+// далее записи [tsUs:i64, server:u8, reg:u8, start:u16, count:u16, values:u16 x count].
+class JournalWriter
+{
+public:
+    bool open(const QString &filename);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    void append(int serverAddress, const QModbusDataUnit &unit);
+
+private:
+    QFile m_file{};
+    QDataStream m_stream{};
+    QElapsedTimer m_clock{};
+    // Сброс буфера на диск: при аварийном завершении теряется не больше этого
+    static constexpr qint64 FlushIntervalUs{500000};
+    static constexpr int FlushRecords{256};
+    qint64 m_lastFlushUs{0};
+    int m_unflushed{0};
+};
+
+class JournalReader
+{
+public:
+    bool open(const QString &filename);
+    void close();
+    bool readNext(JournalRecord &rec);
+    qint64 startEpochMs() const { return m_startEpochMs; }
+
+private:
+    QFile m_file{};
+    QDataStream m_stream{};
+    qint64 m_startEpochMs{0};
+};
+
 // =========================================================
 // 2. MANAGER (Hardware Driver)
 // =========================================================
@@ -87,6 +138,18 @@ public:
 
     QVariantMap getRawData() const { return m_rawData; }
 
+    // Журнал: запись каждого успешного ответа
+    bool startRecording(const QString &filename);
+    void stopRecording();
+    bool isRecording() const { return m_journal.isOpen(); }
+
+    // Подача блока регистров в декодер (используется воспроизведением журнала)
+    void injectData(int serverAddress, const QModbusDataUnit &unit);
+
+    // Статистика опроса
+    qint64 lastRoundTripUs() const { return m_lastRoundTripUs; }
+    quint64 skippedPolls() const { return m_skippedPolls; }
+
     // Writing
     bool writeValue(int serverAddress,
                     int startAddress,
@@ -123,8 +186,17 @@ private:
     QVector<RequestBlock> m_blocks{};
     QVariantMap m_rawData{};
     bool m_recalcNeeded{false};
+    JournalWriter m_journal{};
+
+    // Запросы текущего цикла опроса, еще не получившие ответ.
+    // Новый цикл не стартует, пока не завершен предыдущий (очередь не растет).
+    int m_pendingReplies{0};
+    quint64 m_skippedPolls{0};
+    QElapsedTimer m_pollClock{};
+    qint64 m_lastRoundTripUs{0};
 
     void recalculateBlocks();
+    bool decodeUnit(int serverAddress, const QModbusDataUnit &unit);
     QVariant parseValue(const Source &src, const QVector<quint16> &data);
 
     static int getRegisterCount(int type);
@@ -134,6 +206,48 @@ private:
     static QVector<quint16> decomposeFloat(float val, int order);
 };
 
+// =========================================================
+// 2a. REPLAY (Воспроизведение журнала через Manager)
+// =========================================================
+class ReplaySource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplaySource(Manager *manager, QObject *parent = nullptr);
+
+    bool open(const QString &filename);
+    void close();
+
+    // speed: 1.0 - исходный темп, 10.0 - в 10 раз быстрее, <= 0 - без пауз
+    void start(double speed = 1.0);
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // Синхронное воспроизведение всего журнала (регрессия/бенчмарк формул).
+    // Возвращает количество обработанных записей.
+    int runToEnd();
+
+signals:
+    void finished();
+
+private slots:
+    void onTick();
+
+private:
+    Manager *m_manager{nullptr};
+    JournalReader m_reader{};
+    QTimer *m_timer{nullptr};
+    QElapsedTimer m_clock{};
+    JournalRecord m_pending{};
+    bool m_hasPending{false};
+    bool m_running{false};
+    double m_speed{1.0};
+    qint64 m_firstUs{0};
+
+    void feed(const JournalRecord &rec);
+    void finish();
+};
+
 // =========================================================
 // 3. CONTROLLER (Logic Layer)
 // =========================================================
@@ -173,9 +287,23 @@ public:
     Q_INVOKABLE void start(int intervalMs = 1000);
     Q_INVOKABLE void stop();
 
+    // --- Record / Replay ---
+    bool startRecording(const QString &filename);
+    void stopRecording();
+    bool startReplay(const QString &filename, double speed = 1.0);
+    void stopReplay();
+    int replayToEnd(const QString &filename);
+
     // Accessors
     QJSEngine *engine() const { return const_cast<QJSEngine *>(&m_jsEngine); }
     QMap<QString, ChannelData> getChannels() const { return m_channels; }
+    // Доступ без копирования (только чтение, в потоке контроллера)
+    const QMap<QString, ChannelData> &channels() const { return m_channels; }
+    quint64 revision() const { return m_revision; }
+
+    // Статистика последнего цикла: RTT опроса и время расчета формул
+    qint64 lastRoundTripUs() const { return m_manager->lastRoundTripUs(); }
+    qint64 lastEvalUs() const { return m_lastEvalUs; }
 
     // --- JS API (IO Object) ---
     Q_INVOKABLE QVariant val(const QString &id);
@@ -186,6 +314,7 @@ signals:
     void channelsUpdated();
     void connectionStateChanged(bool connected);
     void error(QString msg);
+    void replayFinished();
 
 private slots:
     void onRawDataReceived();
@@ -193,12 +322,16 @@ private slots:
 
 private:
     Manager *m_manager{nullptr};
+    ReplaySource *m_replay{nullptr};
     QJSEngine m_jsEngine;
     QJSValue m_jsProcessFunction;
     EvoUnit::JsGateway *m_unitGateway{nullptr};
 
     // State
     QMap<QString, ChannelData> m_channels{};
+    quint64 m_revision{0};
+    QHash<QString, EvoUnit::MeasUnit> m_sourceUnits{}; // id -> единица источника
+    qint64 m_lastEvalUs{0};
     QVector<ComputedChannel> m_computedChannels{};
 
     // Serialization Helpers
@@ -206,38 +339,9 @@ private:
     Source sourceFromJson(const QJsonObject &obj) const;
     QJsonObject computedToJson(const ComputedChannel &ch) const;
     ComputedChannel computedFromJson(const QJsonObject &obj) const;
-};
-
-// =========================================================
-// 4. BINDER (Presentation Helper)
-// =========================================================
-class Binder : public QObject
-{
-    Q_OBJECT
-public:
-    explicit Binder(Controller *controller, QObject *parent = nullptr);
 
-    void bindLabel(QLabel *label, const std::string &channelId);
-    void bindLCD(QLCDNumber *lcd, const std::string &channelId, double scale = 1.0);
-    void bindProgressBar(QProgressBar *bar, const std::string &channelId);
-
-    using Callback = std::function<void(const ChannelData &)>;
-    void bindCustom(const std::string &channelId, Callback callback);
-
-private slots:
-    void syncUI();
-
-private:
-    Controller *m_controller{nullptr};
-    struct BindItem
-    {
-        QPointer<QWidget> widget;
-        std::string id{};
-        int type{0};
-        double scale{1.0};
-        Callback customCb{nullptr};
-    };
-    QVector<BindItem> m_bindings{};
+    // Запись канала с увеличением ревизии только при реальном изменении
+    void storeChannel(const QString &id, const QVariant &value, EvoUnit::MeasUnit unit);
 };
 
 } // namespace EvoModbus
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <ratio>
+#include <type_traits>
+#include "EvoUnitTable.h"
+
+// Типизированные физические величины для C++ кода.
+// Размерность [L, M, T, Theta, I] - параметр шаблона, масштаб к СИ - std::ratio.
+// Ошибки размерности (сложить Н и мм, передать МПа вместо Н) не компилируются,
+// а в release-сборке Quantity - это просто double (все методы constexpr inline).
+//
+// На границах (Modbus, JSON, GUI) значения переводятся из/в MeasUnit через
+// ту же constexpr-таблицу, что и EvoUnit::convert().
+
+namespace EvoUnit {
+
+// =========================================================================
+// Размерность
+// =========================================================================
+template<int L, int M, int T, int Th, int I>
+struct Dim
+{
+    static constexpr Dimensions value{L, M, T, Th, I};
+};
+
+template<class A, class B>
+struct DimMul;
+template<int L1, int M1, int T1, int Th1, int I1, int L2, int M2, int T2, int Th2, int I2>
+struct DimMul<Dim<L1, M1, T1, Th1, I1>, Dim<L2, M2, T2, Th2, I2>>
+{
+    using type = Dim<L1 + L2, M1 + M2, T1 + T2, Th1 + Th2, I1 + I2>;
+};
+
+template<class A, class B>
+struct DimDiv;
+template<int L1, int M1, int T1, int Th1, int I1, int L2, int M2, int T2, int Th2, int I2>
+struct DimDiv<Dim<L1, M1, T1, Th1, I1>, Dim<L2, M2, T2, Th2, I2>>
+{
+    using type = Dim<L1 - L2, M1 - M2, T1 - T2, Th1 - Th2, I1 - I2>;
+};
+
+namespace Dims {
+using Dimensionless = Dim<0, 0, 0, 0, 0>;
+using Length = Dim<1, 0, 0, 0, 0>;
+using Mass = Dim<0, 1, 0, 0, 0>;
+using Time = Dim<0, 0, 1, 0, 0>;
+using Temperature = Dim<0, 0, 0, 1, 0>;
+using Current = Dim<0, 0, 0, 0, 1>;
+using Area = Dim<2, 0, 0, 0, 0>;
+using Velocity = Dim<1, 0, -1, 0, 0>;
+using Force = Dim<1, 1, -2, 0, 0>;
+using Pressure = Dim<-1, 1, -2, 0, 0>;
+using ForceRate = Dim<1, 1, -3, 0, 0>;
+using PressureRate = Dim<-1, 1, -3, 0, 0>;
+} // namespace Dims
+
+template<class R>
+constexpr double ratioValue()
+{
+    return static_cast<double>(R::num) / static_cast<double>(R::den);
+}
+
+// =========================================================================
+// Quantity
+// =========================================================================
+template<class D, class Scale = std::ratio<1>>
+class Quantity
+{
+public:
+    using dim = D;
+    using scale = Scale;
+
+    constexpr Quantity() = default;
+    constexpr explicit Quantity(double v)
+        : m_value{v}
+    {}
+
+    // Неявный перевод между масштабами одной размерности (кгс -> Н, мм -> м)
+    template<class S2>
+    constexpr Quantity(const Quantity<D, S2> &o)
+        : m_value{o.value() * ratioValue<std::ratio_divide<S2, Scale>>()}
+    {}
+
+    constexpr double value() const { return m_value; }
+    // Значение в базовых единицах СИ
+    constexpr double si() const { return m_value * ratioValue<Scale>(); }
+
+    constexpr Quantity operator-() const { return Quantity(-m_value); }
+    constexpr Quantity &operator+=(const Quantity &o)
+    {
+        m_value += o.m_value;
+        return *this;
+    }
+    constexpr Quantity &operator-=(const Quantity &o)
+    {
+        m_value -= o.m_value;
+        return *this;
+    }
+    constexpr Quantity &operator*=(double k)
+    {
+        m_value *= k;
+        return *this;
+    }
+    constexpr Quantity &operator/=(double k)
+    {
+        m_value /= k;
+        return *this;
+    }
+
+private:
+    double m_value{0.0};
+};
+
+// --- Арифметика (только одинаковые размерность и масштаб) ---
+template<class D, class S>
+constexpr Quantity<D, S> operator+(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return Quantity<D, S>(a.value() + b.value());
+}
+template<class D, class S>
+constexpr Quantity<D, S> operator-(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return Quantity<D, S>(a.value() - b.value());
+}
+template<class D, class S>
+constexpr Quantity<D, S> operator*(Quantity<D, S> a, double k)
+{
+    return Quantity<D, S>(a.value() * k);
+}
+template<class D, class S>
+constexpr Quantity<D, S> operator*(double k, Quantity<D, S> a)
+{
+    return Quantity<D, S>(a.value() * k);
+}
+template<class D, class S>
+constexpr Quantity<D, S> operator/(Quantity<D, S> a, double k)
+{
+    return Quantity<D, S>(a.value() / k);
+}
+
+// Произведение и частное величин дают новую размерность и масштаб
+template<class D1, class S1, class D2, class S2>
+constexpr auto operator*(Quantity<D1, S1> a, Quantity<D2, S2> b)
+{
+    return Quantity<typename DimMul<D1, D2>::type, std::ratio_multiply<S1, S2>>(a.value() * b.value());
+}
+template<class D1, class S1, class D2, class S2>
+constexpr auto operator/(Quantity<D1, S1> a, Quantity<D2, S2> b)
+{
+    return Quantity<typename DimDiv<D1, D2>::type, std::ratio_divide<S1, S2>>(a.value() / b.value());
+}
+
+// --- Сравнение ---
+template<class D, class S>
+constexpr bool operator<(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() < b.value();
+}
+template<class D, class S>
+constexpr bool operator>(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() > b.value();
+}
+template<class D, class S>
+constexpr bool operator<=(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() <= b.value();
+}
+template<class D, class S>
+constexpr bool operator>=(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() >= b.value();
+}
+template<class D, class S>
+constexpr bool operator==(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() == b.value();
+}
+template<class D, class S>
+constexpr bool operator!=(Quantity<D, S> a, Quantity<D, S> b)
+{
+    return a.value() != b.value();
+}
+
+template<class D, class S>
+inline Quantity<D, S> abs(Quantity<D, S> q)
+{
+    return Quantity<D, S>(std::abs(q.value()));
+}
+
+// =========================================================================
+// Граница с MeasUnit
+// =========================================================================
+// Единица известна при компиляции: несовпадение размерности - ошибка компиляции.
+template<MeasUnit U, class Q>
+constexpr double toUnit(Q q)
+{
+    static_assert(Table::entry(U).def.dimensions() == Q::dim::value,
+                  "EvoUnit: quantity dimension does not match target unit");
+    constexpr UnitDef d = Table::entry(U).def;
+    return q.si() / d.factor() - d.offset();
+}
+
+template<class Q, MeasUnit U>
+constexpr Q fromUnit(double v)
+{
+    static_assert(Table::entry(U).def.dimensions() == Q::dim::value,
+                  "EvoUnit: unit dimension does not match quantity");
+    constexpr UnitDef d = Table::entry(U).def;
+    return Q((v + d.offset()) * d.factor() / ratioValue<typename Q::scale>());
+}
+
+// Единица известна только во время работы (конфиг, Modbus):
+// при несовпадении размерности результат - NaN, как у convert().
+template<class Q>
+constexpr double toUnit(Q q, MeasUnit u)
+{
+    const UnitDef &d = Table::entry(u).def;
+    if (d.dimensions() != Q::dim::value)
+        return std::numeric_limits<double>::quiet_NaN();
+    return q.si() / d.factor() - d.offset();
+}
+
+template<class Q>
+constexpr Q fromUnit(double v, MeasUnit u)
+{
+    const UnitDef &d = Table::entry(u).def;
+    if (d.dimensions() != Q::dim::value)
+        return Q(std::numeric_limits<double>::quiet_NaN());
+    return Q((v + d.offset()) * d.factor() / ratioValue<typename Q::scale>());
+}
+
+// =========================================================================
+// Готовые типы
+// =========================================================================
+using StandardGravity = std::ratio<980665, 100000>; // 9.80665 м/с²
+
+using Ratio = Quantity<Dims::Dimensionless>;
+using Percent = Quantity<Dims::Dimensionless, std::centi>;
+
+using Meters = Quantity<Dims::Length>;
+using Millimeters = Quantity<Dims::Length, std::milli>;
+using Micrometers = Quantity<Dims::Length, std::micro>;
+
+using SquareMillimeters = Quantity<Dims::Area, std::micro>;
+
+using Seconds = Quantity<Dims::Time>;
+using Milliseconds = Quantity<Dims::Time, std::milli>;
+
+using Kilograms = Quantity<Dims::Mass>;
+
+using Newtons = Quantity<Dims::Force>;
+using KiloNewtons = Quantity<Dims::Force, std::kilo>;
+using KilogramsForce = Quantity<Dims::Force, StandardGravity>;
+
+using Pascals = Quantity<Dims::Pressure>;
+using MegaPascals = Quantity<Dims::Pressure, std::mega>;
+using GigaPascals = Quantity<Dims::Pressure, std::giga>;
+
+using MillimetersPerMinute = Quantity<Dims::Velocity, std::ratio<1, 60000>>;
+using MegaPascalsPerSecond = Quantity<Dims::PressureRate, std::mega>;
+
+// Нулевая стоимость: величина хранится и передается как double
+static_assert(sizeof(Newtons) == sizeof(double), "Quantity must be a plain double");
+static_assert(std::is_trivially_copyable<MegaPascals>::value, "Quantity must be trivially copyable");
+
+// Согласованность с таблицей единиц
+static_assert(Newtons(KilogramsForce(1.0)).value() == 9.80665, "kgf scale");
+static_assert(std::is_same<decltype(Newtons() / SquareMillimeters()), MegaPascals>::value,
+              "N / mm2 must be MPa");
+
+} // namespace EvoUnit
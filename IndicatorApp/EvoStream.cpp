@@ -0,0 +1,156 @@
+#include "EvoStream.h"
+#include <QtNumeric>
+#include <cstdio>
+
+namespace EvoModbus {
+
+static const quint32 STREAM_MAGIC{0x45564F53}; // 'EVOS'
+static const quint16 STREAM_VERSION{1};
+
+Streamer::Streamer(Controller *c, QObject *p)
+    : QObject(p)
+    , m_controller(c)
+{
+    m_statsTimer = new QTimer(this);
+    m_flushTimer = new QTimer(this);
+    connect(m_statsTimer, &QTimer::timeout, this, &Streamer::onStatsTimer);
+    // Сброс буфера раз в секунду: хвост не теряется, а запись не идет построчно
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() {
+        if (m_out.isOpen())
+            m_out.flush();
+    });
+    connect(m_controller, &Controller::channelsUpdated, this, &Streamer::onChannelsUpdated);
+}
+
+Streamer::~Streamer()
+{
+    close();
+}
+
+bool Streamer::open(const QString &path, Format format)
+{
+    close();
+    m_format = format;
+    bool ok = false;
+    if (path == "-") {
+        ok = m_out.open(stdout, QIODevice::WriteOnly);
+    } else {
+        m_out.setFileName(path);
+        ok = m_out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!ok)
+        return false;
+
+    // Набор колонок фиксируется при открытии: источники + вычисляемые каналы
+    m_columns.clear();
+    for (const auto &s : m_controller->getSources())
+        m_columns.append(QString::fromStdString(s.id));
+    for (const auto &ch : m_controller->getComputedChannels())
+        m_columns.append(QString::fromStdString(ch.id));
+
+    if (m_format == Format::Binary)
+        m_stream.setDevice(&m_out);
+    writeHeader();
+
+    m_uptime.start();
+    m_intervalClock.start();
+    m_interval = {};
+    m_totalRows = 0;
+    m_flushTimer->start(1000);
+    return true;
+}
+
+void Streamer::close()
+{
+    m_flushTimer->stop();
+    if (!m_out.isOpen())
+        return;
+    m_stream.setDevice(nullptr);
+    m_out.flush();
+    m_out.close();
+}
+
+void Streamer::setStatsInterval(int seconds)
+{
+    if (seconds > 0)
+        m_statsTimer->start(seconds * 1000);
+    else
+        m_statsTimer->stop();
+}
+
+void Streamer::writeHeader()
+{
+    if (m_format == Format::Binary) {
+        m_stream << STREAM_MAGIC << STREAM_VERSION << static_cast<quint16>(m_columns.size());
+        for (const auto &c : qAsConst(m_columns))
+            m_stream << c.toUtf8();
+        return;
+    }
+    QByteArray hdr = "time_ms";
+    for (const auto &c : qAsConst(m_columns))
+        hdr += ',' + c.toUtf8();
+    hdr += '\n';
+    m_out.write(hdr);
+}
+
+void Streamer::onChannelsUpdated()
+{
+    if (!m_out.isOpen())
+        return;
+
+    const qint64 t = m_uptime.elapsed();
+    const auto &channels = m_controller->channels();
+    qint64 written = 0;
+
+    if (m_format == Format::Binary) {
+        m_stream << t;
+        for (const auto &c : qAsConst(m_columns)) {
+            // Пропуск - NaN, а не 0: иначе его не отличить от настоящего нуля
+            auto it = channels.constFind(c);
+            m_stream << (it != channels.constEnd() ? it->value.toDouble() : qQNaN());
+        }
+        written = static_cast<qint64>(sizeof(qint64) + sizeof(double) * m_columns.size());
+    } else {
+        // Буфер строки переиспользуется, чтобы не аллоцировать на каждом цикле
+        m_line.clear();
+        m_line += QByteArray::number(t);
+        for (const auto &c : qAsConst(m_columns)) {
+            m_line += ',';
+            auto it = channels.constFind(c);
+            if (it != channels.constEnd())
+                m_line += QByteArray::number(it->value.toDouble(), 'g', 10);
+        }
+        m_line += '\n';
+        written = m_out.write(m_line);
+    }
+
+    ++m_totalRows;
+    ++m_interval.rows;
+    m_interval.bytes += static_cast<quint64>(qMax<qint64>(0, written));
+
+    const qint64 rtt = m_controller->lastRoundTripUs();
+    const qint64 eval = m_controller->lastEvalUs();
+    m_interval.rttSumUs += rtt;
+    m_interval.rttMaxUs = qMax(m_interval.rttMaxUs, rtt);
+    m_interval.evalSumUs += eval;
+    m_interval.evalMaxUs = qMax(m_interval.evalMaxUs, eval);
+}
+
+void Streamer::onStatsTimer()
+{
+    const double sec = qMax<qint64>(1, m_intervalClock.restart()) / 1000.0;
+    const quint64 n = qMax<quint64>(1, m_interval.rows);
+    emit statsReport(QString("[stats] up %1 s | rows %2 (%3/s) | %4 KB/s | rtt avg %5 us max "
+                             "%6 us | eval avg %7 us max %8 us")
+                         .arg(m_uptime.elapsed() / 1000)
+                         .arg(m_totalRows)
+                         .arg(m_interval.rows / sec, 0, 'f', 1)
+                         .arg(m_interval.bytes / 1024.0 / sec, 0, 'f', 1)
+                         .arg(m_interval.rttSumUs / static_cast<qint64>(n))
+                         .arg(m_interval.rttMaxUs)
+                         .arg(m_interval.evalSumUs / static_cast<qint64>(n))
+                         .arg(m_interval.evalMaxUs));
+    m_interval = {};
+}
+
+} // namespace EvoModbus
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include "EvoModbus.h"
+
+namespace EvoModbus {
+
+// =========================================================
+// STREAMER (Потоковый вывод каналов в файл / stdout)
+// =========================================================
+// Каждое обновление контроллера пишется одной строкой сразу в устройство вывода,
+// в памяти ничего не накапливается (подходит для многодневной работы).
+//
+// CSV:    time_ms,<id1>,<id2>,...
+// Binary: заголовок [magic 'EVOS', version, columns, names...],
+//         строки [time_ms:i64, value:f64 x columns].
+// Канала нет в обновлении: в CSV - пустое поле, в Binary - NaN.
+class Streamer : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Format { Csv = 0, Binary };
+
+    explicit Streamer(Controller *controller, QObject *parent = nullptr);
+    ~Streamer();
+
+    // path == "-" - стандартный вывод
+    bool open(const QString &path, Format format);
+    void close();
+
+    // Период печати статистики (сек), 0 - отключено
+    void setStatsInterval(int seconds);
+
+signals:
+    void statsReport(QString line);
+
+private slots:
+    void onChannelsUpdated();
+    void onStatsTimer();
+
+private:
+    Controller *m_controller{nullptr};
+    QFile m_out{};
+    QDataStream m_stream{};
+    Format m_format{Format::Csv};
+    QStringList m_columns{};
+    QByteArray m_line{};
+    QElapsedTimer m_uptime{};
+    QTimer *m_statsTimer{nullptr};
+    QTimer *m_flushTimer{nullptr};
+
+    // Статистика за текущий интервал (сбрасывается при печати)
+    struct IntervalStats
+    {
+        quint64 rows{0};
+        quint64 bytes{0};
+        qint64 rttSumUs{0};
+        qint64 rttMaxUs{0};
+        qint64 evalSumUs{0};
+        qint64 evalMaxUs{0};
+    };
+    IntervalStats m_interval{};
+    quint64 m_totalRows{0};
+    QElapsedTimer m_intervalClock{};
+
+    void writeHeader();
+};
+
+} // namespace EvoModbus
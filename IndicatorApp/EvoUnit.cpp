@@ -1,9 +1,21 @@
 #include "EvoUnit.h"
+#include "EvoUnitTable.h"
 #include <QLocale>
-#include <QMap>
-#include <QRegularExpression>
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <limits>
-#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define EVOUNIT_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EVOUNIT_SSE2 1
+#endif
 
 namespace EvoUnit {
 
@@ -12,424 +24,34 @@ class TranslationContext
     Q_DECLARE_TR_FUNCTIONS(TranslationContext)
 };
 
-struct UnitEntry
-{
-    UnitDef def{};
-    UnitCategory category{UnitCategory::Unknown};
-    const char *nameKey{nullptr};
-    const char *symKey{nullptr};
-};
-
-static QMap<MeasUnit, UnitEntry> registry;
+using Table::entry;
 
 // =========================================================================
-// Реализация UnitDef
+// МАТРИЦА ПРЕОБРАЗОВАНИЙ
 // =========================================================================
-UnitDef::UnitDef(double factor, double offset, Dimensions dim)
-    : m_factor{factor}
-    , m_offset{offset}
-    , m_dim{dim}
-{}
+// Все пары from x to считаются на этапе компиляции и лежат в .rodata:
+// convert() - два индекса и одно умножение-сложение, без блокировок и поиска.
+using AffineMatrix = std::array<std::array<Table::Affine, Table::Count>, Table::Count>;
 
-UnitDef UnitDef::operator*(const UnitDef &other) const
+static constexpr AffineMatrix makeAffineMatrix()
 {
-    return UnitDef(m_factor * other.m_factor,
-                   0.0,
-                   {static_cast<int8_t>(m_dim.L + other.m_dim.L),
-                    static_cast<int8_t>(m_dim.M + other.m_dim.M),
-                    static_cast<int8_t>(m_dim.T + other.m_dim.T),
-                    static_cast<int8_t>(m_dim.Theta + other.m_dim.Theta),
-                    static_cast<int8_t>(m_dim.I + other.m_dim.I)});
+    AffineMatrix mx{};
+    for (int f = 0; f < Table::Count; ++f)
+        for (int t = 0; t < Table::Count; ++t)
+            mx[f][t] = Table::affine(static_cast<MeasUnit>(f), static_cast<MeasUnit>(t));
+    return mx;
 }
 
-UnitDef UnitDef::operator/(const UnitDef &other) const
-{
-    return UnitDef(m_factor / other.m_factor,
-                   0.0,
-                   {static_cast<int8_t>(m_dim.L - other.m_dim.L),
-                    static_cast<int8_t>(m_dim.M - other.m_dim.M),
-                    static_cast<int8_t>(m_dim.T - other.m_dim.T),
-                    static_cast<int8_t>(m_dim.Theta - other.m_dim.Theta),
-                    static_cast<int8_t>(m_dim.I - other.m_dim.I)});
-}
+static constexpr AffineMatrix affineMatrix = makeAffineMatrix();
 
-UnitDef UnitDef::operator*(double scale) const
+static inline const Table::Affine &affineOf(MeasUnit from, MeasUnit to)
 {
-    return UnitDef(m_factor * scale, m_offset, m_dim);
+    return affineMatrix[Table::indexOf(from)][Table::indexOf(to)];
 }
 
-// =========================================================================
-// ИНИЦИАЛИЗАЦИЯ РЕЕСТРА
-// =========================================================================
-static void initRegistry()
-{
-    if (!registry.isEmpty())
-        return;
-
-    // --- БАЗОВЫЕ ЕДИНИЦЫ (СИ) ---
-    UnitDef m{1.0, 0.0, {1, 0, 0, 0, 0}};  // Метр
-    UnitDef kg{1.0, 0.0, {0, 1, 0, 0, 0}}; // Килограмм
-    UnitDef s{1.0, 0.0, {0, 0, 1, 0, 0}};  // Секунда
-    UnitDef K{1.0, 0.0, {0, 0, 0, 1, 0}};  // Кельвин
-    UnitDef A{1.0, 0.0, {0, 0, 0, 0, 1}};  // Ампер
-
-    // --- БЕЗРАЗМЕРНАЯ ---
-    UnitDef dimless{1.0, 0.0, {0, 0, 0, 0, 0}};
-
-    // --- 1. ДЛИНА ---
-    UnitDef mm = m * 0.001;
-    UnitDef cm = m * 0.01;
-    UnitDef dm = m * 0.1;
-    UnitDef km = m * 1000.0;
-    UnitDef um = m * 1.0e-6;
-
-    UnitDef inch = m * 0.0254;
-    UnitDef ft = inch * 12.0;
-    UnitDef yd = ft * 3.0;
-    UnitDef mil = inch * 0.001; // мил
-
-    // Площади (для расчета давления)
-    UnitDef mm2 = mm * mm;
-    UnitDef cm2 = cm * cm;
-    UnitDef inch2 = inch * inch;
-
-    // --- 2. ВРЕМЯ ---
-    UnitDef ms = s * 0.001;
-    UnitDef us = s * 1.0e-6;
-    UnitDef min = s * 60.0;
-    UnitDef hr = min * 60.0;
-    UnitDef day = hr * 24.0;
-
-    // --- 3. МАССА ---
-    UnitDef g_mass = kg * 0.001;
-    UnitDef lb = kg * 0.45359237;
-    UnitDef tonne = kg * 1000.0;
-
-    // --- 4. ТЕМПЕРАТУРА ---
-    UnitDef degC{1.0, 273.15, {0, 0, 0, 1, 0}};
-    UnitDef degF{5.0 / 9.0, 459.67, {0, 0, 0, 1, 0}};
-
-    // --- 5. СИЛА ТОКА ---
-    UnitDef mA = A * 0.001;
-    UnitDef uA = A * 1.0e-6;
-    UnitDef kA = A * 1000.0;
-
-    // --- 6. СИЛА (F = ma) ---
-    UnitDef N = kg * m / (s * s);
-    UnitDef kN = N * 1000.0;
-    UnitDef MN = N * 1.0e6;
-
-    const double gravity{9.80665};
-    UnitDef kgf = N * gravity;
-    UnitDef gf = kgf * 0.001;
-    UnitDef tf = kgf * 1000.0;
-
-    UnitDef lbf = lb * gravity * m / (s * s);
-    UnitDef kip = lbf * 1000.0;
-
-    // --- 7. ДАВЛЕНИЕ (P = F / S) ---
-    UnitDef Pa = N / (m * m);
-    UnitDef kPa = Pa * 1000.0;
-    UnitDef MPa = Pa * 1.0e6;
-    UnitDef GPa = Pa * 1.0e9;
-
-    UnitDef bar = Pa * 1.0e5;
-    UnitDef mbar = bar * 0.001;
-
-    UnitDef psi = lbf / inch2;
-    UnitDef ksi = psi * 1000.0;
-    UnitDef kgf_cm2 = kgf / cm2;
-    UnitDef atm = Pa * 101325.0;
-
-    // --- 8. НАПРЯЖЕНИЕ ---
-    UnitDef V = (N * m / s) / A;
-    UnitDef mV = V * 0.001;
-    UnitDef uV = V * 1.0e-6;
-    UnitDef kV = V * 1000.0;
-
-    // --- Лямбда для добавления ---
-    auto add = [](MeasUnit u, UnitDef d, UnitCategory cat, const char *sym, const char *name) {
-        registry.insert(u, {d, cat, name, sym});
-    };
-
-    // =========================================================================
-    // ЗАПОЛНЕНИЕ РЕЕСТРА
-    // =========================================================================
-
-    // БЕЗРАЗМЕРНАЯ
-    add(MeasUnit::Dimensionless,
-        dimless,
-        UnitCategory::Dimensionless,
-        QT_TR_NOOP("-"),
-        QT_TR_NOOP("Безразмерная"));
-
-    // ДЛИНА
-    add(MeasUnit::Millimeter, mm, UnitCategory::Length, QT_TR_NOOP("мм"), QT_TR_NOOP("Миллиметр"));
-    add(MeasUnit::Centimeter, cm, UnitCategory::Length, QT_TR_NOOP("см"), QT_TR_NOOP("Сантиметр"));
-    add(MeasUnit::Decimeter, dm, UnitCategory::Length, QT_TR_NOOP("дм"), QT_TR_NOOP("Дециметр"));
-    add(MeasUnit::Meter, m, UnitCategory::Length, QT_TR_NOOP("м"), QT_TR_NOOP("Метр"));
-    add(MeasUnit::Kilometer, km, UnitCategory::Length, QT_TR_NOOP("км"), QT_TR_NOOP("Километр"));
-    add(MeasUnit::Micrometer, um, UnitCategory::Length, QT_TR_NOOP("мкм"), QT_TR_NOOP("Микрометр"));
-    add(MeasUnit::Inch, inch, UnitCategory::Length, QT_TR_NOOP("дюйм"), QT_TR_NOOP("Дюйм"));
-    add(MeasUnit::Foot, ft, UnitCategory::Length, QT_TR_NOOP("фт"), QT_TR_NOOP("Фут"));
-    add(MeasUnit::Yard, yd, UnitCategory::Length, QT_TR_NOOP("ярд"), QT_TR_NOOP("Ярд"));
-    add(MeasUnit::Mil, mil, UnitCategory::Length, QT_TR_NOOP("мил"), QT_TR_NOOP("Мил"));
-
-    // ВРЕМЯ
-    add(MeasUnit::Second, s, UnitCategory::Time, QT_TR_NOOP("с"), QT_TR_NOOP("Секунда"));
-    add(MeasUnit::Minute, min, UnitCategory::Time, QT_TR_NOOP("мин"), QT_TR_NOOP("Минута"));
-    add(MeasUnit::Hour, hr, UnitCategory::Time, QT_TR_NOOP("ч"), QT_TR_NOOP("Час"));
-    add(MeasUnit::Day, day, UnitCategory::Time, QT_TR_NOOP("дн"), QT_TR_NOOP("День"));
-    add(MeasUnit::Millisecond, ms, UnitCategory::Time, QT_TR_NOOP("мс"), QT_TR_NOOP("Миллисекунда"));
-    add(MeasUnit::Microsecond, us, UnitCategory::Time, QT_TR_NOOP("мкс"), QT_TR_NOOP("Микросекунда"));
-
-    // ТЕМПЕРАТУРА
-    add(MeasUnit::Kelvin, K, UnitCategory::Temperature, QT_TR_NOOP("K"), QT_TR_NOOP("Кельвин"));
-    add(MeasUnit::Celsius,
-        degC,
-        UnitCategory::Temperature,
-        QT_TR_NOOP("°C"),
-        QT_TR_NOOP("Градус Цельсия"));
-    add(MeasUnit::Fahrenheit,
-        degF,
-        UnitCategory::Temperature,
-        QT_TR_NOOP("°F"),
-        QT_TR_NOOP("Градус Фаренгейта"));
-
-    // МАССА
-    add(MeasUnit::Gram, g_mass, UnitCategory::Mass, QT_TR_NOOP("г"), QT_TR_NOOP("Грамм"));
-    add(MeasUnit::Kilogram, kg, UnitCategory::Mass, QT_TR_NOOP("кг"), QT_TR_NOOP("Килограмм"));
-    add(MeasUnit::Pound, lb, UnitCategory::Mass, QT_TR_NOOP("lb"), QT_TR_NOOP("Фунт"));
-    add(MeasUnit::Tonne, tonne, UnitCategory::Mass, QT_TR_NOOP("т"), QT_TR_NOOP("Тонна"));
-
-    // СИЛА
-    add(MeasUnit::Newton, N, UnitCategory::Force, QT_TR_NOOP("Н"), QT_TR_NOOP("Ньютон"));
-    add(MeasUnit::KiloNewton, kN, UnitCategory::Force, QT_TR_NOOP("кН"), QT_TR_NOOP("Килоньютон"));
-    add(MeasUnit::MegaNewton, MN, UnitCategory::Force, QT_TR_NOOP("МН"), QT_TR_NOOP("Меганьютон"));
-    add(MeasUnit::GramForce, gf, UnitCategory::Force, QT_TR_NOOP("гс"), QT_TR_NOOP("Грамм-сила"));
-    add(MeasUnit::KilogramForce,
-        kgf,
-        UnitCategory::Force,
-        QT_TR_NOOP("кгс"),
-        QT_TR_NOOP("Килограмм-сила"));
-    add(MeasUnit::TonForce, tf, UnitCategory::Force, QT_TR_NOOP("тс"), QT_TR_NOOP("Тонна-сила"));
-    add(MeasUnit::PoundForce,
-        lbf,
-        UnitCategory::Force,
-        QT_TR_NOOP("фунт-сила"),
-        QT_TR_NOOP("Фунт-сила"));
-    add(MeasUnit::Kip, kip, UnitCategory::Force, QT_TR_NOOP("kip"), QT_TR_NOOP("Килофунт-сила"));
-
-    // ДАВЛЕНИЕ
-    add(MeasUnit::Pascal, Pa, UnitCategory::Pressure, QT_TR_NOOP("Па"), QT_TR_NOOP("Паскаль"));
-    add(MeasUnit::KiloPascal,
-        kPa,
-        UnitCategory::Pressure,
-        QT_TR_NOOP("кПа"),
-        QT_TR_NOOP("Килопаскаль"));
-    add(MeasUnit::MegaPascal,
-        MPa,
-        UnitCategory::Pressure,
-        QT_TR_NOOP("МПа"),
-        QT_TR_NOOP("Мегапаскаль"));
-    add(MeasUnit::GigaPascal,
-        GPa,
-        UnitCategory::Pressure,
-        QT_TR_NOOP("ГПа"),
-        QT_TR_NOOP("Гигапаскаль"));
-    add(MeasUnit::Bar, bar, UnitCategory::Pressure, QT_TR_NOOP("бар"), QT_TR_NOOP("Бар"));
-    add(MeasUnit::MilliBar, mbar, UnitCategory::Pressure, QT_TR_NOOP("мбар"), QT_TR_NOOP("Миллибар"));
-    add(MeasUnit::PSI, psi, UnitCategory::Pressure, QT_TR_NOOP("psi"), QT_TR_NOOP("PSI"));
-    add(MeasUnit::KSI, ksi, UnitCategory::Pressure, QT_TR_NOOP("ksi"), QT_TR_NOOP("KSI"));
-    add(MeasUnit::Kgf_per_CM2,
-        kgf_cm2,
-        UnitCategory::Pressure,
-        QT_TR_NOOP("кгс/см²"),
-        QT_TR_NOOP("Тех. атмосфера"));
-    add(MeasUnit::Atmosphere,
-        atm,
-        UnitCategory::Pressure,
-        QT_TR_NOOP("атм"),
-        QT_TR_NOOP("Атмосфера"));
-
-    // НАПРЯЖЕНИЕ (VOLTAGE)
-    add(MeasUnit::Microvolt, uV, UnitCategory::Voltage, QT_TR_NOOP("мкВ"), QT_TR_NOOP("Микровольт"));
-    add(MeasUnit::Millivolt, mV, UnitCategory::Voltage, QT_TR_NOOP("мВ"), QT_TR_NOOP("Милливольт"));
-    add(MeasUnit::Volt, V, UnitCategory::Voltage, QT_TR_NOOP("В"), QT_TR_NOOP("Вольт"));
-    add(MeasUnit::Kilovolt, kV, UnitCategory::Voltage, QT_TR_NOOP("кВ"), QT_TR_NOOP("Киловольт"));
-
-    // СИЛА ТОКА (CURRENT)
-    add(MeasUnit::Microampere,
-        uA,
-        UnitCategory::Current,
-        QT_TR_NOOP("мкА"),
-        QT_TR_NOOP("Микроампер"));
-    add(MeasUnit::Milliampere, mA, UnitCategory::Current, QT_TR_NOOP("мА"), QT_TR_NOOP("Миллиампер"));
-    add(MeasUnit::Ampere, A, UnitCategory::Current, QT_TR_NOOP("А"), QT_TR_NOOP("Ампер"));
-    add(MeasUnit::Kiloampere, kA, UnitCategory::Current, QT_TR_NOOP("кА"), QT_TR_NOOP("Килоампер"));
-
-    // --- СКОРОСТЬ (VELOCITY) ---
-    // В Секунду
-    add(MeasUnit::MM_per_Sec,
-        mm / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("мм/с"),
-        QT_TR_NOOP("мм в секунду"));
-    add(MeasUnit::CM_per_Sec,
-        cm / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("см/с"),
-        QT_TR_NOOP("см в секунду"));
-    add(MeasUnit::DM_per_Sec,
-        dm / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("дм/с"),
-        QT_TR_NOOP("дм в секунду"));
-    add(MeasUnit::Meter_per_Sec,
-        m / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("м/с"),
-        QT_TR_NOOP("м в секунду"));
-    add(MeasUnit::Inch_per_Sec,
-        inch / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("дюйм/с"),
-        QT_TR_NOOP("дюйм в секунду"));
-    add(MeasUnit::Foot_per_Sec,
-        ft / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("фут/с"),
-        QT_TR_NOOP("фут в секунду"));
-    add(MeasUnit::Mil_per_Sec,
-        mil / s,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("мил/с"),
-        QT_TR_NOOP("мил в секунду"));
-
-    // В Минуту
-    add(MeasUnit::MM_per_Min,
-        mm / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("мм/мин"),
-        QT_TR_NOOP("мм в минуту"));
-    add(MeasUnit::CM_per_Min,
-        cm / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("см/мин"),
-        QT_TR_NOOP("см в минуту"));
-    add(MeasUnit::DM_per_Min,
-        dm / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("дм/мин"),
-        QT_TR_NOOP("дм в минуту"));
-    add(MeasUnit::Meter_per_Min,
-        m / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("м/мин"),
-        QT_TR_NOOP("м в минуту"));
-    add(MeasUnit::Inch_per_Min,
-        inch / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("дюйм/мин"),
-        QT_TR_NOOP("дюйм в минуту"));
-    add(MeasUnit::Foot_per_Min,
-        ft / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("фут/мин"),
-        QT_TR_NOOP("фут в минуту"));
-    add(MeasUnit::Mil_per_Min,
-        mil / min,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("мил/мин"),
-        QT_TR_NOOP("мил в минуту"));
-
-    add(MeasUnit::KM_per_Hour,
-        km / hr,
-        UnitCategory::Velocity,
-        QT_TR_NOOP("км/ч"),
-        QT_TR_NOOP("км в час"));
-
-    // --- СКОРОСТЬ РОСТА ДАВЛЕНИЯ (PRESSURE RATE) ---
-    // Па/с, кПа/с, МПа/с, ГПа/с
-    add(MeasUnit::Pascal_per_Sec,
-        Pa / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("Па/с"),
-        QT_TR_NOOP("Паскаль в секунду"));
-    add(MeasUnit::KiloPascal_per_Sec,
-        kPa / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("кПа/с"),
-        QT_TR_NOOP("Килопаскаль в секунду"));
-    add(MeasUnit::MegaPascal_per_Sec,
-        MPa / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("МПа/с"),
-        QT_TR_NOOP("Мегапаскаль в секунду"));
-    add(MeasUnit::GigaPascal_per_Sec,
-        GPa / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("ГПа/с"),
-        QT_TR_NOOP("Гигапаскаль в секунду"));
-
-    // Н/мм2/с, кгс/см2/с
-    add(MeasUnit::Newton_per_MM2_per_Sec,
-        N / mm2 / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("Н/мм²/с"),
-        QT_TR_NOOP("Н/мм² в секунду"));
-    add(MeasUnit::Kgf_per_CM2_per_Sec,
-        kgf / cm2 / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("кгс/см²/с"),
-        QT_TR_NOOP("кгс/см² в секунду"));
-
-    // psi/c, ksi/c
-    add(MeasUnit::PSI_per_Sec,
-        psi / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("psi/с"),
-        QT_TR_NOOP("psi в секунду"));
-    add(MeasUnit::KSI_per_Sec,
-        ksi / s,
-        UnitCategory::PressureRate,
-        QT_TR_NOOP("ksi/с"),
-        QT_TR_NOOP("ksi в секунду"));
-
-    // --- СКОРОСТЬ РОСТА СИЛЫ (FORCE RATE) ---
-    // кН/с, Н/с, кгс/с, фунт-сила/с
-    add(MeasUnit::Newton_per_Sec,
-        N / s,
-        UnitCategory::ForceRate,
-        QT_TR_NOOP("Н/с"),
-        QT_TR_NOOP("Ньютон в секунду"));
-    add(MeasUnit::KiloNewton_per_Sec,
-        kN / s,
-        UnitCategory::ForceRate,
-        QT_TR_NOOP("кН/с"),
-        QT_TR_NOOP("Килоньютон в секунду"));
-    add(MeasUnit::KilogramForce_per_Sec,
-        kgf / s,
-        UnitCategory::ForceRate,
-        QT_TR_NOOP("кгс/с"),
-        QT_TR_NOOP("кгс в секунду"));
-    add(MeasUnit::PoundForce_per_Sec,
-        lbf / s,
-        UnitCategory::ForceRate,
-        QT_TR_NOOP("фунт-сила/с"),
-        QT_TR_NOOP("Фунт-сила в секунду"));
-}
-
-// Внутренний хелпер доступа к реестру
-const UnitEntry &getEntry(MeasUnit u)
-{
-    static std::once_flag flag;
-    std::call_once(flag, initRegistry);
-    if (registry.contains(u))
-        return registry[u];
-    static UnitEntry unknown{UnitDef(), UnitCategory::Unknown, "?", "?"};
-    return unknown;
-}
+// Быстрая проверка на этапе компиляции: таблица и матрица согласованы
+static_assert(Table::affine(MeasUnit::Kilometer, MeasUnit::Meter).slope == 1000.0, "length table");
+static_assert(Table::affine(MeasUnit::Celsius, MeasUnit::Kelvin).offset == 273.15, "temperature offset");
 
 // =========================================================================
 // Реализация функций API
@@ -437,22 +59,21 @@ const UnitEntry &getEntry(MeasUnit u)
 
 bool isCompatible(MeasUnit u1, MeasUnit u2)
 {
-    return getEntry(u1).def.dimensions() == getEntry(u2).def.dimensions();
+    return entry(u1).def.dimensions() == entry(u2).def.dimensions();
 }
 
 double convert(double val, MeasUnit from, MeasUnit to)
 {
     if (from == to)
         return val;
-    Converter conv(from, to);
-    if (!conv.isValid())
-        return std::numeric_limits<double>::quiet_NaN();
-    return conv.process(val);
+    // Для несовместимых единиц коэффициенты - NaN, результат тоже NaN
+    const auto &a = affineOf(from, to);
+    return val * a.slope + a.offset;
 }
 
 UnitCategory category(MeasUnit u)
 {
-    return getEntry(u).category;
+    return entry(u).category;
 }
 
 QString categoryName(UnitCategory type)
@@ -504,53 +125,319 @@ QString categoryName(UnitCategory type)
 
 QList<MeasUnit> unitsByType(UnitCategory type)
 {
-    static std::once_flag flag;
-    std::call_once(flag, initRegistry);
-    QList<MeasUnit> result;
-    auto i = registry.constBegin();
-    while (i != registry.constEnd()) {
-        if (i.value().category == type)
-            result.append(i.key());
-        ++i;
-    }
-    return result;
+    // Списки по категориям строятся один раз; возвращается неявно разделяемая копия
+    static const std::array<QList<MeasUnit>, static_cast<int>(UnitCategory::ForceRate) + 1> lists =
+        [] {
+            std::array<QList<MeasUnit>, static_cast<int>(UnitCategory::ForceRate) + 1> l{};
+            // Индекс 0 (Unknown) в реестр не входит
+            for (int i = 1; i < Table::Count; ++i)
+                l[static_cast<int>(Table::Units[i].category)].append(Table::Units[i].unit);
+            return l;
+        }();
+    const int idx = static_cast<int>(type);
+    if (idx < 0 || idx >= static_cast<int>(lists.size()))
+        return {};
+    return lists[idx];
 }
 
 QString symbol(MeasUnit u)
 {
-    return QCoreApplication::translate("EvoUnit::TranslationContext", getEntry(u).symKey);
+    return QCoreApplication::translate("EvoUnit::TranslationContext", entry(u).symKey);
 }
 
 QString name(MeasUnit u)
 {
-    return QCoreApplication::translate("EvoUnit::TranslationContext", getEntry(u).nameKey);
+    return QCoreApplication::translate("EvoUnit::TranslationContext", entry(u).nameKey);
 }
 
 QString format(double value, MeasUnit u, int precision)
 {
-    return QLocale::system().toString(value, 'f', precision) + " " + symbol(u);
+    // Один форматтер на поток: локаль и символ не запрашиваются на каждом вызове
+    thread_local Formatter fmt;
+    fmt.setUnit(u);
+    fmt.setPrecision(precision);
+    return fmt.format(value);
+}
+
+// =========================================================================
+// Разбор строк "число единица"
+// =========================================================================
+namespace {
+
+// ASCII-псевдонимы: CSV и ручной ввод обычно приходят в латинице
+struct SymbolAlias
+{
+    const char16_t *sym;
+    MeasUnit unit;
+};
+
+// clang-format off
+const SymbolAlias asciiAliases[] = {
+    {u"-", MeasUnit::Dimensionless},
+    {u"mm", MeasUnit::Millimeter}, {u"cm", MeasUnit::Centimeter}, {u"dm", MeasUnit::Decimeter},
+    {u"m", MeasUnit::Meter}, {u"km", MeasUnit::Kilometer}, {u"um", MeasUnit::Micrometer},
+    {u"µm", MeasUnit::Micrometer}, {u"in", MeasUnit::Inch}, {u"inch", MeasUnit::Inch},
+    {u"ft", MeasUnit::Foot}, {u"yd", MeasUnit::Yard}, {u"mil", MeasUnit::Mil},
+    {u"s", MeasUnit::Second}, {u"sec", MeasUnit::Second}, {u"min", MeasUnit::Minute},
+    {u"h", MeasUnit::Hour}, {u"d", MeasUnit::Day}, {u"ms", MeasUnit::Millisecond},
+    {u"us", MeasUnit::Microsecond}, {u"µs", MeasUnit::Microsecond},
+    {u"K", MeasUnit::Kelvin}, {u"C", MeasUnit::Celsius}, {u"degC", MeasUnit::Celsius},
+    {u"F", MeasUnit::Fahrenheit}, {u"degF", MeasUnit::Fahrenheit},
+    {u"g", MeasUnit::Gram}, {u"kg", MeasUnit::Kilogram}, {u"lb", MeasUnit::Pound}, {u"t", MeasUnit::Tonne},
+    {u"N", MeasUnit::Newton}, {u"kN", MeasUnit::KiloNewton}, {u"MN", MeasUnit::MegaNewton},
+    {u"gf", MeasUnit::GramForce}, {u"kgf", MeasUnit::KilogramForce}, {u"tf", MeasUnit::TonForce},
+    {u"lbf", MeasUnit::PoundForce}, {u"kip", MeasUnit::Kip},
+    {u"Pa", MeasUnit::Pascal}, {u"kPa", MeasUnit::KiloPascal}, {u"MPa", MeasUnit::MegaPascal},
+    {u"GPa", MeasUnit::GigaPascal}, {u"N/mm2", MeasUnit::MegaPascal}, {u"N/mm²", MeasUnit::MegaPascal},
+    {u"bar", MeasUnit::Bar}, {u"mbar", MeasUnit::MilliBar}, {u"psi", MeasUnit::PSI}, {u"ksi", MeasUnit::KSI},
+    {u"kgf/cm2", MeasUnit::Kgf_per_CM2}, {u"kgf/cm²", MeasUnit::Kgf_per_CM2}, {u"at", MeasUnit::Kgf_per_CM2},
+    {u"atm", MeasUnit::Atmosphere},
+    {u"uV", MeasUnit::Microvolt}, {u"µV", MeasUnit::Microvolt}, {u"mV", MeasUnit::Millivolt},
+    {u"V", MeasUnit::Volt}, {u"kV", MeasUnit::Kilovolt},
+    {u"uA", MeasUnit::Microampere}, {u"µA", MeasUnit::Microampere}, {u"mA", MeasUnit::Milliampere},
+    {u"A", MeasUnit::Ampere}, {u"kA", MeasUnit::Kiloampere},
+    {u"mm/s", MeasUnit::MM_per_Sec}, {u"cm/s", MeasUnit::CM_per_Sec}, {u"dm/s", MeasUnit::DM_per_Sec},
+    {u"m/s", MeasUnit::Meter_per_Sec}, {u"in/s", MeasUnit::Inch_per_Sec}, {u"ft/s", MeasUnit::Foot_per_Sec},
+    {u"mil/s", MeasUnit::Mil_per_Sec},
+    {u"mm/min", MeasUnit::MM_per_Min}, {u"cm/min", MeasUnit::CM_per_Min}, {u"dm/min", MeasUnit::DM_per_Min},
+    {u"m/min", MeasUnit::Meter_per_Min}, {u"in/min", MeasUnit::Inch_per_Min}, {u"ft/min", MeasUnit::Foot_per_Min},
+    {u"mil/min", MeasUnit::Mil_per_Min}, {u"km/h", MeasUnit::KM_per_Hour},
+    {u"Pa/s", MeasUnit::Pascal_per_Sec}, {u"kPa/s", MeasUnit::KiloPascal_per_Sec},
+    {u"MPa/s", MeasUnit::MegaPascal_per_Sec}, {u"GPa/s", MeasUnit::GigaPascal_per_Sec},
+    {u"N/mm2/s", MeasUnit::Newton_per_MM2_per_Sec}, {u"N/mm²/s", MeasUnit::Newton_per_MM2_per_Sec},
+    {u"kgf/cm2/s", MeasUnit::Kgf_per_CM2_per_Sec}, {u"kgf/cm²/s", MeasUnit::Kgf_per_CM2_per_Sec},
+    {u"psi/s", MeasUnit::PSI_per_Sec}, {u"ksi/s", MeasUnit::KSI_per_Sec},
+    {u"N/s", MeasUnit::Newton_per_Sec}, {u"kN/s", MeasUnit::KiloNewton_per_Sec},
+    {u"kgf/s", MeasUnit::KilogramForce_per_Sec}, {u"lbf/s", MeasUnit::PoundForce_per_Sec},
+};
+// clang-format on
+
+// Хэш-таблица символов с открытой адресацией. Строится один раз, ключи хранятся
+// в нижнем регистре; поиск идет прямо по QStringView без копирования строки.
+class SymbolIndex
+{
+public:
+    SymbolIndex()
+    {
+        m_slots.resize(1024);
+        m_mask = static_cast<quint32>(m_slots.size() - 1);
+
+        // Приоритет: переведенный символ, исходный (русский), ASCII-псевдоним
+        for (int i = 1; i < Table::Count; ++i)
+            insert(symbol(Table::Units[i].unit), Table::Units[i].unit);
+        for (int i = 1; i < Table::Count; ++i)
+            insert(QString::fromUtf8(Table::Units[i].symKey), Table::Units[i].unit);
+        for (const auto &a : asciiAliases)
+            insert(QStringView(a.sym), a.unit);
+    }
+
+    MeasUnit find(QStringView sym) const
+    {
+        if (sym.isEmpty())
+            return MeasUnit::Unknown;
+        for (quint32 i = hashOf(sym) & m_mask; m_slots[i].used; i = (i + 1) & m_mask) {
+            if (equals(m_slots[i].key, sym))
+                return m_slots[i].unit;
+        }
+        return MeasUnit::Unknown;
+    }
+
+private:
+    struct Slot
+    {
+        std::u16string key{};
+        MeasUnit unit{MeasUnit::Unknown};
+        bool used{false};
+    };
+    std::vector<Slot> m_slots{};
+    quint32 m_mask{0};
+
+    static char16_t fold(QChar c) { return c.toLower().unicode(); }
+
+    static quint32 hashOf(QStringView s)
+    {
+        quint32 h = 2166136261u; // FNV-1a
+        for (QChar c : s) {
+            h ^= fold(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    static bool equals(const std::u16string &key, QStringView s)
+    {
+        if (key.size() != static_cast<size_t>(s.size()))
+            return false;
+        for (size_t i = 0; i < key.size(); ++i)
+            if (key[i] != fold(s[static_cast<qsizetype>(i)]))
+                return false;
+        return true;
+    }
+
+    void insert(QStringView sym, MeasUnit u)
+    {
+        if (sym.isEmpty() || find(sym) != MeasUnit::Unknown)
+            return; // Первое вхождение имеет приоритет
+        quint32 i = hashOf(sym) & m_mask;
+        while (m_slots[i].used)
+            i = (i + 1) & m_mask;
+        Slot &slot = m_slots[i];
+        slot.key.reserve(sym.size());
+        for (QChar c : sym)
+            slot.key.push_back(fold(c));
+        slot.unit = u;
+        slot.used = true;
+    }
+};
+
+// Таблица строится при первом разборе (после установки переводчика)
+const SymbolIndex &symbolIndex()
+{
+    static const SymbolIndex index;
+    return index;
+}
+
+inline bool isDigit(QChar c)
+{
+    return c.unicode() >= u'0' && c.unicode() <= u'9';
+}
+
+// Разбор числа с позиции pos: [+-]digits[.,]digits[e[+-]digits].
+// Десятичный разделитель - точка или запятая.
+bool scanNumber(QStringView s, qsizetype &pos, double &out)
+{
+    char buf[64];
+    int n = 0;
+    qsizetype i = pos;
+    const qsizetype len = s.size();
+
+    if (i < len && (s[i] == u'+' || s[i] == u'-')) {
+        if (s[i] == u'-')
+            buf[n++] = '-';
+        ++i;
+    }
+    int digits = 0;
+    for (; i < len && isDigit(s[i]) && n < 60; ++i, ++digits)
+        buf[n++] = static_cast<char>(s[i].unicode());
+    if (i < len && (s[i] == u'.' || s[i] == u',')) {
+        buf[n++] = '.';
+        for (++i; i < len && isDigit(s[i]) && n < 60; ++i, ++digits)
+            buf[n++] = static_cast<char>(s[i].unicode());
+    }
+    if (digits == 0)
+        return false;
+
+    // Экспонента берется, только если за 'e' действительно идут цифры
+    if (i < len && (s[i] == u'e' || s[i] == u'E')) {
+        qsizetype j = i + 1;
+        const bool neg = j < len && s[j] == u'-';
+        if (j < len && (s[j] == u'+' || s[j] == u'-'))
+            ++j;
+        if (j < len && isDigit(s[j])) {
+            buf[n++] = 'e';
+            if (neg)
+                buf[n++] = '-';
+            for (; j < len && isDigit(s[j]) && n < 63; ++j)
+                buf[n++] = static_cast<char>(s[j].unicode());
+            i = j;
+        }
+    }
+
+#if defined(__cpp_lib_to_chars)
+    const auto res = std::from_chars(buf, buf + n, out);
+    if (res.ec != std::errc())
+        return false;
+#else
+    bool ok = false;
+    out = QLocale::c().toDouble(QLatin1String(buf, n), &ok);
+    if (!ok)
+        return false;
+#endif
+    pos = i;
+    return true;
+}
+
+inline QStringView trimmed(QStringView s)
+{
+    qsizetype b = 0, e = s.size();
+    while (b < e && s[b].isSpace())
+        ++b;
+    while (e > b && s[e - 1].isSpace())
+        --e;
+    return s.mid(b, e - b);
+}
+
+} // namespace
+
+MeasUnit unitFromSymbol(QStringView sym)
+{
+    return symbolIndex().find(trimmed(sym));
 }
 
 ParsedValue parse(const QString &input)
 {
-    static QRegularExpression re("^([-+]?[0-9]*\\.?[0-9]+)\\s*(.*)$");
-    QRegularExpressionMatch match = re.match(input.trimmed().replace(',', '.'));
+    return parse(QStringView(input));
+}
 
-    if (!match.hasMatch())
+ParsedValue parse(QStringView input)
+{
+    const QStringView s = trimmed(input);
+    qsizetype pos = 0;
+    double val = 0.0;
+    if (!scanNumber(s, pos, val))
         return {0.0, MeasUnit::Unknown, false};
 
-    double val = match.captured(1).toDouble();
-    QString sym = match.captured(2).trimmed();
-
-    static std::once_flag flag;
-    std::call_once(flag, initRegistry);
+    const MeasUnit u = symbolIndex().find(trimmed(s.mid(pos)));
+    if (u == MeasUnit::Unknown)
+        return {val, MeasUnit::Unknown, false};
+    return {val, u, true};
+}
 
-    for (auto it = registry.constBegin(); it != registry.constEnd(); ++it) {
-        if (symbol(it.key()).compare(sym, Qt::CaseInsensitive) == 0) {
-            return {val, it.key(), true};
+int parseColumn(const QStringList &cells, MeasUnit targetUnit, double *out, MeasUnit *units)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const SymbolIndex &index = symbolIndex();
+
+    // В колонке CSV единица почти всегда одна: запоминаем последний символ,
+    // чтобы не считать хэш на каждой строке
+    QStringView lastSym;
+    MeasUnit lastUnit{MeasUnit::Unknown};
+    int parsed = 0;
+
+    for (qsizetype i = 0; i < cells.size(); ++i) {
+        out[i] = nan;
+        if (units)
+            units[i] = MeasUnit::Unknown;
+
+        const QStringView s = trimmed(cells[i]);
+        qsizetype pos = 0;
+        double val = 0.0;
+        if (!scanNumber(s, pos, val))
+            continue;
+
+        const QStringView sym = trimmed(s.mid(pos));
+        MeasUnit u = lastUnit;
+        if (lastSym.isNull() || sym != lastSym) {
+            u = index.find(sym);
+            lastSym = sym;
+            lastUnit = u;
         }
+        if (u == MeasUnit::Unknown)
+            continue;
+        if (units)
+            units[i] = u;
+
+        if (targetUnit == MeasUnit::Unknown || targetUnit == u) {
+            out[i] = val;
+        } else {
+            const auto &a = affineOf(u, targetUnit);
+            if (std::isnan(a.slope))
+                continue;
+            out[i] = val * a.slope + a.offset;
+        }
+        ++parsed;
     }
-    return {val, MeasUnit::Unknown, false};
+    return parsed;
 }
 
 QPair<double, MeasUnit> autoScale(double value, MeasUnit currentUnit)
@@ -580,25 +467,227 @@ QPair<double, MeasUnit> autoScale(double value, MeasUnit currentUnit)
     return {bestVal, bestUnit};
 }
 
+// =========================================================================
+// Пакетное преобразование
+// =========================================================================
+// Ядро y = x * a + b. Векторный цикл по 4 (AVX) / 2 (SSE2) double, хвост скалярно.
+// Невыровненные загрузки: массивы приходят из QVector без гарантий выравнивания.
+void applyAffine(const double *in, double *out, qsizetype count, double slope, double offset)
+{
+    qsizetype i = 0;
+#if defined(EVOUNIT_AVX)
+    const __m256d a4 = _mm256_set1_pd(slope);
+    const __m256d b4 = _mm256_set1_pd(offset);
+    for (; i + 4 <= count; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), a4), b4));
+#endif
+#if defined(EVOUNIT_SSE2)
+    const __m128d a2 = _mm_set1_pd(slope);
+    const __m128d b2 = _mm_set1_pd(offset);
+    for (; i + 2 <= count; i += 2)
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), a2), b2));
+#endif
+    for (; i < count; ++i)
+        out[i] = in[i] * slope + offset;
+}
+
+void applyAffine(const float *in, float *out, qsizetype count, float slope, float offset)
+{
+    qsizetype i = 0;
+#if defined(EVOUNIT_AVX)
+    const __m256 a8 = _mm256_set1_ps(slope);
+    const __m256 b8 = _mm256_set1_ps(offset);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), a8), b8));
+#endif
+#if defined(EVOUNIT_SSE2)
+    const __m128 a4 = _mm_set1_ps(slope);
+    const __m128 b4 = _mm_set1_ps(offset);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), a4), b4));
+#endif
+    for (; i < count; ++i)
+        out[i] = in[i] * slope + offset;
+}
+
+bool convert(const double *in, double *out, qsizetype count, MeasUnit from, MeasUnit to)
+{
+    const auto &a = affineOf(from, to);
+    if (std::isnan(a.slope))
+        return false;
+    if (from == to || (a.slope == 1.0 && a.offset == 0.0)) {
+        if (in != out)
+            std::copy(in, in + count, out);
+        return true;
+    }
+    applyAffine(in, out, count, a.slope, a.offset);
+    return true;
+}
+
+bool convert(const float *in, float *out, qsizetype count, MeasUnit from, MeasUnit to)
+{
+    const auto &a = affineOf(from, to);
+    if (std::isnan(a.slope))
+        return false;
+    if (from == to || (a.slope == 1.0 && a.offset == 0.0)) {
+        if (in != out)
+            std::copy(in, in + count, out);
+        return true;
+    }
+    applyAffine(in, out, count, static_cast<float>(a.slope), static_cast<float>(a.offset));
+    return true;
+}
+
+bool convert(QVector<double> &values, MeasUnit from, MeasUnit to)
+{
+    return convert(values.data(), values.data(), values.size(), from, to);
+}
+
+bool forceToStress(const double *force,
+                   double *stress,
+                   qsizetype count,
+                   MeasUnit forceUnit,
+                   double areaMm2,
+                   MeasUnit stressUnit)
+{
+    if (areaMm2 <= 0.0)
+        return false;
+    // Н/мм² == МПа: сводим всю цепочку в один множитель
+    const auto &toNewton = affineOf(forceUnit, MeasUnit::Newton);
+    const auto &fromMPa = affineOf(MeasUnit::MegaPascal, stressUnit);
+    if (std::isnan(toNewton.slope) || std::isnan(fromMPa.slope))
+        return false;
+    applyAffine(force, stress, count, toNewton.slope / areaMm2 * fromMPa.slope, 0.0);
+    return true;
+}
+
 // =========================================================================
 // Реализация Converter
 // =========================================================================
 Converter::Converter(MeasUnit from, MeasUnit to)
     : m_valid{false}
 {
-    if (!isCompatible(from, to)) {
-        m_slope = 1.0;
-        m_offset = 0.0;
+    const auto &a = affineOf(from, to);
+    if (std::isnan(a.slope))
+        return;
+    m_slope = a.slope;
+    m_offset = a.offset;
+    m_valid = true;
+}
+
+void Converter::process(const double *in, double *out, qsizetype count) const
+{
+    applyAffine(in, out, count, m_slope, m_offset);
+}
+
+void Converter::process(const float *in, float *out, qsizetype count) const
+{
+    applyAffine(in, out, count, static_cast<float>(m_slope), static_cast<float>(m_offset));
+}
+
+// =========================================================================
+// Реализация Formatter
+// =========================================================================
+Formatter::Formatter(MeasUnit unit, int precision, const QLocale &locale, bool showSymbol)
+    : m_showSymbol{showSymbol}
+{
+    setPrecision(precision);
+    setLocale(locale);
+    m_unit = unit;
+    m_suffix = m_showSymbol ? " " + symbol(m_unit) : QString();
+}
+
+void Formatter::setUnit(MeasUnit unit)
+{
+    if (unit == m_unit)
         return;
+    m_unit = unit;
+    m_suffix = m_showSymbol ? " " + symbol(m_unit) : QString();
+}
+
+void Formatter::setShowSymbol(bool on)
+{
+    m_showSymbol = on;
+    m_suffix = m_showSymbol ? " " + symbol(m_unit) : QString();
+}
+
+void Formatter::setLocale(const QLocale &locale)
+{
+    m_locale = locale;
+    // QString(...) - в Qt5 эти методы возвращают QChar, в Qt6 - QString
+    m_decimal = QString(locale.decimalPoint());
+    m_minus = QString(locale.negativeSign());
+    m_group = (locale.numberOptions() & QLocale::OmitGroupSeparator) ? QString()
+                                                                     : QString(locale.groupSeparator());
+    m_plainDigits = QString(locale.zeroDigit()) == QLatin1String("0");
+}
+
+QStringView Formatter::view(double value)
+{
+    char digits[128];
+    int len = -1;
+    if (m_plainDigits && std::isfinite(value)) {
+#if defined(__cpp_lib_to_chars)
+        const auto res = std::to_chars(digits,
+                                       digits + sizeof(digits),
+                                       value,
+                                       std::chars_format::fixed,
+                                       m_precision);
+        if (res.ec == std::errc())
+            len = static_cast<int>(res.ptr - digits);
+#else
+        const QByteArray ascii = QByteArray::number(value, 'f', m_precision);
+        if (ascii.size() < static_cast<int>(sizeof(digits))) {
+            std::copy(ascii.constBegin(), ascii.constEnd(), digits);
+            len = ascii.size();
+        }
+#endif
     }
-    const auto &dFrom = getEntry(from).def;
-    const auto &dTo = getEntry(to).def;
 
-    double ratio = dFrom.factor() / dTo.factor();
-    m_slope = ratio;
-    // Корректная логика offset:
-    m_offset = (dFrom.offset() * ratio) - dTo.offset();
-    m_valid = true;
+    m_buf.clear();
+    if (len < 0) {
+        // Нестандартные цифры, inf/nan или огромные числа - через QLocale
+        const QString s = m_locale.toString(value, 'f', m_precision);
+        m_buf.append(s.constData(), s.size());
+    } else {
+        // "-1234.50" -> "-1 234,50" по правилам локали (группы по 3 цифры)
+        int p = 0;
+        if (digits[0] == '-') {
+            m_buf.append(m_minus.constData(), m_minus.size());
+            p = 1;
+        }
+        int intEnd = p;
+        while (intEnd < len && digits[intEnd] != '.')
+            ++intEnd;
+        const int intDigits = intEnd - p;
+        for (int i = p; i < intEnd; ++i) {
+            const int left = intEnd - i;
+            if (!m_group.isEmpty() && i > p && left % 3 == 0 && intDigits > 3)
+                m_buf.append(m_group.constData(), m_group.size());
+            m_buf.append(QLatin1Char(digits[i]));
+        }
+        if (intEnd < len) {
+            m_buf.append(m_decimal.constData(), m_decimal.size());
+            for (int i = intEnd + 1; i < len; ++i)
+                m_buf.append(QLatin1Char(digits[i]));
+        }
+    }
+    m_buf.append(m_suffix.constData(), m_suffix.size());
+    return QStringView(m_buf.constData(), m_buf.size());
+}
+
+void Formatter::formatTo(double value, QString &out)
+{
+    const QStringView v = view(value);
+    // resize() не перераспределяет память, если емкости хватает
+    out.resize(v.size());
+    std::copy(v.begin(), v.end(), out.begin());
+}
+
+void Formatter::format(const double *values, qsizetype count, QString *out)
+{
+    for (qsizetype i = 0; i < count; ++i)
+        formatTo(values[i], out[i]);
 }
 
 QDebug operator<<(QDebug dbg, MeasUnit u)
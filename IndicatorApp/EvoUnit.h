@@ -3,11 +3,17 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QList>
+#include <QLocale>
 #include <QMetaType>
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVarLengthArray>
 #include <QVariant>
+#include <QVector>
 #include <cmath>
+#include <cstdint>
 
 namespace EvoUnit {
 
@@ -148,28 +154,54 @@ Q_ENUM_NS(UnitCategory)
 struct Dimensions
 {
     int8_t L, M, T, Theta, I;
-    bool operator==(const Dimensions &o) const
+    constexpr bool operator==(const Dimensions &o) const
     {
         return L == o.L && M == o.M && T == o.T && Theta == o.Theta && I == o.I;
     }
-    bool operator!=(const Dimensions &o) const { return !(*this == o); }
+    constexpr bool operator!=(const Dimensions &o) const { return !(*this == o); }
 };
 
 // =========================================================================
 // UnitDef: Value Object (Физика)
 // =========================================================================
+// Полностью constexpr: реестр единиц строится на этапе компиляции (EvoUnitTable.h)
 class UnitDef
 {
 public:
-    UnitDef(double factor = 1.0, double offset = 0.0, Dimensions dim = {0, 0, 0, 0, 0});
+    constexpr UnitDef(double factor = 1.0, double offset = 0.0, Dimensions dim = {0, 0, 0, 0, 0})
+        : m_factor{factor}
+        , m_offset{offset}
+        , m_dim{dim}
+    {}
 
-    UnitDef operator*(const UnitDef &other) const;
-    UnitDef operator/(const UnitDef &other) const;
-    UnitDef operator*(double scale) const;
+    constexpr UnitDef operator*(const UnitDef &other) const
+    {
+        return UnitDef(m_factor * other.m_factor,
+                       0.0,
+                       {static_cast<int8_t>(m_dim.L + other.m_dim.L),
+                        static_cast<int8_t>(m_dim.M + other.m_dim.M),
+                        static_cast<int8_t>(m_dim.T + other.m_dim.T),
+                        static_cast<int8_t>(m_dim.Theta + other.m_dim.Theta),
+                        static_cast<int8_t>(m_dim.I + other.m_dim.I)});
+    }
+    constexpr UnitDef operator/(const UnitDef &other) const
+    {
+        return UnitDef(m_factor / other.m_factor,
+                       0.0,
+                       {static_cast<int8_t>(m_dim.L - other.m_dim.L),
+                        static_cast<int8_t>(m_dim.M - other.m_dim.M),
+                        static_cast<int8_t>(m_dim.T - other.m_dim.T),
+                        static_cast<int8_t>(m_dim.Theta - other.m_dim.Theta),
+                        static_cast<int8_t>(m_dim.I - other.m_dim.I)});
+    }
+    constexpr UnitDef operator*(double scale) const
+    {
+        return UnitDef(m_factor * scale, m_offset, m_dim);
+    }
 
-    double factor() const { return m_factor; }
-    double offset() const { return m_offset; }
-    Dimensions dimensions() const { return m_dim; }
+    constexpr double factor() const { return m_factor; }
+    constexpr double offset() const { return m_offset; }
+    constexpr Dimensions dimensions() const { return m_dim; }
 
 private:
     double m_factor{1.0};
@@ -184,11 +216,13 @@ private:
 double convert(double val, MeasUnit from, MeasUnit to);
 UnitCategory category(MeasUnit u);
 QString categoryName(UnitCategory type);
+// Список кэшируется при первом обращении, повторные вызовы не аллоцируют
 QList<MeasUnit> unitsByType(UnitCategory type);
 bool isCompatible(MeasUnit u1, MeasUnit u2);
 
 QString symbol(MeasUnit u);
 QString name(MeasUnit u);
+// Разовое форматирование; для частых обновлений используйте Formatter
 QString format(double value, MeasUnit u, int precision = 2);
 
 struct ParsedValue
@@ -198,18 +232,60 @@ struct ParsedValue
     bool valid{false};
 };
 ParsedValue parse(const QString &input);
+// Без регулярных выражений и аллокаций: число + символ единицы (русский или ASCII: "кН", "kN", "mm/min")
+ParsedValue parse(QStringView input);
+
+// Пакетный разбор колонки (импорт CSV). Каждое значение переводится в targetUnit;
+// пустые, нераспознанные и несовместимые ячейки дают NaN.
+// Если targetUnit == Unknown, значения остаются в своих единицах (units заполняется всегда, если не nullptr).
+// Возвращает количество успешно разобранных ячеек.
+int parseColumn(const QStringList &cells,
+                MeasUnit targetUnit,
+                double *out,
+                MeasUnit *units = nullptr);
+
+// Поиск единицы по символу (без учета регистра)
+MeasUnit unitFromSymbol(QStringView sym);
 
 QPair<double, MeasUnit> autoScale(double value, MeasUnit currentUnit);
 
+// =========================================================================
+// Пакетное преобразование массивов (SIMD, со скалярным запасным путем)
+// =========================================================================
+// in и out могут совпадать (преобразование на месте), частичное перекрытие не допускается.
+// Возвращает false для несовместимых единиц (out при этом не изменяется).
+bool convert(const double *in, double *out, qsizetype count, MeasUnit from, MeasUnit to);
+bool convert(const float *in, float *out, qsizetype count, MeasUnit from, MeasUnit to);
+bool convert(QVector<double> &values, MeasUnit from, MeasUnit to);
+
+// out[i] = in[i] * slope + offset
+void applyAffine(const double *in, double *out, qsizetype count, double slope, double offset);
+void applyAffine(const float *in, float *out, qsizetype count, float slope, float offset);
+
+// Сила -> напряжение за один проход: stress = F / S0.
+// areaMm2 - площадь сечения в мм², stressUnit - единица давления результата.
+bool forceToStress(const double *force,
+                   double *stress,
+                   qsizetype count,
+                   MeasUnit forceUnit,
+                   double areaMm2,
+                   MeasUnit stressUnit);
+
 // =========================================================================
 // Converter (Helper Class)
 // =========================================================================
 class Converter
 {
 public:
+    // Коэффициенты берутся из предвычисленной матрицы from x to
     Converter(MeasUnit from, MeasUnit to);
 
     inline double process(double value) const { return value * m_slope + m_offset; }
+    // Пакетные варианты (см. applyAffine)
+    void process(const double *in, double *out, qsizetype count) const;
+    void process(const float *in, float *out, qsizetype count) const;
+    double slope() const { return m_slope; }
+    double offset() const { return m_offset; }
     bool isValid() const { return m_valid; }
 
 private:
@@ -218,6 +294,49 @@ private:
     bool m_valid{false};
 };
 
+// =========================================================================
+// Formatter (Форматирование с кэшем)
+// =========================================================================
+// Локаль, символ единицы и точность запоминаются один раз; число печатается
+// через to_chars во внутренний буфер с подстановкой разделителей локали.
+// Для ячеек и надписей, обновляемых десятки раз в секунду.
+class Formatter
+{
+public:
+    explicit Formatter(MeasUnit unit = MeasUnit::Unknown,
+                       int precision = 2,
+                       const QLocale &locale = QLocale::system(),
+                       bool showSymbol = true);
+
+    void setUnit(MeasUnit unit);
+    void setPrecision(int precision) { m_precision = qBound(0, precision, 17); }
+    void setLocale(const QLocale &locale);
+    void setShowSymbol(bool on);
+
+    MeasUnit unit() const { return m_unit; }
+    int precision() const { return m_precision; }
+
+    // Результат во внутреннем буфере: действителен до следующего вызова
+    QStringView view(double value);
+    QString format(double value) { return view(value).toString(); }
+    // Запись в готовую строку (переиспользует ее память)
+    void formatTo(double value, QString &out);
+    // Пакет значений одной единицы и точности
+    void format(const double *values, qsizetype count, QString *out);
+
+private:
+    MeasUnit m_unit{MeasUnit::Unknown};
+    int m_precision{2};
+    bool m_showSymbol{true};
+    QLocale m_locale{};
+    bool m_plainDigits{true}; // Локаль использует цифры 0-9 (иначе - через QLocale)
+    QString m_decimal{};
+    QString m_group{};
+    QString m_minus{};
+    QString m_suffix{}; // " " + символ
+    QVarLengthArray<QChar, 128> m_buf{};
+};
+
 QDebug operator<<(QDebug dbg, MeasUnit u);
 
 // =========================================================================
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "EvoUnit.h"
+#include <limits>
+
+// Таблица единиц, вычисляемая на этапе компиляции.
+// Порядок строк совпадает с порядком MeasUnit: доступ к единице - индекс массива.
+// Подключается только там, где нужна constexpr-физика (EvoUnit.cpp, EvoQuantity.h),
+// чтобы не тянуть таблицу в каждый модуль.
+
+namespace EvoUnit {
+namespace Table {
+
+// =========================================================================
+// БАЗОВЫЕ И ПРОИЗВОДНЫЕ ЕДИНИЦЫ (СИ)
+// =========================================================================
+namespace Si {
+inline constexpr UnitDef m{1.0, 0.0, {1, 0, 0, 0, 0}};  // Метр
+inline constexpr UnitDef kg{1.0, 0.0, {0, 1, 0, 0, 0}}; // Килограмм
+inline constexpr UnitDef s{1.0, 0.0, {0, 0, 1, 0, 0}};  // Секунда
+inline constexpr UnitDef K{1.0, 0.0, {0, 0, 0, 1, 0}};  // Кельвин
+inline constexpr UnitDef A{1.0, 0.0, {0, 0, 0, 0, 1}};  // Ампер
+
+// --- БЕЗРАЗМЕРНАЯ ---
+inline constexpr UnitDef dimless{1.0, 0.0, {0, 0, 0, 0, 0}};
+
+// --- 1. ДЛИНА ---
+inline constexpr UnitDef mm = m * 0.001;
+inline constexpr UnitDef cm = m * 0.01;
+inline constexpr UnitDef dm = m * 0.1;
+inline constexpr UnitDef km = m * 1000.0;
+inline constexpr UnitDef um = m * 1.0e-6;
+
+inline constexpr UnitDef inch = m * 0.0254;
+inline constexpr UnitDef ft = inch * 12.0;
+inline constexpr UnitDef yd = ft * 3.0;
+inline constexpr UnitDef mil = inch * 0.001; // мил
+
+// Площади (для расчета давления)
+inline constexpr UnitDef mm2 = mm * mm;
+inline constexpr UnitDef cm2 = cm * cm;
+inline constexpr UnitDef inch2 = inch * inch;
+
+// --- 2. ВРЕМЯ ---
+inline constexpr UnitDef ms = s * 0.001;
+inline constexpr UnitDef us = s * 1.0e-6;
+inline constexpr UnitDef min = s * 60.0;
+inline constexpr UnitDef hr = min * 60.0;
+inline constexpr UnitDef day = hr * 24.0;
+
+// --- 3. МАССА ---
+inline constexpr UnitDef g_mass = kg * 0.001;
+inline constexpr UnitDef lb = kg * 0.45359237;
+inline constexpr UnitDef tonne = kg * 1000.0;
+
+// --- 4. ТЕМПЕРАТУРА ---
+inline constexpr UnitDef degC{1.0, 273.15, {0, 0, 0, 1, 0}};
+inline constexpr UnitDef degF{5.0 / 9.0, 459.67, {0, 0, 0, 1, 0}};
+
+// --- 5. СИЛА ТОКА ---
+inline constexpr UnitDef mA = A * 0.001;
+inline constexpr UnitDef uA = A * 1.0e-6;
+inline constexpr UnitDef kA = A * 1000.0;
+
+// --- 6. СИЛА (F = ma) ---
+inline constexpr UnitDef N = kg * m / (s * s);
+inline constexpr UnitDef kN = N * 1000.0;
+inline constexpr UnitDef MN = N * 1.0e6;
+
+inline constexpr double gravity{9.80665};
+inline constexpr UnitDef kgf = N * gravity;
+inline constexpr UnitDef gf = kgf * 0.001;
+inline constexpr UnitDef tf = kgf * 1000.0;
+
+inline constexpr UnitDef lbf = lb * gravity * m / (s * s);
+inline constexpr UnitDef kip = lbf * 1000.0;
+
+// --- 7. ДАВЛЕНИЕ (P = F / S) ---
+inline constexpr UnitDef Pa = N / (m * m);
+inline constexpr UnitDef kPa = Pa * 1000.0;
+inline constexpr UnitDef MPa = Pa * 1.0e6;
+inline constexpr UnitDef GPa = Pa * 1.0e9;
+
+inline constexpr UnitDef bar = Pa * 1.0e5;
+inline constexpr UnitDef mbar = bar * 0.001;
+
+inline constexpr UnitDef psi = lbf / inch2;
+inline constexpr UnitDef ksi = psi * 1000.0;
+inline constexpr UnitDef kgf_cm2 = kgf / cm2;
+inline constexpr UnitDef atm = Pa * 101325.0;
+
+// --- 8. НАПРЯЖЕНИЕ ---
+inline constexpr UnitDef V = (N * m / s) / A;
+inline constexpr UnitDef mV = V * 0.001;
+inline constexpr UnitDef uV = V * 1.0e-6;
+inline constexpr UnitDef kV = V * 1000.0;
+} // namespace Si
+
+struct UnitEntry
+{
+    MeasUnit unit{MeasUnit::Unknown};
+    UnitDef def{};
+    UnitCategory category{UnitCategory::Unknown};
+    const char *symKey{nullptr};
+    const char *nameKey{nullptr};
+};
+
+// =========================================================================
+// РЕЕСТР (строка i описывает MeasUnit(i))
+// =========================================================================
+using namespace Si;
+
+// clang-format off
+inline constexpr UnitEntry Units[] = {
+    // Порядок строк обязан совпадать с enum MeasUnit (проверяется static_assert ниже)
+    // Индекс 0: неизвестная единица (безразмерная, без имени)
+    {MeasUnit::Unknown, UnitDef(), UnitCategory::Unknown, "?", "?"},
+
+    // --- Безразмерная ---
+    {MeasUnit::Dimensionless, dimless, UnitCategory::Dimensionless, QT_TR_NOOP("-"), QT_TR_NOOP("Безразмерная")},
+
+    // --- Длина ---
+    {MeasUnit::Millimeter, mm, UnitCategory::Length, QT_TR_NOOP("мм"), QT_TR_NOOP("Миллиметр")},
+    {MeasUnit::Centimeter, cm, UnitCategory::Length, QT_TR_NOOP("см"), QT_TR_NOOP("Сантиметр")},
+    {MeasUnit::Decimeter, dm, UnitCategory::Length, QT_TR_NOOP("дм"), QT_TR_NOOP("Дециметр")},
+    {MeasUnit::Meter, m, UnitCategory::Length, QT_TR_NOOP("м"), QT_TR_NOOP("Метр")},
+    {MeasUnit::Kilometer, km, UnitCategory::Length, QT_TR_NOOP("км"), QT_TR_NOOP("Километр")},
+    {MeasUnit::Micrometer, um, UnitCategory::Length, QT_TR_NOOP("мкм"), QT_TR_NOOP("Микрометр")},
+    {MeasUnit::Inch, inch, UnitCategory::Length, QT_TR_NOOP("дюйм"), QT_TR_NOOP("Дюйм")},
+    {MeasUnit::Foot, ft, UnitCategory::Length, QT_TR_NOOP("фт"), QT_TR_NOOP("Фут")},
+    {MeasUnit::Yard, yd, UnitCategory::Length, QT_TR_NOOP("ярд"), QT_TR_NOOP("Ярд")},
+    {MeasUnit::Mil, mil, UnitCategory::Length, QT_TR_NOOP("мил"), QT_TR_NOOP("Мил")},
+
+    // --- Время ---
+    {MeasUnit::Second, s, UnitCategory::Time, QT_TR_NOOP("с"), QT_TR_NOOP("Секунда")},
+    {MeasUnit::Minute, min, UnitCategory::Time, QT_TR_NOOP("мин"), QT_TR_NOOP("Минута")},
+    {MeasUnit::Hour, hr, UnitCategory::Time, QT_TR_NOOP("ч"), QT_TR_NOOP("Час")},
+    {MeasUnit::Day, day, UnitCategory::Time, QT_TR_NOOP("дн"), QT_TR_NOOP("День")},
+    {MeasUnit::Millisecond, ms, UnitCategory::Time, QT_TR_NOOP("мс"), QT_TR_NOOP("Миллисекунда")},
+    {MeasUnit::Microsecond, us, UnitCategory::Time, QT_TR_NOOP("мкс"), QT_TR_NOOP("Микросекунда")},
+
+    // --- Температура ---
+    {MeasUnit::Kelvin, K, UnitCategory::Temperature, QT_TR_NOOP("K"), QT_TR_NOOP("Кельвин")},
+    {MeasUnit::Celsius, degC, UnitCategory::Temperature, QT_TR_NOOP("°C"), QT_TR_NOOP("Градус Цельсия")},
+    {MeasUnit::Fahrenheit, degF, UnitCategory::Temperature, QT_TR_NOOP("°F"), QT_TR_NOOP("Градус Фаренгейта")},
+
+    // --- Масса ---
+    {MeasUnit::Gram, g_mass, UnitCategory::Mass, QT_TR_NOOP("г"), QT_TR_NOOP("Грамм")},
+    {MeasUnit::Kilogram, kg, UnitCategory::Mass, QT_TR_NOOP("кг"), QT_TR_NOOP("Килограмм")},
+    {MeasUnit::Pound, lb, UnitCategory::Mass, QT_TR_NOOP("lb"), QT_TR_NOOP("Фунт")},
+    {MeasUnit::Tonne, tonne, UnitCategory::Mass, QT_TR_NOOP("т"), QT_TR_NOOP("Тонна")},
+
+    // --- Сила ---
+    {MeasUnit::Newton, N, UnitCategory::Force, QT_TR_NOOP("Н"), QT_TR_NOOP("Ньютон")},
+    {MeasUnit::KiloNewton, kN, UnitCategory::Force, QT_TR_NOOP("кН"), QT_TR_NOOP("Килоньютон")},
+    {MeasUnit::MegaNewton, MN, UnitCategory::Force, QT_TR_NOOP("МН"), QT_TR_NOOP("Меганьютон")},
+    {MeasUnit::GramForce, gf, UnitCategory::Force, QT_TR_NOOP("гс"), QT_TR_NOOP("Грамм-сила")},
+    {MeasUnit::KilogramForce, kgf, UnitCategory::Force, QT_TR_NOOP("кгс"), QT_TR_NOOP("Килограмм-сила")},
+    {MeasUnit::TonForce, tf, UnitCategory::Force, QT_TR_NOOP("тс"), QT_TR_NOOP("Тонна-сила")},
+    {MeasUnit::PoundForce, lbf, UnitCategory::Force, QT_TR_NOOP("фунт-сила"), QT_TR_NOOP("Фунт-сила")},
+    {MeasUnit::Kip, kip, UnitCategory::Force, QT_TR_NOOP("kip"), QT_TR_NOOP("Килофунт-сила")},
+
+    // --- Давление ---
+    {MeasUnit::Pascal, Pa, UnitCategory::Pressure, QT_TR_NOOP("Па"), QT_TR_NOOP("Паскаль")},
+    {MeasUnit::KiloPascal, kPa, UnitCategory::Pressure, QT_TR_NOOP("кПа"), QT_TR_NOOP("Килопаскаль")},
+    {MeasUnit::MegaPascal, MPa, UnitCategory::Pressure, QT_TR_NOOP("МПа"), QT_TR_NOOP("Мегапаскаль")},
+    {MeasUnit::GigaPascal, GPa, UnitCategory::Pressure, QT_TR_NOOP("ГПа"), QT_TR_NOOP("Гигапаскаль")},
+    {MeasUnit::Bar, bar, UnitCategory::Pressure, QT_TR_NOOP("бар"), QT_TR_NOOP("Бар")},
+    {MeasUnit::MilliBar, mbar, UnitCategory::Pressure, QT_TR_NOOP("мбар"), QT_TR_NOOP("Миллибар")},
+    {MeasUnit::PSI, psi, UnitCategory::Pressure, QT_TR_NOOP("psi"), QT_TR_NOOP("PSI")},
+    {MeasUnit::KSI, ksi, UnitCategory::Pressure, QT_TR_NOOP("ksi"), QT_TR_NOOP("KSI")},
+    {MeasUnit::Kgf_per_CM2, kgf_cm2, UnitCategory::Pressure, QT_TR_NOOP("кгс/см²"), QT_TR_NOOP("Тех. атмосфера")},
+    {MeasUnit::Atmosphere, atm, UnitCategory::Pressure, QT_TR_NOOP("атм"), QT_TR_NOOP("Атмосфера")},
+
+    // --- Напряжение (Voltage) ---
+    {MeasUnit::Microvolt, uV, UnitCategory::Voltage, QT_TR_NOOP("мкВ"), QT_TR_NOOP("Микровольт")},
+    {MeasUnit::Millivolt, mV, UnitCategory::Voltage, QT_TR_NOOP("мВ"), QT_TR_NOOP("Милливольт")},
+    {MeasUnit::Volt, V, UnitCategory::Voltage, QT_TR_NOOP("В"), QT_TR_NOOP("Вольт")},
+    {MeasUnit::Kilovolt, kV, UnitCategory::Voltage, QT_TR_NOOP("кВ"), QT_TR_NOOP("Киловольт")},
+
+    // --- Сила тока (Current) ---
+    {MeasUnit::Microampere, uA, UnitCategory::Current, QT_TR_NOOP("мкА"), QT_TR_NOOP("Микроампер")},
+    {MeasUnit::Milliampere, mA, UnitCategory::Current, QT_TR_NOOP("мА"), QT_TR_NOOP("Миллиампер")},
+    {MeasUnit::Ampere, A, UnitCategory::Current, QT_TR_NOOP("А"), QT_TR_NOOP("Ампер")},
+    {MeasUnit::Kiloampere, kA, UnitCategory::Current, QT_TR_NOOP("кА"), QT_TR_NOOP("Килоампер")},
+
+    // --- Скорость (Velocity) ---
+    {MeasUnit::MM_per_Sec, mm / s, UnitCategory::Velocity, QT_TR_NOOP("мм/с"), QT_TR_NOOP("мм в секунду")},
+    {MeasUnit::CM_per_Sec, cm / s, UnitCategory::Velocity, QT_TR_NOOP("см/с"), QT_TR_NOOP("см в секунду")},
+    {MeasUnit::DM_per_Sec, dm / s, UnitCategory::Velocity, QT_TR_NOOP("дм/с"), QT_TR_NOOP("дм в секунду")},
+    {MeasUnit::Meter_per_Sec, m / s, UnitCategory::Velocity, QT_TR_NOOP("м/с"), QT_TR_NOOP("м в секунду")},
+    {MeasUnit::Inch_per_Sec, inch / s, UnitCategory::Velocity, QT_TR_NOOP("дюйм/с"), QT_TR_NOOP("дюйм в секунду")},
+    {MeasUnit::Foot_per_Sec, ft / s, UnitCategory::Velocity, QT_TR_NOOP("фут/с"), QT_TR_NOOP("фут в секунду")},
+    {MeasUnit::Mil_per_Sec, mil / s, UnitCategory::Velocity, QT_TR_NOOP("мил/с"), QT_TR_NOOP("мил в секунду")},
+    {MeasUnit::MM_per_Min, mm / min, UnitCategory::Velocity, QT_TR_NOOP("мм/мин"), QT_TR_NOOP("мм в минуту")},
+    {MeasUnit::CM_per_Min, cm / min, UnitCategory::Velocity, QT_TR_NOOP("см/мин"), QT_TR_NOOP("см в минуту")},
+    {MeasUnit::DM_per_Min, dm / min, UnitCategory::Velocity, QT_TR_NOOP("дм/мин"), QT_TR_NOOP("дм в минуту")},
+    {MeasUnit::Meter_per_Min, m / min, UnitCategory::Velocity, QT_TR_NOOP("м/мин"), QT_TR_NOOP("м в минуту")},
+    {MeasUnit::Inch_per_Min, inch / min, UnitCategory::Velocity, QT_TR_NOOP("дюйм/мин"), QT_TR_NOOP("дюйм в минуту")},
+    {MeasUnit::Foot_per_Min, ft / min, UnitCategory::Velocity, QT_TR_NOOP("фут/мин"), QT_TR_NOOP("фут в минуту")},
+    {MeasUnit::Mil_per_Min, mil / min, UnitCategory::Velocity, QT_TR_NOOP("мил/мин"), QT_TR_NOOP("мил в минуту")},
+    {MeasUnit::KM_per_Hour, km / hr, UnitCategory::Velocity, QT_TR_NOOP("км/ч"), QT_TR_NOOP("км в час")},
+
+    // --- Скорость роста давления (Pressure Rate) ---
+    {MeasUnit::Pascal_per_Sec, Pa / s, UnitCategory::PressureRate, QT_TR_NOOP("Па/с"), QT_TR_NOOP("Паскаль в секунду")},
+    {MeasUnit::KiloPascal_per_Sec, kPa / s, UnitCategory::PressureRate, QT_TR_NOOP("кПа/с"), QT_TR_NOOP("Килопаскаль в секунду")},
+    {MeasUnit::MegaPascal_per_Sec, MPa / s, UnitCategory::PressureRate, QT_TR_NOOP("МПа/с"), QT_TR_NOOP("Мегапаскаль в секунду")},
+    {MeasUnit::GigaPascal_per_Sec, GPa / s, UnitCategory::PressureRate, QT_TR_NOOP("ГПа/с"), QT_TR_NOOP("Гигапаскаль в секунду")},
+    {MeasUnit::Newton_per_MM2_per_Sec, N / mm2 / s, UnitCategory::PressureRate, QT_TR_NOOP("Н/мм²/с"), QT_TR_NOOP("Н/мм² в секунду")},
+    {MeasUnit::Kgf_per_CM2_per_Sec, kgf / cm2 / s, UnitCategory::PressureRate, QT_TR_NOOP("кгс/см²/с"), QT_TR_NOOP("кгс/см² в секунду")},
+    {MeasUnit::PSI_per_Sec, psi / s, UnitCategory::PressureRate, QT_TR_NOOP("psi/с"), QT_TR_NOOP("psi в секунду")},
+    {MeasUnit::KSI_per_Sec, ksi / s, UnitCategory::PressureRate, QT_TR_NOOP("ksi/с"), QT_TR_NOOP("ksi в секунду")},
+
+    // --- Скорость роста силы (Force Rate) ---
+    {MeasUnit::Newton_per_Sec, N / s, UnitCategory::ForceRate, QT_TR_NOOP("Н/с"), QT_TR_NOOP("Ньютон в секунду")},
+    {MeasUnit::KiloNewton_per_Sec, kN / s, UnitCategory::ForceRate, QT_TR_NOOP("кН/с"), QT_TR_NOOP("Килоньютон в секунду")},
+    {MeasUnit::KilogramForce_per_Sec, kgf / s, UnitCategory::ForceRate, QT_TR_NOOP("кгс/с"), QT_TR_NOOP("кгс в секунду")},
+    {MeasUnit::PoundForce_per_Sec, lbf / s, UnitCategory::ForceRate, QT_TR_NOOP("фунт-сила/с"), QT_TR_NOOP("Фунт-сила в секунду")},
+};
+// clang-format on
+
+inline constexpr int Count = static_cast<int>(sizeof(Units) / sizeof(Units[0]));
+static_assert(Count == static_cast<int>(MeasUnit::PoundForce_per_Sec) + 1,
+              "EvoUnit::Table::Units must list every MeasUnit");
+
+constexpr bool isOrdered()
+{
+    for (int i = 0; i < Count; ++i)
+        if (static_cast<int>(Units[i].unit) != i)
+            return false;
+    return true;
+}
+static_assert(isOrdered(), "EvoUnit::Table::Units rows must follow MeasUnit order");
+
+// Неизвестные значения (например, из старого конфига) отображаются на Unknown
+constexpr int indexOf(MeasUnit u)
+{
+    const int i = static_cast<int>(u);
+    return (i >= 0 && i < Count) ? i : 0;
+}
+
+constexpr const UnitEntry &entry(MeasUnit u)
+{
+    return Units[indexOf(u)];
+}
+
+// Линейное преобразование from -> to: to = from * slope + offset.
+// Для несовместимых единиц slope/offset = NaN.
+struct Affine
+{
+    double slope{1.0};
+    double offset{0.0};
+};
+
+constexpr Affine affine(MeasUnit from, MeasUnit to)
+{
+    const UnitDef &dFrom = entry(from).def;
+    const UnitDef &dTo = entry(to).def;
+    if (dFrom.dimensions() != dTo.dimensions())
+        return {std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()};
+    const double ratio = dFrom.factor() / dTo.factor();
+    // Корректная логика offset:
+    return {ratio, (dFrom.offset() * ratio) - dTo.offset()};
+}
+
+} // namespace Table
+} // namespace EvoUnit
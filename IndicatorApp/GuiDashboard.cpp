@@ -1,8 +1,16 @@
 #include "GuiDashboard.h"
+#include <QApplication>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QDebug>
+#include <QHBoxLayout>
 #include <QHeaderView>
+#include <QPainter>
+#include <QSpinBox>
 #include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace EvoGui {
 using namespace EvoModbus;
@@ -21,6 +29,46 @@ static void fillUnitsByCategory(QComboBox *cb, EvoUnit::UnitCategory cat)
     }
 }
 
+// =========================================================
+// TREND BUFFER
+// =========================================================
+
+void TrendBuffer::reset(qint64 bucketMs)
+{
+    m_bucketMs = qMax<qint64>(1, bucketMs);
+    m_buckets.fill({});
+    m_headIndex = -1;
+    m_head = 0;
+}
+
+void TrendBuffer::add(qint64 timeMs, double value)
+{
+    if (!std::isfinite(value))
+        return;
+    const qint64 idx = timeMs / m_bucketMs;
+    if (m_headIndex < 0) {
+        m_headIndex = idx;
+    } else if (idx > m_headIndex) {
+        // Сдвигаем окно, пропущенные интервалы остаются пустыми
+        const qint64 steps = qMin<qint64>(idx - m_headIndex, BucketCount);
+        for (qint64 k = 0; k < steps; ++k) {
+            m_head = (m_head + 1) % BucketCount;
+            m_buckets[m_head] = {};
+        }
+        m_headIndex = idx;
+    }
+
+    Bucket &b = m_buckets[m_head];
+    const float v = static_cast<float>(value);
+    if (!b.valid) {
+        b.min = b.max = v;
+        b.valid = true;
+    } else {
+        b.min = qMin(b.min, v);
+        b.max = qMax(b.max, v);
+    }
+}
+
 // =========================================================
 // TABLE MODEL
 // =========================================================
@@ -29,36 +77,154 @@ MonitorTableModel::MonitorTableModel(Controller *c, QObject *p)
     : QAbstractTableModel(p)
     , m_controller(c)
 {
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    connect(m_refreshTimer, &QTimer::timeout, this, &MonitorTableModel::refresh);
     // При обновлении данных в контроллере обновляем таблицу
     connect(m_controller, &Controller::channelsUpdated, this, &MonitorTableModel::onDataUpdated);
     // Первичная синхронизация
-    syncRows();
+    refresh();
+}
+
+void MonitorTableModel::setMaxRefreshRate(int hz)
+{
+    m_maxRefreshHz = qMax(0, hz);
+}
+
+void MonitorTableModel::setTrendEnabled(bool on)
+{
+    if (m_trendEnabled == on)
+        return;
+    m_trendEnabled = on;
+    resetTrends();
+}
+
+void MonitorTableModel::setTrendWindow(int minutes)
+{
+    minutes = qMax(1, minutes);
+    if (m_trendMinutes == minutes)
+        return;
+    m_trendMinutes = minutes;
+    resetTrends();
+    emit headerDataChanged(Qt::Horizontal, Col_Trend, Col_Trend);
+}
+
+const MonitorRow *MonitorTableModel::row(int r) const
+{
+    if (r < 0 || r >= m_rows.size())
+        return nullptr;
+    return &m_rows[r];
+}
+
+qint64 MonitorTableModel::trendBucketMs() const
+{
+    return m_trendMinutes * 60000LL / TrendBuffer::BucketCount;
+}
+
+void MonitorTableModel::resetTrends()
+{
+    m_trendClock.start();
+    const qint64 bucketMs = trendBucketMs();
+    for (auto &row : m_rows)
+        row.trend.reset(bucketMs);
+    if (!m_rows.isEmpty())
+        emit dataChanged(index(0, Col_Trend), index(m_rows.size() - 1, Col_Trend));
+}
+
+void MonitorTableModel::sampleTrends()
+{
+    // Каждый цикл опроса попадает в историю, даже если значение не изменилось
+    const qint64 t = m_trendClock.elapsed();
+    const auto &channels = m_controller->channels();
+    for (auto it = channels.constBegin(); it != channels.constEnd(); ++it) {
+        const int r = m_rowIndex.value(it.key(), -1);
+        if (r >= 0)
+            m_rows[r].trend.add(t, it->value.toDouble());
+    }
 }
 
 void MonitorTableModel::onDataUpdated()
 {
+    if (m_trendEnabled)
+        sampleTrends();
+
+    // Обновления между кадрами сливаются: таблица перерисовывается не чаще m_maxRefreshHz
+    if (m_refreshTimer->isActive())
+        return;
+    if (m_maxRefreshHz <= 0 || !m_lastRefresh.isValid()) {
+        refresh();
+        return;
+    }
+    const qint64 wait = 1000 / m_maxRefreshHz - m_lastRefresh.elapsed();
+    if (wait <= 0)
+        refresh();
+    else
+        m_refreshTimer->start(static_cast<int>(wait));
+}
+
+void MonitorTableModel::refresh()
+{
+    m_lastRefresh.start();
+    // Тренд сдвигается со временем, даже если значения стоят на месте
+    if (m_trendEnabled && !m_rows.isEmpty())
+        emit dataChanged(index(0, Col_Trend), index(m_rows.size() - 1, Col_Trend), {Qt::DisplayRole});
+
+    // Ничего не изменилось с прошлого кадра
+    if (m_controller->revision() == m_seenRevision && m_rows.size() == m_controller->channels().size())
+        return;
+    m_seenRevision = m_controller->revision();
+
     // 1. Синхронизируем структуру (если появились новые каналы или удалились старые)
     syncRows();
 
-    // 2. Обновляем значения (все строки, колонка Value)
-    if (!m_rows.isEmpty()) {
-        QModelIndex topLeft = index(0, Col_Value);
-        QModelIndex bottomRight = index(m_rows.size() - 1, Col_Value);
-        emit dataChanged(topLeft, bottomRight, {Qt::DisplayRole});
-
-        // Также обновляем NativeUnit, вдруг он сменился в конфиге
-        QModelIndex tlNative = index(0, Col_NativeUnit);
-        QModelIndex brNative = index(m_rows.size() - 1, Col_NativeUnit);
-        emit dataChanged(tlNative, brNative, {Qt::DisplayRole});
+    // 2. Пересчитываем только строки, у которых сменилась ревизия канала
+    const auto &channels = m_controller->channels();
+    m_dirtyRows.clear();
+    for (auto it = channels.constBegin(); it != channels.constEnd(); ++it) {
+        const int r = m_rowIndex.value(it.key(), -1);
+        if (r < 0)
+            continue;
+        MonitorRow &row = m_rows[r];
+        if (row.revision == it->revision)
+            continue;
+        row.revision = it->revision;
+        if (row.nativeUnit != it->unit) {
+            row.nativeUnit = it->unit;
+            row.nativeText = EvoUnit::name(row.nativeUnit);
+            updateConverter(row);
+        }
+        updateValueText(row, *it);
+        m_dirtyRows.append(r);
+    }
+    if (m_dirtyRows.isEmpty())
+        return;
+
+    // 3. Сообщаем виду непрерывные диапазоны измененных строк (Value..NativeUnit)
+    std::sort(m_dirtyRows.begin(), m_dirtyRows.end());
+    int first = m_dirtyRows.first();
+    int last = first;
+    for (int k = 1; k <= m_dirtyRows.size(); ++k) {
+        if (k < m_dirtyRows.size() && m_dirtyRows[k] == last + 1) {
+            last = m_dirtyRows[k];
+            continue;
+        }
+        emit dataChanged(index(first, Col_Value), index(last, Col_NativeUnit), {Qt::DisplayRole});
+        if (k < m_dirtyRows.size())
+            first = last = m_dirtyRows[k];
     }
 }
 
 void MonitorTableModel::syncRows()
 {
-    auto channels = m_controller->getChannels(); // QMap<QString, ChannelData>
-    QList<QString> currentIds = channels.keys();
+    const auto &channels = m_controller->channels();
+
+    // Структура меняется редко (загрузка конфига): проверяем дешево по хэшу
+    bool same = channels.size() == m_rows.size();
+    for (auto it = channels.constBegin(); same && it != channels.constEnd(); ++it)
+        same = m_rowIndex.contains(it.key());
+    if (same)
+        return;
 
-    // Простой алгоритм синхронизации:
     // 1. Удаляем из m_rows те, которых нет в channels
     for (int i = m_rows.size() - 1; i >= 0; --i) {
         if (!channels.contains(m_rows[i].id)) {
@@ -67,28 +233,56 @@ void MonitorTableModel::syncRows()
             endRemoveRows();
         }
     }
+    rebuildIndex();
 
     // 2. Добавляем в m_rows те, которые есть в channels, но нет у нас
-    // Для оптимизации поиска можно использовать QSet, но для GUI списка < 1000 элементов это не критично
-    for (const QString &id : currentIds) {
-        bool found = false;
-        for (const auto &row : m_rows) {
-            if (row.id == id) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size());
-            MonitorRow newRow;
-            newRow.id = id;
-            newRow.displayUnit = EvoUnit::MeasUnit::Unknown; // По умолчанию Auto
-            m_rows.append(newRow);
-            endInsertRows();
-        }
+    for (auto it = channels.constBegin(); it != channels.constEnd(); ++it) {
+        if (m_rowIndex.contains(it.key()))
+            continue;
+        const int r = m_rows.size();
+        beginInsertRows(QModelIndex(), r, r);
+        MonitorRow newRow;
+        newRow.id = it.key();
+        newRow.displayUnit = EvoUnit::MeasUnit::Unknown; // По умолчанию Auto
+        newRow.nativeUnit = it->unit;
+        newRow.nativeText = EvoUnit::name(it->unit);
+        newRow.revision = it->revision;
+        newRow.trend.reset(trendBucketMs());
+        updateConverter(newRow);
+        updateValueText(newRow, *it);
+        m_rows.append(newRow);
+        m_rowIndex.insert(newRow.id, r);
+        endInsertRows();
     }
 }
 
+void MonitorTableModel::rebuildIndex()
+{
+    m_rowIndex.clear();
+    m_rowIndex.reserve(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i)
+        m_rowIndex.insert(m_rows[i].id, i);
+}
+
+void MonitorTableModel::updateConverter(MonitorRow &row)
+{
+    // Если пользователь не выбрал юнит, берем родной
+    row.identity = row.displayUnit == EvoUnit::MeasUnit::Unknown
+                   || row.displayUnit == row.nativeUnit;
+    if (!row.identity)
+        row.converter = EvoUnit::Converter(row.nativeUnit, row.displayUnit);
+}
+
+void MonitorTableModel::updateValueText(MonitorRow &row, const ChannelData &ch)
+{
+    double val = ch.value.toDouble();
+    if (!row.identity)
+        val = row.converter.isValid() ? row.converter.process(val)
+                                      : std::numeric_limits<double>::quiet_NaN();
+    // Форматируем число (буфер строки переиспользуется)
+    row.formatter.formatTo(val, row.valueText);
+}
+
 int MonitorTableModel::rowCount(const QModelIndex &) const
 {
     return m_rows.size();
@@ -103,15 +297,9 @@ QVariant MonitorTableModel::data(const QModelIndex &idx, int role) const
     if (!idx.isValid() || idx.row() >= m_rows.size())
         return {};
 
+    // Все строки готовятся в refresh(), здесь только чтение кэша
     const auto &row = m_rows[idx.row()];
 
-    // Получаем актуальные данные из контроллера
-    auto channels = m_controller->getChannels();
-    if (!channels.contains(row.id))
-        return QVariant(); // Should not happen after sync
-
-    ChannelData chData = channels[row.id];
-
     if (role == Qt::DisplayRole) {
         switch (idx.column()) {
         case Col_ID:
@@ -124,23 +312,10 @@ QVariant MonitorTableModel::data(const QModelIndex &idx, int role) const
         }
 
         case Col_NativeUnit:
-            return EvoUnit::name(chData.unit);
-
-        case Col_Value: {
-            double val = chData.value.toDouble();
-            EvoUnit::MeasUnit targetUnit = row.displayUnit;
-
-            // Если пользователь не выбрал юнит, берем родной
-            if (targetUnit == EvoUnit::MeasUnit::Unknown) {
-                targetUnit = chData.unit;
-            }
+            return row.nativeText;
 
-            // Пытаемся конвертировать
-            double convertedVal = EvoUnit::convert(val, chData.unit, targetUnit);
-
-            // Форматируем число
-            return QString::number(convertedVal, 'f', 2);
-        }
+        case Col_Value:
+            return row.valueText;
         }
     }
 
@@ -154,7 +329,13 @@ QVariant MonitorTableModel::data(const QModelIndex &idx, int role) const
 bool MonitorTableModel::setData(const QModelIndex &idx, const QVariant &val, int role)
 {
     if (role == Qt::EditRole && idx.column() == Col_DisplayUnit) {
-        m_rows[idx.row()].displayUnit = (EvoUnit::MeasUnit) val.toInt();
+        auto &row = m_rows[idx.row()];
+        row.displayUnit = (EvoUnit::MeasUnit) val.toInt();
+        updateConverter(row);
+        const auto &channels = m_controller->channels();
+        auto it = channels.constFind(row.id);
+        if (it != channels.constEnd())
+            updateValueText(row, *it);
         emit dataChanged(idx, idx);
         // Значение зависит от юнита, обновляем и его
         emit dataChanged(index(idx.row(), Col_Value), index(idx.row(), Col_Value));
@@ -175,6 +356,8 @@ QVariant MonitorTableModel::headerData(int sec, Qt::Orientation o, int r) const
             return "Value";
         case Col_NativeUnit:
             return "Native Unit";
+        case Col_Trend:
+            return QString("Trend (%1 min)").arg(m_trendMinutes);
         }
     }
     return {};
@@ -211,9 +394,10 @@ QWidget *MonitorDelegate::createEditor(QWidget *p,
         // Узнаем ID канала
         QString id = idx.sibling(idx.row(), MonitorTableModel::Col_ID).data().toString();
         // Узнаем его родную категорию из контроллера
-        auto channels = m_controller->getChannels();
-        if (channels.contains(id)) {
-            EvoUnit::UnitCategory cat = EvoUnit::category(channels[id].unit);
+        const auto &channels = m_controller->channels();
+        auto it = channels.constFind(id);
+        if (it != channels.constEnd()) {
+            EvoUnit::UnitCategory cat = EvoUnit::category(it->unit);
             fillUnitsByCategory(cb, cat);
         }
         return cb;
@@ -238,6 +422,98 @@ void MonitorDelegate::setModelData(QWidget *e, QAbstractItemModel *m, const QMod
     }
 }
 
+// =========================================================
+// TREND DELEGATE
+// =========================================================
+
+void TrendDelegate::paint(QPainter *painter,
+                          const QStyleOptionViewItem &option,
+                          const QModelIndex &index) const
+{
+    // Фон и выделение рисует стиль, текста в ячейке нет
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+    const QWidget *w = opt.widget;
+    QStyle *style = w ? w->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, w);
+
+    auto *model = qobject_cast<const MonitorTableModel *>(index.model());
+    const MonitorRow *row = model ? model->row(index.row()) : nullptr;
+    if (!row || row->trend.isEmpty())
+        return;
+    const TrendBuffer &trend = row->trend;
+    const int n = TrendBuffer::BucketCount;
+
+    // Диапазон по оси Y (в родных единицах канала)
+    float lo = 0.0f, hi = 0.0f;
+    bool any = false;
+    for (int i = 0; i < n; ++i) {
+        const auto &b = trend.at(i);
+        if (!b.valid)
+            continue;
+        lo = any ? qMin(lo, b.min) : b.min;
+        hi = any ? qMax(hi, b.max) : b.max;
+        any = true;
+    }
+    if (!any)
+        return;
+
+    const QRect rc = option.rect.adjusted(2, 3, -2, -3);
+    const int width = rc.width();
+    if (width <= 0 || rc.height() <= 0)
+        return;
+    const double span = hi > lo ? double(hi) - lo : 1.0;
+    const double yScale = (rc.height() - 1) / span;
+    const double yBase = hi > lo ? rc.bottom() : rc.center().y();
+    auto yOf = [&](float v) { return yBase - (v - lo) * yScale; };
+
+    // Один отрезок min..max на пиксель; соседние отрезки перекрываются,
+    // чтобы линия оставалась непрерывной, когда корзин меньше, чем пикселей
+    QVector<QLineF> lines;
+    lines.reserve(width);
+    bool havePrev = false;
+    float prevMin = 0.0f, prevMax = 0.0f;
+    for (int x = 0; x < width; ++x) {
+        const int b0 = x * n / width;
+        const int b1 = qMax(b0 + 1, (x + 1) * n / width);
+        float mn = 0.0f, mx = 0.0f;
+        bool valid = false;
+        for (int i = b0; i < b1; ++i) {
+            const auto &b = trend.at(i);
+            if (!b.valid)
+                continue;
+            mn = valid ? qMin(mn, b.min) : b.min;
+            mx = valid ? qMax(mx, b.max) : b.max;
+            valid = true;
+        }
+        if (!valid) {
+            havePrev = false;
+            continue;
+        }
+        const float segMin = havePrev ? qMin(mn, prevMax) : mn;
+        const float segMax = havePrev ? qMax(mx, prevMin) : mx;
+        const double px = rc.left() + x + 0.5;
+        lines.append(QLineF(px, yOf(segMin), px, yOf(segMax)));
+        prevMin = mn;
+        prevMax = mx;
+        havePrev = true;
+    }
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(opt.state & QStyle::State_Selected ? opt.palette.highlightedText().color()
+                                                       : QColor(0x1f, 0x77, 0xb4));
+    painter->drawLines(lines);
+    painter->restore();
+}
+
+QSize TrendDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QSize sz = QStyledItemDelegate::sizeHint(option, index);
+    sz.setWidth(qMax(sz.width(), 160));
+    return sz;
+}
+
 // =========================================================
 // WIDGET
 // =========================================================
@@ -247,12 +523,25 @@ DashboardWidget::DashboardWidget(Controller *c, QWidget *p)
 {
     auto *layout = new QVBoxLayout(this);
 
+    // Панель трендов
+    auto *trendBar = new QHBoxLayout();
+    auto *chkTrend = new QCheckBox("Trend", this);
+    auto *sbMinutes = new QSpinBox(this);
+    sbMinutes->setRange(1, 60);
+    sbMinutes->setValue(5);
+    sbMinutes->setSuffix(" min");
+    trendBar->addWidget(chkTrend);
+    trendBar->addWidget(sbMinutes);
+    trendBar->addStretch();
+    layout->addLayout(trendBar);
+
     // Таблица занимает всё пространство
     m_model = new MonitorTableModel(c, this);
     m_view = new QTableView(this);
 
     m_view->setModel(m_model);
     m_view->setItemDelegate(new MonitorDelegate(c, this));
+    m_view->setItemDelegateForColumn(MonitorTableModel::Col_Trend, new TrendDelegate(this));
 
     m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_view->setAlternatingRowColors(true);
@@ -263,7 +552,24 @@ DashboardWidget::DashboardWidget(Controller *c, QWidget *p)
     m_view->horizontalHeader()->setSectionResizeMode(MonitorTableModel::Col_NativeUnit,
                                                      QHeaderView::ResizeToContents);
 
+    m_view->horizontalHeader()->setSectionResizeMode(MonitorTableModel::Col_Trend,
+                                                     QHeaderView::Interactive);
+    m_view->setColumnWidth(MonitorTableModel::Col_Trend, 240);
+    m_view->setColumnHidden(MonitorTableModel::Col_Trend, true);
+
     layout->addWidget(m_view);
+
+    connect(chkTrend, &QCheckBox::toggled, this, &DashboardWidget::onTrendToggled);
+    connect(sbMinutes,
+            QOverload<int>::of(&QSpinBox::valueChanged),
+            m_model,
+            &MonitorTableModel::setTrendWindow);
+}
+
+void DashboardWidget::onTrendToggled(bool on)
+{
+    m_model->setTrendEnabled(on);
+    m_view->setColumnHidden(MonitorTableModel::Col_Trend, !on);
 }
 
 } // namespace EvoGui
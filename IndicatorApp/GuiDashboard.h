@@ -1,13 +1,49 @@
 #pragma once
 
 #include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QStyledItemDelegate>
 #include <QTableView>
+#include <QTimer>
 #include <QWidget>
+#include <array>
 #include "EvoModbus.h"
 
 namespace EvoGui {
 
+// =========================================================
+// TREND BUFFER (История канала с прореживанием min/max)
+// =========================================================
+// Кольцо фиксированного числа корзин, каждая хранит min/max значений,
+// попавших в свой интервал времени. Память и стоимость отрисовки
+// не зависят от частоты опроса и длины окна.
+class TrendBuffer
+{
+public:
+    static constexpr int BucketCount{240};
+
+    struct Bucket
+    {
+        float min{0.0f};
+        float max{0.0f};
+        bool valid{false};
+    };
+
+    void reset(qint64 bucketMs);
+    void add(qint64 timeMs, double value);
+
+    // Корзина i из окна: 0 - самая старая, BucketCount-1 - текущая
+    const Bucket &at(int i) const { return m_buckets[(m_head + 1 + i) % BucketCount]; }
+    bool isEmpty() const { return m_headIndex < 0; }
+
+private:
+    std::array<Bucket, BucketCount> m_buckets{};
+    qint64 m_bucketMs{1000};
+    qint64 m_headIndex{-1}; // Абсолютный номер текущей корзины (time / bucketMs)
+    int m_head{0};          // Позиция текущей корзины в кольце
+};
+
 // Структура строки монитора
 struct MonitorRow
 {
@@ -15,6 +51,17 @@ struct MonitorRow
     // Единица, в которой пользователь ХОЧЕТ видеть значение.
     // Если Unknown, отображается в "родной" единице канала.
     EvoUnit::MeasUnit displayUnit{EvoUnit::MeasUnit::Unknown};
+
+    // Кэш отображения: пересчитывается только при смене ревизии канала
+    quint64 revision{0};
+    EvoUnit::MeasUnit nativeUnit{EvoUnit::MeasUnit::Unknown};
+    EvoUnit::Converter converter{EvoUnit::MeasUnit::Unknown, EvoUnit::MeasUnit::Unknown};
+    bool identity{true}; // Единица отображения совпадает с родной
+    EvoUnit::Formatter formatter{EvoUnit::MeasUnit::Unknown, 2, QLocale::c(), false};
+    QString valueText{};
+    QString nativeText{};
+
+    TrendBuffer trend{};
 };
 
 class MonitorTableModel : public QAbstractTableModel
@@ -26,6 +73,7 @@ public:
         Col_DisplayUnit,
         Col_Value,
         Col_NativeUnit, // Доп. колонка для инфо
+        Col_Trend,      // Спарклайн за последние N минут
         Col_Count
     };
 
@@ -40,15 +88,46 @@ public:
                         int role = Qt::DisplayRole) const override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 
+    // Максимальная частота обновления таблицы (Гц), 0 - без ограничения
+    void setMaxRefreshRate(int hz);
+
+    // Тренды: накопление истории включается только вместе с колонкой
+    void setTrendEnabled(bool on);
+    bool trendEnabled() const { return m_trendEnabled; }
+    void setTrendWindow(int minutes);
+    int trendWindow() const { return m_trendMinutes; }
+    const MonitorRow *row(int r) const;
+
 public slots:
     void onDataUpdated();
 
+private slots:
+    void refresh();
+
 private:
     EvoModbus::Controller *m_controller;
     QVector<MonitorRow> m_rows;
+    QHash<QString, int> m_rowIndex{}; // id -> номер строки
+    quint64 m_seenRevision{0};
+
+    QTimer *m_refreshTimer{nullptr};
+    QElapsedTimer m_lastRefresh{};
+    int m_maxRefreshHz{10};
+    QVector<int> m_dirtyRows{};
+
+    bool m_trendEnabled{false};
+    int m_trendMinutes{5};
+    QElapsedTimer m_trendClock{};
+
+    void resetTrends();
+    void sampleTrends();
+    qint64 trendBucketMs() const;
 
     // Синхронизация списка строк с контроллером
     void syncRows();
+    void rebuildIndex();
+    void updateConverter(MonitorRow &row);
+    void updateValueText(MonitorRow &row, const EvoModbus::ChannelData &ch);
 };
 
 class MonitorDelegate : public QStyledItemDelegate
@@ -69,6 +148,20 @@ private:
     EvoModbus::Controller *m_controller;
 };
 
+// Отрисовка колонки тренда: одна вертикальная линия min..max на пиксель,
+// стоимость зависит от ширины ячейки, а не от числа отсчетов
+class TrendDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter *painter,
+               const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
 class DashboardWidget : public QWidget
 {
     Q_OBJECT
@@ -78,6 +171,8 @@ public:
 private:
     MonitorTableModel *m_model{nullptr};
     QTableView *m_view{nullptr};
+
+    void onTrendToggled(bool on);
 };
 
 } // namespace EvoGui
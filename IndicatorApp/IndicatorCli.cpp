@@ -0,0 +1,126 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+#include "EvoModbus.h"
+#include "EvoStream.h"
+#include <csignal>
+#include <memory>
+
+// Консольный демон сбора: та же конфигурация JSON, что и у IndicatorApp,
+// опрос + формулы без Qt Widgets, поток значений в CSV/бинарный файл или stdout.
+
+// Обработчик сигнала только ставит флаг (quit() из обработчика небезопасен),
+// цикл событий проверяет его таймером
+static volatile std::sig_atomic_t g_terminate = 0;
+
+static void onTerminate(int)
+{
+    g_terminate = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("IndicatorCli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("EvoModbus headless acquisition daemon");
+    parser.addHelpOption();
+
+    QCommandLineOption optConfig({"c", "config"}, "Config file (IndicatorApp JSON).", "file");
+    QCommandLineOption optHost("host", "Modbus TCP server address.", "ip", "127.0.0.1");
+    QCommandLineOption optPort("port", "Modbus TCP port.", "port", "502");
+    QCommandLineOption optInterval({"i", "interval"}, "Polling interval, ms.", "ms", "500");
+    QCommandLineOption optOutput({"o", "output"}, "Output file, '-' for stdout.", "file", "-");
+    QCommandLineOption optFormat({"f", "format"}, "Output format: csv | bin.", "fmt", "csv");
+    QCommandLineOption optStats("stats", "Stats period, s (0 - off).", "sec", "10");
+    QCommandLineOption optRecord("record", "Record raw traffic journal.", "file");
+    QCommandLineOption optReplay("replay", "Replay journal instead of polling.", "file");
+    QCommandLineOption optSpeed("speed", "Replay speed (0 - no delays).", "x", "1");
+    parser.addOptions({optConfig,
+                       optHost,
+                       optPort,
+                       optInterval,
+                       optOutput,
+                       optFormat,
+                       optStats,
+                       optRecord,
+                       optReplay,
+                       optSpeed});
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    if (!parser.isSet(optConfig)) {
+        err << "Config file is required (--config)" << Qt::endl;
+        return 1;
+    }
+
+    EvoModbus::Controller controller;
+    QObject::connect(&controller, &EvoModbus::Controller::error, [&err](QString msg) {
+        err << "[error] " << msg << Qt::endl;
+    });
+
+    if (!controller.loadConfig(parser.value(optConfig)))
+        return 1;
+
+    EvoModbus::Streamer streamer(&controller);
+    auto format = parser.value(optFormat) == "bin" ? EvoModbus::Streamer::Format::Binary
+                                                   : EvoModbus::Streamer::Format::Csv;
+    if (!streamer.open(parser.value(optOutput), format)) {
+        err << "Cannot open output: " << parser.value(optOutput) << Qt::endl;
+        return 1;
+    }
+    streamer.setStatsInterval(parser.value(optStats).toInt());
+    QObject::connect(&streamer, &EvoModbus::Streamer::statsReport, [&err](QString line) {
+        err << line << Qt::endl;
+    });
+
+    std::signal(SIGINT, onTerminate);
+    std::signal(SIGTERM, onTerminate);
+    auto *terminateTimer = new QTimer(&app);
+    QObject::connect(terminateTimer, &QTimer::timeout, [&app]() {
+        if (g_terminate)
+            app.quit();
+    });
+    terminateTimer->start(100);
+
+    if (parser.isSet(optReplay)) {
+        QObject::connect(&controller,
+                         &EvoModbus::Controller::replayFinished,
+                         &app,
+                         &QCoreApplication::quit);
+        if (!controller.startReplay(parser.value(optReplay), parser.value(optSpeed).toDouble()))
+            return 1;
+    } else {
+        if (parser.isSet(optRecord) && !controller.startRecording(parser.value(optRecord)))
+            return 1;
+        const QString host = parser.value(optHost);
+        const int port = parser.value(optPort).toInt();
+        // Долгая работа без присмотра: если связи нет, периодически переподключаемся
+        auto linkUp = std::make_shared<bool>(false);
+        QObject::connect(&controller,
+                         &EvoModbus::Controller::connectionStateChanged,
+                         [&err, linkUp](bool connected) {
+                             if (connected != *linkUp)
+                                 err << (connected ? "[link] connected" : "[link] disconnected")
+                                     << Qt::endl;
+                             *linkUp = connected;
+                         });
+        auto *watchdog = new QTimer(&app);
+        QObject::connect(watchdog, &QTimer::timeout, [&controller, linkUp, host, port]() {
+            if (!*linkUp)
+                controller.connectToServer(host, port);
+        });
+        watchdog->start(10000);
+        controller.connectToServer(host, port);
+        controller.start(parser.value(optInterval).toInt());
+    }
+
+    int rc = app.exec();
+    controller.stop();
+    controller.stopRecording();
+    streamer.close();
+    return rc;
+}
@@ -1,10 +1,12 @@
 #include "MainWindow.h"
+#include <QAction>
 #include <QApplication>
 #include <QFileDialog>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QMenu>
 #include <QMenuBar>
+#include <QSignalBlocker>
 #include <QStatusBar>
 #include <QStyle>
 #include <QVBoxLayout>
@@ -37,6 +39,11 @@ void MainWindow::setupUi()
     fileMenu->addAction("Load Config...", this, &MainWindow::onActionLoad, QKeySequence::Open);
     fileMenu->addAction("Save Config...", this, &MainWindow::onActionSave, QKeySequence::Save);
     fileMenu->addSeparator();
+    m_actRecord = fileMenu->addAction("Record Traffic...");
+    m_actRecord->setCheckable(true);
+    connect(m_actRecord, &QAction::toggled, this, &MainWindow::onActionRecord);
+    fileMenu->addAction("Replay Journal...", this, &MainWindow::onActionReplay);
+    fileMenu->addSeparator();
     fileMenu->addAction("Exit", qApp, &QApplication::quit);
 
     auto *central = new QWidget(this);
@@ -158,6 +165,38 @@ void MainWindow::onActionSave()
     }
 }
 
+void MainWindow::onActionRecord(bool checked)
+{
+    if (!checked) {
+        m_controller->stopRecording();
+        statusBar()->showMessage("Recording stopped", 3000);
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    "Record Traffic",
+                                                    "",
+                                                    "Evo Journal (*.evoj)");
+    if (fileName.isEmpty() || !m_controller->startRecording(fileName)) {
+        QSignalBlocker blocker(m_actRecord);
+        m_actRecord->setChecked(false);
+        return;
+    }
+    statusBar()->showMessage("Recording to " + fileName);
+}
+
+void MainWindow::onActionReplay()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    "Replay Journal",
+                                                    "",
+                                                    "Evo Journal (*.evoj)");
+    if (fileName.isEmpty())
+        return;
+    // Воспроизведение в исходном темпе
+    if (m_controller->startReplay(fileName, 1.0))
+        statusBar()->showMessage("Replaying " + fileName);
+}
+
 void MainWindow::onActionLoad()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "Load Config", "", "JSON Files (*.json)");
@@ -24,6 +24,8 @@ private slots:
     // [NEW] Слоты меню
     void onActionSave();
     void onActionLoad();
+    void onActionRecord(bool checked);
+    void onActionReplay();
 
     // [NEW] Слоты состояния
     void onConnectionState(bool connected);
@@ -41,6 +43,7 @@ private:
     QPushButton *m_btnConnect{nullptr};
     QPushButton *m_btnDisconnect{nullptr};
     QLabel *m_lblStatus{nullptr};
+    QAction *m_actRecord{nullptr};
 
     EvoGui::SourceConfigWidget *m_sourceWidget{nullptr};
     EvoGui::FormulaConfigWidget *m_formulaWidget{nullptr};
@@ -40,25 +40,82 @@ Extension_Raw_mm = (strain_ideal * L0) + Slack_mm;
 Stress_MPa = Force_Raw_N / S0;
 Strain_Raw = Extension_Raw_mm / L0; 
 
-% Б. Расчет Модуля упругости (Et) по ISO 527
-% Диапазон строго: 0.05% (0.0005) ... 0.25% (0.0025)
-val_e1 = 0.0005; % 0.05% от L0!!!!
-val_e2 = 0.0025; % 0.025% от L0!!!!
+% Б. Самый линейный участок кривой нагружения (для коррекции нуля)
+% Из-за слабины (Slack_mm) сырая деформация не начинается с нуля, и точки
+% 0.05% / 0.25% по ней попадают не туда. Поэтому сначала ищем самое линейное
+% окно: окна покрывают по напряжению полосу 15/20/30% от максимума, конец окна
+% ищется вторым указателем по огибающей (cummax), суммы окна - разность
+% префиксных сумм (cumsum). Весь перебор - O(n) на полосу, лучшее окно - по R^2.
+[Stress_Max, idx_max] = max(Stress_MPa);
+xs = Strain_Raw(1:idx_max);
+ys = Stress_MPa(1:idx_max);
+cx = mean(xs); cy = mean(ys); % Центрирование - меньше потеря точности в суммах
+xc = xs - cx; yc = ys - cy;
+S1  = [0, cumsum(ones(1, idx_max))];
+Sx  = [0, cumsum(xc)];      Sy  = [0, cumsum(yc)];
+Sxx = [0, cumsum(xc.^2)];   Sxy = [0, cumsum(xc.*yc)];   Syy = [0, cumsum(yc.^2)];
+env = cummax(ys);
+
+best = struct('r2', -Inf, 'i', 0, 'j', 0, 'k', NaN, 'b', NaN);
+for band = [0.15, 0.20, 0.30]
+    j = 1;
+    for i = 1:idx_max
+        top = env(i) + band * Stress_Max;
+        if top > Stress_Max, break; end
+        if env(i) < 0.02 * Stress_Max, continue; end % Шум около нуля
+        while j < idx_max && (j <= i || env(j) < top)
+            j = j + 1;
+        end
+        if env(j) < top, break; end
+
+        % Окно i..j (включительно) через префиксные суммы
+        n = S1(j+1) - S1(i);
+        if n < 10, continue; end
+        sx = Sx(j+1) - Sx(i);
+        sy = Sy(j+1) - Sy(i);
+        dxx = Sxx(j+1) - Sxx(i) - sx^2 / n;
+        dxy = Sxy(j+1) - Sxy(i) - sx * sy / n;
+        dyy = Syy(j+1) - Syy(i) - sy^2 / n;
+        if dxx <= 0 || dyy <= 0, continue; end
+
+        k = dxy / dxx;
+        r2 = dxy^2 / (dxx * dyy);
+        if k > 0 && r2 > best.r2
+            best = struct('r2', r2, 'i', i, 'j', j, 'k', k, ...
+                          'b', (sy - k * sx) / n + cy - k * cx);
+        end
+    end
+end
+
+% В. Коррекция деформации (Toe Compensation) по найденному окну
+% Линия окна пересекает ось X (Stress = 0) в x = -b/k
+if isfinite(best.r2)
+    Strain_Start_Offset = -best.b / best.k;
+    Strain_Corrected = Strain_Raw - Strain_Start_Offset;
+else
+    fprintf('Линейный участок не найден - коррекция нуля не выполнена\n');
+    Strain_Corrected = Strain_Raw;
+end
+
+% Г. Модуль упругости (Et) по ISO 527 - секущая
+% Диапазон строго: 0.05% (0.0005) ... 0.25% (0.0025) СКОРРЕКТИРОВАННОЙ деформации
+val_e1 = 0.0005; % 0.05%
+val_e2 = 0.0025; % 0.25%
 
 % Ищем индексы ближайших точек
-[~, idx1] = min(abs(Strain_Raw - val_e1));
-[~, idx2] = min(abs(Strain_Raw - val_e2));
+[~, idx1] = min(abs(Strain_Corrected - val_e1));
+[~, idx2] = min(abs(Strain_Corrected - val_e2));
 
 % ЗАЩИТА: Если точек мало и индексы совпали, раздвигаем их
 if idx2 <= idx1
     idx2 = idx1 + 5; % Берем хотя бы 5 точек разницы
 end
 % ЗАЩИТА: Проверка границ массива
-if idx2 > length(Strain_Raw), idx2 = length(Strain_Raw); end
+if idx2 > length(Strain_Corrected), idx2 = length(Strain_Corrected); end
 
 % Считаем модуль (секущая)
 d_sigma = Stress_MPa(idx2) - Stress_MPa(idx1);
-d_epsilon = Strain_Raw(idx2) - Strain_Raw(idx1);
+d_epsilon = Strain_Corrected(idx2) - Strain_Corrected(idx1);
 
 if d_epsilon == 0
     E_modulus = NaN; % Ошибка данных
@@ -67,20 +124,7 @@ else
     E_modulus = d_sigma / d_epsilon;
 end
 
-% В. Коррекция деформации (Toe Compensation)
-% Если модуль не посчитался, коррекцию делать нельзя
-if ~isnan(E_modulus)
-    % Находим, где линия модуля пересекает ось X (Strain = 0)
-    % y = E * (x - x0) + y0  -> при y=0 -> x_start = x1 - y1/E
-    Strain_Start_Offset = Strain_Raw(idx1) - (Stress_MPa(idx1) / E_modulus);
-    
-    % Вычитаем этот оффсет из всего массива
-    Strain_Corrected = Strain_Raw - Strain_Start_Offset;
-else
-    Strain_Corrected = Strain_Raw; % Без коррекции
-end
-
-% Г. Поиск Предела Текучести (Yield) и Разрыва
+% Д. Поиск Предела Текучести (Yield) и Разрыва
 % Используем findpeaks, так как у тебя есть Toolbox
 [pks, locs] = findpeaks(Stress_MPa, 'MinPeakProminence', 2.0);
 
@@ -98,11 +142,11 @@ else
     Strain_At_Yield = Strain_Corrected(idx_yield) * 100;
 end
 
-% Д. Параметры разрыва (последняя точка)
+% Е. Параметры разрыва (последняя точка)
 Break_Stress = Stress_MPa(end);
 Break_Strain = Strain_Corrected(end) * 100; % В процентах
 
-% Е. Прочность (Rm) - Максимум за весь тест
+% Ж. Прочность (Rm) - Максимум за весь тест
 Tensile_Strength = max(Stress_MPa);
 
 %% 3. ОТЧЕТ
@@ -110,6 +154,10 @@ fprintf('\n--------------------------------------\n');
 fprintf(' РЕЗУЛЬТАТЫ РАСЧЕТА (Corrected)\n');
 fprintf('--------------------------------------\n');
 fprintf('1. Модуль упругости (E)      : %.0f МПа\n', E_modulus);
+if isfinite(best.r2)
+    fprintf('   Линейный участок          : %.1f .. %.1f МПа (R^2 = %.5f)\n', ...
+            env(best.i), env(best.j), best.r2);
+end
 fprintf('2. Предел текучести (Yield)  : %.2f МПа\n', Yield_Stress);
 fprintf('   Деформация при текучести  : %.2f %%\n', Strain_At_Yield);
 fprintf('3. Прочность (Rm)            : %.2f МПа\n', Tensile_Strength);